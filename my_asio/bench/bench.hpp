@@ -0,0 +1,84 @@
+#ifndef MY_ASIO_BENCH_HPP
+#define MY_ASIO_BENCH_HPP
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace my_asio
+{
+namespace bench
+{
+
+// Collects the metrics reported by a single benchmark case
+class state
+{
+public:
+	struct metric
+	{
+		std::string name;
+		double value;
+		std::string unit;
+	};
+
+	void report(const std::string& name, double value, const std::string& unit)
+	{
+		metrics_.push_back({ name, value, unit });
+	}
+
+	// reports the median, p90, p99 and maximum of the samples as name_p50, name_p90, name_p99 and name_max
+	void report_percentiles(const std::string& name, std::vector<double> samples, const std::string& unit)
+	{
+		if (samples.empty())
+			return;
+
+		std::sort(samples.begin(), samples.end());
+		const auto at = [&samples](double fraction) { return samples[size_t(fraction * (samples.size() - 1))]; };
+
+		report(name + "_p50", at(0.50), unit);
+		report(name + "_p90", at(0.90), unit);
+		report(name + "_p99", at(0.99), unit);
+		report(name + "_max", samples.back(), unit);
+	}
+
+	const std::vector<metric>& metrics() const { return metrics_; }
+
+private:
+	std::vector<metric> metrics_;
+};
+
+using case_function = void (*)(state&);
+
+struct registered_case
+{
+	const char* name;
+	case_function function;
+};
+
+inline std::vector<registered_case>& registry()
+{
+	static std::vector<registered_case> cases;
+	return cases;
+}
+
+struct registrar
+{
+	registrar(const char* name, case_function function)
+	{
+		registry().push_back({ name, function });
+	}
+};
+
+} // namespace bench
+} // namespace my_asio
+
+#define MY_ASIO_BENCH_CONCAT_IMPL(a, b) a##b
+#define MY_ASIO_BENCH_CONCAT(a, b) MY_ASIO_BENCH_CONCAT_IMPL(a, b)
+
+// Defines and registers a benchmark case: MY_ASIO_BENCHMARK("name")(my_asio::bench::state& st) { ... }
+#define MY_ASIO_BENCHMARK(name) \
+	static void MY_ASIO_BENCH_CONCAT(bench_case_, __LINE__)(my_asio::bench::state&); \
+	static my_asio::bench::registrar MY_ASIO_BENCH_CONCAT(bench_registrar_, __LINE__)(name, &MY_ASIO_BENCH_CONCAT(bench_case_, __LINE__)); \
+	static void MY_ASIO_BENCH_CONCAT(bench_case_, __LINE__)
+
+#endif // MY_ASIO_BENCH_HPP
\ No newline at end of file
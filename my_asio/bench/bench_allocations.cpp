@@ -0,0 +1,114 @@
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <new>
+
+#include "bench.hpp"
+#include "io_context.hpp"
+#include "executor_work_guard.hpp"
+
+namespace
+{
+
+std::atomic<size_t> allocation_count(0);
+
+} // namespace
+
+// every allocation made by the bench_allocations executable is counted, the other cases live in
+// the bench executable so they do not pay for the counting
+void* operator new(std::size_t size)
+{
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace
+{
+
+constexpr int NUMBER_OF_WORKS = 100'000;
+
+// allocations per handler for posting and running NUMBER_OF_WORKS handlers produced by make_handler
+template<typename MakeHandler>
+double allocations_per_handler(MakeHandler make_handler)
+{
+	my_asio::io_context io;
+
+	const size_t before = allocation_count.load();
+	for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+		my_asio::post(io, make_handler());
+	io.run();
+
+	return double(allocation_count.load() - before) / NUMBER_OF_WORKS;
+}
+
+// same as allocations_per_handler, but handlers are run in small batches right after being posted
+template<typename MakeHandler>
+double allocations_per_handler_batched(MakeHandler make_handler)
+{
+	constexpr int BATCH_SIZE = 8;
+
+	my_asio::io_context io;
+	my_asio::executor_work_guard<my_asio::io_context::executor_type> work(io.get_executor());
+
+	const size_t before = allocation_count.load();
+	for (int i = 0; i != NUMBER_OF_WORKS / BATCH_SIZE; ++i)
+	{
+		for (int j = 0; j != BATCH_SIZE; ++j)
+			my_asio::post(io, make_handler());
+		io.poll();
+	}
+
+	return double(allocation_count.load() - before) / NUMBER_OF_WORKS;
+}
+
+} // namespace
+
+MY_ASIO_BENCHMARK("allocations/post")(my_asio::bench::state& st)
+{
+	/*
+	A handler capturing four pointers, typical for a completion handler, posted as a
+	std::function (before) and as a plain lambda type-erased by any_handler (after)
+	*/
+	int a = 0, b = 0, c = 0, d = 0;
+	auto make_lambda = [&a, &b, &c, &d]() {
+		return [pa = &a, pb = &b, pc = &c, pd = &d]() { ++*pa; ++*pb; ++*pc; ++*pd; };
+		};
+
+	st.report("std_function", allocations_per_handler([&make_lambda]() {
+		return std::function<void()>(make_lambda());
+		}), "allocs/handler");
+
+	st.report("any_handler", allocations_per_handler(make_lambda), "allocs/handler");
+}
+
+MY_ASIO_BENCHMARK("allocations/post_large_same_thread")(my_asio::bench::state& st)
+{
+	/*
+	Handlers too large for the inline buffer, posted and run by the same thread, are served
+	from the thread's recycling cache once it is warm
+	*/
+	char payload[128] = {};
+	auto make_handler = [&payload]() {
+		return [payload]() { (void)payload; };
+		};
+
+	const my_asio::recycling_allocator_stats before = my_asio::this_thread_recycling_stats();
+	st.report("operator_new", allocations_per_handler_batched(make_handler), "allocs/handler");
+	const my_asio::recycling_allocator_stats after = my_asio::this_thread_recycling_stats();
+
+	const double hits = double(after.hits - before.hits);
+	const double total = hits + double(after.misses - before.misses) + double(after.oversized - before.oversized);
+	st.report("cache_hit_rate", total ? hits / total : 0.0, "ratio");
+}
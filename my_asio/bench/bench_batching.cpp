@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "io_context.hpp"
+#include "executor_work_guard.hpp"
+
+namespace
+{
+
+constexpr int NUMBER_OF_WORKS = 400'000;
+
+// handlers per second for threads running a queue pre-filled with NUMBER_OF_WORKS handlers
+double drain_throughput(int threads, size_t batch_size)
+{
+	my_asio::io_context io;
+	io.set_batch_size(batch_size);
+	std::atomic<int> counter(0);
+
+	for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+		my_asio::post(io, [&counter]() { counter.fetch_add(1, std::memory_order_relaxed); });
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != threads; ++i)
+		workers.emplace_back([&io]() { io.run(); });
+	for (auto& t : workers)
+		t.join();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return counter / seconds;
+}
+
+// handlers per second for producer threads posting one by one or in chunks, while as many threads run
+double post_throughput(int threads, size_t chunk_size)
+{
+	my_asio::io_context io;
+	auto work = std::make_unique<my_asio::executor_work_guard<my_asio::io_context::executor_type>>(io.get_executor());
+	std::atomic<int> counter(0);
+
+	std::vector<std::thread> consumers;
+	for (int i = 0; i != threads; ++i)
+		consumers.emplace_back([&io]() { io.run(); });
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> producers;
+	for (int i = 0; i != threads; ++i)
+		producers.emplace_back([&io, &counter, threads, chunk_size]() {
+			auto handler = [&counter]() { counter.fetch_add(1, std::memory_order_relaxed); };
+			std::vector<decltype(handler)> chunk(chunk_size, handler);
+			const size_t count = size_t(NUMBER_OF_WORKS / threads);
+			for (size_t posted = 0; posted < count; )
+			{
+				const size_t n = std::min(chunk_size, count - posted);
+				if (chunk_size == 1)
+					my_asio::post(io, handler);
+				else if (n == chunk_size)
+					my_asio::post_bulk(io, chunk);
+				else
+					// the last chunk only takes what is left
+					my_asio::post_bulk(io, std::vector<decltype(handler)>(n, handler));
+				posted += n;
+			}
+			});
+
+	for (auto& t : producers)
+		t.join();
+	work.reset();
+	for (auto& t : consumers)
+		t.join();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return counter / seconds;
+}
+
+} // namespace
+
+MY_ASIO_BENCHMARK("batching/run")(my_asio::bench::state& st)
+{
+	for (int threads : { 1, 2, 4, 8, 16, 32, 64 })
+		for (size_t batch_size : { 1, 16 })
+			st.report(std::to_string(threads) + "_threads_batch_" + std::to_string(batch_size),
+				drain_throughput(threads, batch_size), "handlers/s");
+}
+
+MY_ASIO_BENCHMARK("batching/post_bulk")(my_asio::bench::state& st)
+{
+	for (int threads : { 1, 2, 4, 8, 16, 32, 64 })
+		for (size_t chunk_size : { 1, 64 })
+			st.report(std::to_string(threads) + "_threads_chunk_" + std::to_string(chunk_size),
+				post_throughput(threads, chunk_size), "handlers/s");
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "call_stack.hpp"
+#include "io_context.hpp"
+
+namespace
+{
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr int NUMBER_OF_BATCHES = 200;
+constexpr int BATCH_SIZE = 10'000;
+constexpr int MAX_DEPTH = 16;
+
+// the signal fence keeps the compiler from hoisting a lookup out of the batch, without the cost of an atomic operation
+template<typename Operation>
+std::vector<double> ns_per_operation(Operation operation)
+{
+	std::vector<double> samples;
+	samples.reserve(NUMBER_OF_BATCHES);
+
+	for (int i = 0; i != NUMBER_OF_BATCHES; ++i)
+	{
+		const auto start = clock_type::now();
+		for (int j = 0; j != BATCH_SIZE; ++j)
+		{
+			operation();
+			std::atomic_signal_fence(std::memory_order_seq_cst);
+		}
+		samples.push_back(std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / BATCH_SIZE);
+	}
+	return samples;
+}
+
+// the linked-list walk call_stack used to do, for comparison
+struct list_context
+{
+	const void* key;
+	list_context* next;
+};
+
+const void* list_contains(const list_context* top, const void* key)
+{
+	for (; top; top = top->next)
+		if (top->key == key)
+			return top;
+	return nullptr;
+}
+
+struct key_type
+{
+	char padding[64];
+};
+
+std::string depth_name(const char* name, int depth)
+{
+	return std::string(name) + "_depth_" + (depth < 10 ? "0" : "") + std::to_string(depth);
+}
+
+// nests io_contexts depth deep and times dispatch() to the outermost one from the innermost handler
+double dispatch_at_depth(int depth)
+{
+	std::vector<std::unique_ptr<my_asio::io_context>> contexts;
+	for (int i = 0; i != depth; ++i)
+		contexts.emplace_back(new my_asio::io_context());
+
+	std::atomic<long long> counter(0);
+	std::vector<double> samples;
+	const my_asio::io_context::executor_type outermost = contexts.front()->get_executor();
+
+	for (int i = depth - 1; i >= 0; --i)
+	{
+		if (i == depth - 1)
+			my_asio::post(*contexts[i], [&]() {
+				samples = ns_per_operation([&]() {
+					outermost.dispatch([&counter]() { counter.fetch_add(1, std::memory_order_relaxed); });
+					});
+				});
+		else
+			my_asio::post(*contexts[i], [&contexts, i]() { contexts[i + 1]->run(); });
+	}
+	contexts.front()->run();
+
+	std::sort(samples.begin(), samples.end());
+	return samples[samples.size() / 2];
+}
+
+} // namespace
+
+// lookups of the innermost and outermost keys, and of a key that is not on the stack
+MY_ASIO_BENCHMARK("call_stack/contains")(my_asio::bench::state& st)
+{
+	using stack_type = my_asio::detail::call_stack<key_type>;
+
+	static key_type keys[MAX_DEPTH + 1];
+	long long found = 0;
+	const auto median = [](std::vector<double> samples) {
+		std::sort(samples.begin(), samples.end());
+		return samples[samples.size() / 2];
+	};
+
+	for (int depth = 1; depth <= MAX_DEPTH; ++depth)
+	{
+		std::vector<std::unique_ptr<stack_type::context>> contexts;
+		std::vector<list_context> list(depth);
+		for (int i = 0; i != depth; ++i)
+		{
+			contexts.emplace_back(new stack_type::context(&keys[i]));
+			list[i] = { &keys[i], i ? &list[i - 1] : nullptr };
+		}
+
+		key_type* const outermost = &keys[0];
+		key_type* const innermost = &keys[depth - 1];
+		key_type* const missing = &keys[MAX_DEPTH];
+		const list_context* const top = &list[depth - 1];
+
+		st.report(depth_name("innermost", depth), median(ns_per_operation([&]() { found += stack_type::contains(innermost) != nullptr; })), "ns/op");
+		st.report(depth_name("outermost", depth), median(ns_per_operation([&]() { found += stack_type::contains(outermost) != nullptr; })), "ns/op");
+		st.report(depth_name("missing", depth), median(ns_per_operation([&]() { found += stack_type::contains(missing) != nullptr; })), "ns/op");
+		st.report(depth_name("list_walk_outermost", depth), median(ns_per_operation([&]() { found += list_contains(top, outermost) != nullptr; })), "ns/op");
+		st.report(depth_name("list_walk_missing", depth), median(ns_per_operation([&]() { found += list_contains(top, missing) != nullptr; })), "ns/op");
+
+		// innermost first, as the contexts of a thread are unwound
+		while (!contexts.empty())
+			contexts.pop_back();
+	}
+
+	st.report("found", double(found), "lookups");
+}
+
+MY_ASIO_BENCHMARK("call_stack/dispatch")(my_asio::bench::state& st)
+{
+	for (int depth = 1; depth <= MAX_DEPTH; ++depth)
+		st.report(depth_name("outermost_io_context", depth), dispatch_at_depth(depth), "ns/op");
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include "bench.hpp"
+#include "executor_work_guard.hpp"
+#include "io_context.hpp"
+
+namespace
+{
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr int NUMBER_OF_HANDLERS = 1'000'000;
+
+std::unique_ptr<my_asio::io_context> make_io(bool single_threaded)
+{
+	return std::unique_ptr<my_asio::io_context>(single_threaded ? new my_asio::io_context(1) : new my_asio::io_context());
+}
+
+// every handler posts its successor from the thread running the io_context
+double chain_handlers_per_second(bool single_threaded)
+{
+	const auto io = make_io(single_threaded);
+	int remaining = NUMBER_OF_HANDLERS;
+	std::function<void()> step = [&]() {
+		if (--remaining)
+			my_asio::post(*io, std::ref(step));
+	};
+
+	const auto start = clock_type::now();
+	my_asio::post(*io, std::ref(step));
+	io->run();
+	return NUMBER_OF_HANDLERS / std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+// another thread posts while the io_context runs
+double cross_thread_handlers_per_second(bool single_threaded)
+{
+	const auto io = make_io(single_threaded);
+	auto work = my_asio::make_work_guard(*io);
+	long long counter = 0;
+
+	const auto start = clock_type::now();
+	std::thread producer([&]() {
+		for (int i = 0; i != NUMBER_OF_HANDLERS; ++i)
+			my_asio::post(*io, [&counter]() { ++counter; });
+		my_asio::post(*io, [&work]() { work.reset(); });
+		});
+	io->run();
+	producer.join();
+	return counter / std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+} // namespace
+
+MY_ASIO_BENCHMARK("concurrency_hint/single_thread")(my_asio::bench::state& st)
+{
+	st.report("chain_default", chain_handlers_per_second(false), "handlers/s");
+	st.report("chain_hint_1", chain_handlers_per_second(true), "handlers/s");
+	st.report("cross_thread_default", cross_thread_handlers_per_second(false), "handlers/s");
+	st.report("cross_thread_hint_1", cross_thread_handlers_per_second(true), "handlers/s");
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "io_context.hpp"
+
+namespace
+{
+
+constexpr int CHAIN_LENGTH = 100'000;
+
+// every handler posts the next one of its chain until the chain is complete
+struct chain_step
+{
+	my_asio::io_context* io;
+	std::atomic<int>* counter;
+	int remaining;
+
+	void operator()() const
+	{
+		counter->fetch_add(1, std::memory_order_relaxed);
+		if (remaining == 0)
+			return;
+
+		my_asio::defer(*io, chain_step{ io, counter, remaining - 1 });
+	}
+};
+
+double chain_throughput(int chains, int threads)
+{
+	my_asio::io_context io;
+	std::atomic<int> counter(0);
+
+	for (int i = 0; i != chains; ++i)
+		my_asio::post(io, chain_step{ &io, &counter, CHAIN_LENGTH - 1 });
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != threads; ++i)
+		workers.emplace_back([&io]() { io.run(); });
+	for (auto& t : workers)
+		t.join();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return counter / seconds;
+}
+
+} // namespace
+
+MY_ASIO_BENCHMARK("continuations/chain")(my_asio::bench::state& st)
+{
+	// one chain per thread
+	for (int threads : { 1, 2, 4, 8 })
+		st.report(std::to_string(threads) + "_threads", chain_throughput(threads, threads), "handlers/s");
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "awaitable.hpp"
+
+#if defined(MY_ASIO_HAS_CO_AWAIT)
+
+#include <chrono>
+#include <string>
+
+#include "bench.hpp"
+#include "io_context.hpp"
+#include "recycling_allocator.hpp"
+#include "strand.hpp"
+
+namespace
+{
+
+constexpr int CHAIN_LENGTH = 1'000'000;
+
+using strand_type = my_asio::strand<my_asio::io_context::executor_type>;
+
+// every handler posts the next one to the executor until the chain is complete
+template<typename Executor>
+struct callback_step
+{
+	Executor* executor;
+	int remaining;
+
+	void operator()() const
+	{
+		if (remaining != 0)
+			executor->post(callback_step{ executor, remaining - 1 });
+	}
+};
+
+template<typename Executor>
+my_asio::awaitable<void> coroutine_chain(Executor& executor)
+{
+	for (int i = 0; i != CHAIN_LENGTH; ++i)
+		co_await my_asio::post(executor, my_asio::use_awaitable);
+}
+
+// a step of an asynchronous computation written with callbacks, the result is posted to the
+// continuation, dispatching it would nest every step on the stack
+template<typename Handler>
+void add_one_async(my_asio::io_context::executor_type executor, int value, Handler&& handler)
+{
+	executor.post([value, handler]() mutable { handler(value + 1); });
+}
+
+struct callback_sum
+{
+	my_asio::io_context::executor_type executor;
+	int remaining;
+
+	void operator()(int value)
+	{
+		if (remaining != 0)
+			add_one_async(executor, value, callback_sum{ executor, remaining - 1 });
+	}
+};
+
+my_asio::awaitable<int> add_one(int value)
+{
+	co_return value + 1;
+}
+
+my_asio::awaitable<void> coroutine_sum()
+{
+	int value = 0;
+	for (int i = 0; i != CHAIN_LENGTH; ++i)
+		value = co_await add_one(value);
+}
+
+template<typename Start>
+double ns_per_step(my_asio::io_context& io, Start start)
+{
+	const auto begin = std::chrono::steady_clock::now();
+	start();
+	io.run();
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / CHAIN_LENGTH;
+}
+
+} // namespace
+
+MY_ASIO_BENCHMARK("coroutines/post_chain")(my_asio::bench::state& st)
+{
+	/*
+	A chain of CHAIN_LENGTH steps that each go through the executor, once as handlers posting
+	their successor and once as a coroutine awaiting post(executor, use_awaitable)
+	*/
+	{
+		my_asio::io_context io;
+		my_asio::io_context::executor_type executor = io.get_executor();
+		st.report("callbacks_io_context", ns_per_step(io, [&]() {
+			executor.post(callback_step<my_asio::io_context::executor_type>{ &executor, CHAIN_LENGTH });
+			}), "ns/step");
+	}
+	{
+		my_asio::io_context io;
+		my_asio::io_context::executor_type executor = io.get_executor();
+		st.report("coroutine_io_context", ns_per_step(io, [&]() {
+			my_asio::co_spawn(executor, coroutine_chain(executor), my_asio::detached);
+			}), "ns/step");
+	}
+	{
+		my_asio::io_context io;
+		strand_type strand_(io.get_executor());
+		st.report("callbacks_strand", ns_per_step(io, [&]() {
+			strand_.post(callback_step<strand_type>{ &strand_, CHAIN_LENGTH });
+			}), "ns/step");
+	}
+	{
+		my_asio::io_context io;
+		strand_type strand_(io.get_executor());
+		st.report("coroutine_strand", ns_per_step(io, [&]() {
+			my_asio::co_spawn(strand_, coroutine_chain(strand_), my_asio::detached);
+			}), "ns/step");
+	}
+}
+
+MY_ASIO_BENCHMARK("coroutines/call_chain")(my_asio::bench::state& st)
+{
+	/*
+	CHAIN_LENGTH nested asynchronous steps: callbacks posting their result to the continuation,
+	against a coroutine awaiting a child awaitable, whose frame comes from the memory cache
+	*/
+	{
+		my_asio::io_context io;
+		st.report("callbacks", ns_per_step(io, [&]() {
+			my_asio::post(io, [&io]() { callback_sum{ io.get_executor(), CHAIN_LENGTH }(0); });
+			}), "ns/step");
+	}
+	{
+		my_asio::io_context io;
+		const my_asio::recycling_allocator_stats before = my_asio::this_thread_recycling_stats();
+		st.report("coroutine", ns_per_step(io, [&]() {
+			my_asio::co_spawn(io.get_executor(), coroutine_sum(), my_asio::detached);
+			}), "ns/step");
+
+		const my_asio::recycling_allocator_stats after = my_asio::this_thread_recycling_stats();
+		const size_t frames = (after.hits - before.hits) + (after.misses - before.misses) + (after.oversized - before.oversized);
+		st.report("coroutine_frames_from_cache", frames ? double(after.hits - before.hits) / frames : 0.0, "ratio");
+	}
+}
+
+#endif // defined(MY_ASIO_HAS_CO_AWAIT)
\ No newline at end of file
@@ -0,0 +1,206 @@
+#include "tcp.hpp"
+
+#if defined(MY_ASIO_HAS_EPOLL)
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "io_context.hpp"
+
+namespace
+{
+
+constexpr size_t MESSAGE_SIZE = 64;
+constexpr int MESSAGES_PER_CONNECTION = 20'000;
+
+// echoes every byte back until the client closes the connection
+class server_session
+{
+public:
+	explicit server_session(my_asio::io_context& io)
+		: socket(io)
+	{	}
+
+	void start()
+	{
+		socket.set_no_delay(true);
+		read();
+	}
+
+	my_asio::ip::tcp::socket socket;
+
+private:
+	void read()
+	{
+		socket.async_read_some(my_asio::buffer(data_), [this](const std::error_code& ec, size_t bytes) {
+			if (!ec)
+				write(0, bytes);
+			});
+	}
+
+	void write(size_t offset, size_t size)
+	{
+		socket.async_write_some(my_asio::buffer(data_ + offset, size - offset), [this, offset, size](const std::error_code& ec, size_t bytes) {
+			if (ec)
+				return;
+			if (offset + bytes == size)
+				read();
+			else
+				write(offset + bytes, size);
+			});
+	}
+
+	char data_[MESSAGE_SIZE * 4];
+};
+
+// sends one message at a time and records its round trip
+class client_session
+{
+public:
+	explicit client_session(my_asio::io_context& io)
+		: socket(io)
+		, sent_(0)
+	{
+		round_trips.reserve(MESSAGES_PER_CONNECTION);
+	}
+
+	void start()
+	{
+		socket.set_no_delay(true);
+		send();
+	}
+
+	my_asio::ip::tcp::socket socket;
+	std::vector<std::chrono::steady_clock::duration> round_trips;
+
+private:
+	void send()
+	{
+		start_ = std::chrono::steady_clock::now();
+		write(0);
+	}
+
+	void write(size_t offset)
+	{
+		socket.async_write_some(my_asio::buffer(out_ + offset, MESSAGE_SIZE - offset), [this, offset](const std::error_code& ec, size_t bytes) {
+			if (ec)
+				return;
+			if (offset + bytes == MESSAGE_SIZE)
+				read(0);
+			else
+				write(offset + bytes);
+			});
+	}
+
+	void read(size_t offset)
+	{
+		socket.async_read_some(my_asio::buffer(in_ + offset, MESSAGE_SIZE - offset), [this, offset](const std::error_code& ec, size_t bytes) {
+			if (ec)
+				return;
+			if (offset + bytes != MESSAGE_SIZE)
+			{
+				read(offset + bytes);
+				return;
+			}
+
+			round_trips.push_back(std::chrono::steady_clock::now() - start_);
+			if (++sent_ == MESSAGES_PER_CONNECTION)
+				socket.close();
+			else
+				send();
+			});
+	}
+
+	char out_[MESSAGE_SIZE] = {};
+	char in_[MESSAGE_SIZE];
+	int sent_;
+	std::chrono::steady_clock::time_point start_;
+};
+
+struct echo_result
+{
+	double messages_per_second;
+	double p50_us;
+	double p99_us;
+};
+
+echo_result loopback_echo(int connections, int threads, my_asio::io_backend backend)
+{
+	my_asio::io_context io(backend);
+	my_asio::ip::tcp::acceptor acceptor(io, my_asio::ip::tcp::endpoint("127.0.0.1", 0));
+	std::vector<std::unique_ptr<server_session>> servers;
+	std::vector<std::unique_ptr<client_session>> clients;
+
+	for (int i = 0; i != connections; ++i)
+	{
+		servers.emplace_back(new server_session(io));
+		server_session* server = servers.back().get();
+		acceptor.async_accept(server->socket, [server](const std::error_code& ec) {
+			if (!ec)
+				server->start();
+			});
+
+		clients.emplace_back(new client_session(io));
+		clients.back()->socket.connect(acceptor.local_endpoint());
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	for (auto& client : clients)
+		client->start();
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != threads; ++i)
+		workers.emplace_back([&io]() { io.run(); });
+	for (auto& t : workers)
+		t.join();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::vector<std::chrono::steady_clock::duration> round_trips;
+	for (auto& client : clients)
+		round_trips.insert(round_trips.end(), client->round_trips.begin(), client->round_trips.end());
+	std::sort(round_trips.begin(), round_trips.end());
+
+	auto percentile = [&round_trips](double p) {
+		const size_t index = std::min(round_trips.size() - 1, size_t(p * round_trips.size()));
+		return std::chrono::duration<double, std::micro>(round_trips[index]).count();
+	};
+
+	return { round_trips.size() / seconds, percentile(0.50), percentile(0.99) };
+}
+
+void report_loopback_echo(my_asio::bench::state& st, my_asio::io_backend backend)
+{
+	for (int threads : { 1, 2, 4 })
+	{
+		for (int connections : { 1, 16 })
+		{
+			const echo_result result = loopback_echo(connections, threads, backend);
+			const std::string name = std::to_string(connections) + "_conn_" + std::to_string(threads) + "_threads";
+			st.report(name, result.messages_per_second, "msg/s");
+			st.report(name + "_p50", result.p50_us, "us");
+			st.report(name + "_p99", result.p99_us, "us");
+		}
+	}
+}
+
+} // namespace
+
+MY_ASIO_BENCHMARK("tcp/loopback_echo")(my_asio::bench::state& st)
+{
+	report_loopback_echo(st, my_asio::io_backend::epoll);
+}
+
+// the same echo with the operations submitted through io_uring, or epoll where it is not available
+MY_ASIO_BENCHMARK("tcp/loopback_echo_io_uring")(my_asio::bench::state& st)
+{
+	report_loopback_echo(st, my_asio::io_backend::io_uring);
+}
+
+#endif // defined(MY_ASIO_HAS_EPOLL)
\ No newline at end of file
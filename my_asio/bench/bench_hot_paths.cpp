@@ -0,0 +1,307 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "io_context.hpp"
+#include "executor_work_guard.hpp"
+#include "strand.hpp"
+
+namespace
+{
+
+using clock_type = std::chrono::steady_clock;
+using strand_type = my_asio::strand<my_asio::io_context::executor_type>;
+using work_guard_type = my_asio::executor_work_guard<my_asio::io_context::executor_type>;
+
+constexpr int NUMBER_OF_HANDLERS = 400'000;
+constexpr int NUMBER_OF_BATCHES = 200;
+constexpr int BATCH_SIZE = 1'000;
+
+// every SAMPLE_INTERVAL-th handler measures the time from its post to its start. The producers
+// post as fast as they can, so this includes the wait behind the backlog of a saturated queue
+constexpr int SAMPLE_INTERVAL = 64;
+
+double elapsed_ns(clock_type::time_point start)
+{
+	return std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+}
+
+// operations that take a few nanoseconds are timed in batches, one sample per batch
+template<typename Operation>
+std::vector<double> ns_per_operation(Operation operation)
+{
+	std::vector<double> samples;
+	samples.reserve(NUMBER_OF_BATCHES);
+
+	for (int i = 0; i != NUMBER_OF_BATCHES; ++i)
+	{
+		const auto start = clock_type::now();
+		for (int j = 0; j != BATCH_SIZE; ++j)
+			operation();
+		samples.push_back(elapsed_ns(start) / BATCH_SIZE);
+	}
+	return samples;
+}
+
+struct throughput_result
+{
+	double handlers_per_second;
+	std::vector<double> latencies;
+};
+
+// producers post (or dispatch, which posts from outside the io_context) while consumers run the io_context
+template<typename Submit>
+throughput_result producers_consumers(int producers, int consumers, Submit submit)
+{
+	my_asio::io_context io;
+	auto work = std::make_unique<work_guard_type>(io.get_executor());
+	std::vector<double> latencies(NUMBER_OF_HANDLERS / SAMPLE_INTERVAL);
+	std::atomic<int> counter(0);
+
+	std::vector<std::thread> consumer_threads;
+	for (int i = 0; i != consumers; ++i)
+		consumer_threads.emplace_back([&io]() { io.run(); });
+
+	const auto start = clock_type::now();
+
+	std::vector<std::thread> producer_threads;
+	for (int i = 0; i != producers; ++i)
+		producer_threads.emplace_back([&, i]() {
+			const my_asio::io_context::executor_type executor = io.get_executor();
+			for (int j = i; j < NUMBER_OF_HANDLERS; j += producers)
+			{
+				double* latency = j % SAMPLE_INTERVAL == 0 ? &latencies[j / SAMPLE_INTERVAL] : nullptr;
+				const auto posted = latency ? clock_type::now() : clock_type::time_point();
+				submit(executor, [&counter, latency, posted]() {
+					if (latency)
+						*latency = elapsed_ns(posted);
+					counter.fetch_add(1, std::memory_order_relaxed);
+					});
+			}
+			});
+
+	for (auto& t : producer_threads)
+		t.join();
+	work.reset();
+	for (auto& t : consumer_threads)
+		t.join();
+
+	const double seconds = elapsed_ns(start) / 1e9;
+	return { counter / seconds, std::move(latencies) };
+}
+
+template<typename Submit>
+void report_producers_consumers(my_asio::bench::state& st, Submit submit)
+{
+	for (int producers : { 1, 2, 4 })
+		for (int consumers : { 1, 2, 4 })
+		{
+			const std::string name = std::to_string(producers) + "p_" + std::to_string(consumers) + "c";
+			throughput_result result = producers_consumers(producers, consumers, submit);
+			st.report(name, result.handlers_per_second, "handlers/s");
+			st.report_percentiles(name + "_latency", std::move(result.latencies), "ns");
+		}
+}
+
+} // namespace
+
+MY_ASIO_BENCHMARK("hot_paths/post")(my_asio::bench::state& st)
+{
+	report_producers_consumers(st, [](const my_asio::io_context::executor_type& executor, auto&& f) {
+		executor.post(std::move(f));
+		});
+}
+
+MY_ASIO_BENCHMARK("hot_paths/dispatch_outside")(my_asio::bench::state& st)
+{
+	// producers are not running the io_context, so dispatch() has to fall back to post()
+	report_producers_consumers(st, [](const my_asio::io_context::executor_type& executor, auto&& f) {
+		executor.dispatch(std::move(f));
+		});
+}
+
+MY_ASIO_BENCHMARK("hot_paths/dispatch_inside")(my_asio::bench::state& st)
+{
+	/*
+	Every thread running the io_context dispatches from inside a handler, which runs the
+	dispatched handler inline
+	*/
+	for (int threads : { 1, 2, 4 })
+	{
+		my_asio::io_context io;
+		std::vector<std::vector<double>> samples(threads);
+		std::atomic<long long> counter(0);
+
+		for (int i = 0; i != threads; ++i)
+			my_asio::post(io, [&io, &counter, &samples, i]() {
+				const my_asio::io_context::executor_type executor = io.get_executor();
+				samples[i] = ns_per_operation([&]() {
+					executor.dispatch([&counter]() { counter.fetch_add(1, std::memory_order_relaxed); });
+					});
+				});
+
+		const auto start = clock_type::now();
+		std::vector<std::thread> workers;
+		for (int i = 0; i != threads; ++i)
+			workers.emplace_back([&io]() { io.run(); });
+		for (auto& t : workers)
+			t.join();
+		const double seconds = elapsed_ns(start) / 1e9;
+
+		std::vector<double> all;
+		for (const auto& s : samples)
+			all.insert(all.end(), s.begin(), s.end());
+
+		const std::string name = std::to_string(threads) + "_threads";
+		st.report(name, counter / seconds, "handlers/s");
+		st.report_percentiles(name + "_dispatch", std::move(all), "ns/op");
+	}
+}
+
+namespace
+{
+
+constexpr int NUMBER_OF_ROUND_TRIPS = 100'000;
+
+// bounces between two strands, each arrival on the first strand completes a round trip
+struct ping_pong
+{
+	strand_type* ping;
+	strand_type* pong;
+	std::vector<double>* round_trips;
+	clock_type::time_point sent;
+	int remaining;
+
+	void operator()() const
+	{
+		(*round_trips)[remaining] = elapsed_ns(sent);
+		if (remaining == 0)
+			return;
+
+		const ping_pong self = *this;
+		my_asio::post(*pong, [self]() {
+			my_asio::post(*self.ping, ping_pong{ self.ping, self.pong, self.round_trips, clock_type::now(), self.remaining - 1 });
+			});
+	}
+};
+
+} // namespace
+
+MY_ASIO_BENCHMARK("hot_paths/strand_ping_pong")(my_asio::bench::state& st)
+{
+	for (int threads : { 1, 2, 4 })
+	{
+		my_asio::io_context io;
+		strand_type ping(io.get_executor());
+		strand_type pong(io.get_executor());
+		std::vector<double> round_trips(NUMBER_OF_ROUND_TRIPS + 1);
+
+		my_asio::post(ping, ping_pong{ &ping, &pong, &round_trips, clock_type::now(), NUMBER_OF_ROUND_TRIPS });
+
+		const auto start = clock_type::now();
+		std::vector<std::thread> workers;
+		for (int i = 0; i != threads; ++i)
+			workers.emplace_back([&io]() { io.run(); });
+		for (auto& t : workers)
+			t.join();
+		const double seconds = elapsed_ns(start) / 1e9;
+
+		const std::string name = std::to_string(threads) + "_threads";
+		st.report(name, NUMBER_OF_ROUND_TRIPS / seconds, "round_trips/s");
+		st.report_percentiles(name + "_round_trip", std::move(round_trips), "ns");
+	}
+}
+
+MY_ASIO_BENCHMARK("hot_paths/poll_vs_run")(my_asio::bench::state& st)
+{
+	/*
+	The same number of queued handlers drained on the calling thread by poll() and by run(),
+	one sample per drain
+	*/
+	constexpr int NUMBER_OF_DRAINS = 100;
+	constexpr int HANDLERS_PER_DRAIN = 10'000;
+
+	my_asio::io_context io;
+	int counter = 0;
+	std::vector<double> poll_samples;
+	std::vector<double> run_samples;
+
+	for (int i = 0; i != NUMBER_OF_DRAINS; ++i)
+	{
+		for (std::vector<double>* samples : { &poll_samples, &run_samples })
+		{
+			for (int j = 0; j != HANDLERS_PER_DRAIN; ++j)
+				my_asio::post(io, [&counter]() { ++counter; });
+
+			io.restart();
+			const auto start = clock_type::now();
+			if (samples == &poll_samples)
+				io.poll();
+			else
+				io.run();
+			samples->push_back(elapsed_ns(start) / HANDLERS_PER_DRAIN);
+		}
+	}
+
+	st.report_percentiles("poll", std::move(poll_samples), "ns/handler");
+	st.report_percentiles("run", std::move(run_samples), "ns/handler");
+}
+
+MY_ASIO_BENCHMARK("hot_paths/work_guard_churn")(my_asio::bench::state& st)
+{
+	// threads create and destroy work guards on the same io_context, each one counts work in and out
+	for (int threads : { 1, 2, 4 })
+	{
+		my_asio::io_context io;
+		std::vector<std::vector<double>> samples(threads);
+		std::atomic<int> ready(0);
+
+		std::vector<std::thread> churners;
+		for (int i = 0; i != threads; ++i)
+			churners.emplace_back([&, i]() {
+				const my_asio::io_context::executor_type executor = io.get_executor();
+				ready.fetch_add(1);
+				while (ready.load() != threads)
+					;
+				samples[i] = ns_per_operation([&executor]() { work_guard_type guard(executor); });
+				});
+
+		const auto start = clock_type::now();
+		for (auto& t : churners)
+			t.join();
+		const double seconds = elapsed_ns(start) / 1e9;
+
+		std::vector<double> all;
+		for (const auto& s : samples)
+			all.insert(all.end(), s.begin(), s.end());
+
+		const std::string name = std::to_string(threads) + "_threads";
+		st.report(name, double(threads) * NUMBER_OF_BATCHES * BATCH_SIZE / seconds, "guards/s");
+		st.report_percentiles(name + "_guard", std::move(all), "ns/op");
+	}
+}
+
+MY_ASIO_BENCHMARK("hot_paths/running_in_this_thread")(my_asio::bench::state& st)
+{
+	my_asio::io_context io;
+	const my_asio::io_context::executor_type executor = io.get_executor();
+	strand_type strand_(io.get_executor());
+	std::atomic<int> found(0);
+
+	const auto lookup = [&found](bool running) { found.fetch_add(running, std::memory_order_relaxed); };
+
+	st.report_percentiles("io_outside", ns_per_operation([&]() { lookup(executor.running_in_this_thread()); }), "ns/op");
+	st.report_percentiles("strand_outside", ns_per_operation([&]() { lookup(strand_.running_in_this_thread()); }), "ns/op");
+
+	my_asio::post(strand_, [&]() {
+		st.report_percentiles("io_inside", ns_per_operation([&]() { lookup(executor.running_in_this_thread()); }), "ns/op");
+		st.report_percentiles("strand_inside", ns_per_operation([&]() { lookup(strand_.running_in_this_thread()); }), "ns/op");
+		});
+	io.run();
+
+	st.report("found", found, "lookups");
+}
\ No newline at end of file
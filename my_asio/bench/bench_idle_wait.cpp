@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "io_context.hpp"
+#include "executor_work_guard.hpp"
+
+namespace
+{
+
+using clock_type = std::chrono::steady_clock;
+
+} // namespace
+
+MY_ASIO_BENCHMARK("idle_wait/idle_cpu")(my_asio::bench::state& st)
+{
+	/*
+	Worker threads run() with outstanding work but no handlers, the process CPU time
+	consumed over the window shows how many cores the idle workers keep busy
+	*/
+	constexpr int NUMBER_OF_WORKERS = 4;
+	constexpr auto WINDOW = std::chrono::milliseconds(500);
+
+	my_asio::io_context io;
+	auto work = std::make_unique<my_asio::executor_work_guard<my_asio::io_context::executor_type>>(io.get_executor());
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != NUMBER_OF_WORKERS; ++i)
+		workers.emplace_back([&io]() { io.run(); });
+
+	// let the workers get past their initial spin
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+	const std::clock_t cpu_start = std::clock();
+	const auto wall_start = clock_type::now();
+	std::this_thread::sleep_for(WINDOW);
+	const std::clock_t cpu_end = std::clock();
+	const auto wall_end = clock_type::now();
+
+	work.reset();
+	for (auto& t : workers)
+		t.join();
+
+	const double cpu_seconds = double(cpu_end - cpu_start) / CLOCKS_PER_SEC;
+	const double wall_seconds = std::chrono::duration<double>(wall_end - wall_start).count();
+
+	st.report("workers", NUMBER_OF_WORKERS, "threads");
+	st.report("idle_cpu", cpu_seconds / wall_seconds, "cores");
+}
+
+MY_ASIO_BENCHMARK("idle_wait/wakeup_latency")(my_asio::bench::state& st)
+{
+	/*
+	A parked worker is woken by post(), the latency is measured from the post() call
+	to the start of the handler
+	*/
+	constexpr int NUMBER_OF_SAMPLES = 200;
+
+	my_asio::io_context io;
+	auto work = std::make_unique<my_asio::executor_work_guard<my_asio::io_context::executor_type>>(io.get_executor());
+	std::thread worker([&io]() { io.run(); });
+
+	std::vector<double> samples;
+	samples.reserve(NUMBER_OF_SAMPLES);
+
+	for (int i = 0; i != NUMBER_OF_SAMPLES; ++i)
+	{
+		// give the worker time to exhaust its spin and park
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+		std::atomic<bool> done(false);
+		clock_type::time_point started;
+		const auto posted = clock_type::now();
+		my_asio::post(io, [&done, &started]() {
+			started = clock_type::now();
+			done = true;
+			});
+
+		while (!done)
+			std::this_thread::yield();
+
+		samples.push_back(std::chrono::duration<double, std::micro>(started - posted).count());
+	}
+
+	work.reset();
+	worker.join();
+
+	std::sort(samples.begin(), samples.end());
+	st.report("p50", samples[samples.size() / 2], "us");
+	st.report("p99", samples[samples.size() * 99 / 100], "us");
+	st.report("max", samples.back(), "us");
+}
\ No newline at end of file
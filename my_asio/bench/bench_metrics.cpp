@@ -0,0 +1,79 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "io_context.hpp"
+#include "strand.hpp"
+
+namespace
+{
+
+constexpr int NUMBER_OF_WORKS = 1'000'000;
+constexpr int NUMBER_OF_WORKERS = 4;
+
+// every handler posts its successor, NUMBER_OF_WORKERS chains run side by side
+struct chain_step
+{
+	my_asio::io_context* io;
+	int remaining;
+
+	void operator()() const
+	{
+		if (remaining != 0)
+			my_asio::post(*io, chain_step{ io, remaining - 1 });
+	}
+};
+
+double chain_ns_per_handler(unsigned sample_interval)
+{
+	my_asio::io_context io;
+	if (sample_interval)
+		io.enable_metrics(sample_interval);
+
+	for (int i = 0; i != NUMBER_OF_WORKERS; ++i)
+		my_asio::post(io, chain_step{ &io, NUMBER_OF_WORKS / NUMBER_OF_WORKERS });
+
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (int i = 0; i != NUMBER_OF_WORKERS; ++i)
+		workers.emplace_back([&io]() { io.run(); });
+	for (auto& t : workers)
+		t.join();
+
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / NUMBER_OF_WORKS;
+}
+
+double strand_ns_per_handler(unsigned sample_interval)
+{
+	my_asio::io_context io;
+	my_asio::strand<my_asio::io_context::executor_type> strand_(io.get_executor());
+	if (sample_interval)
+		strand_.enable_metrics(sample_interval);
+
+	int counter = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+		my_asio::post(strand_, [&counter]() { ++counter; });
+	io.run();
+
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / NUMBER_OF_WORKS;
+}
+
+} // namespace
+
+MY_ASIO_BENCHMARK("metrics/overhead")(my_asio::bench::state& st)
+{
+	/*
+	Cost of the metrics on the io_context and strand hot paths: off, on with the default
+	sampling, and on with every handler timed
+	*/
+	st.report("io_context_off", chain_ns_per_handler(0), "ns/handler");
+	st.report("io_context_sampled_64", chain_ns_per_handler(64), "ns/handler");
+	st.report("io_context_sampled_1", chain_ns_per_handler(1), "ns/handler");
+
+	st.report("strand_off", strand_ns_per_handler(0), "ns/handler");
+	st.report("strand_sampled_64", strand_ns_per_handler(64), "ns/handler");
+	st.report("strand_sampled_1", strand_ns_per_handler(1), "ns/handler");
+}
\ No newline at end of file
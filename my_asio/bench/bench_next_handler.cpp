@@ -0,0 +1,64 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "io_context.hpp"
+
+namespace
+{
+
+constexpr int NUMBER_OF_PIPELINES = 16;
+constexpr int PIPELINE_LENGTH = 20'000;
+constexpr int NUMBER_OF_THREADS = 4;
+constexpr size_t PAYLOAD_SIZE = 4096;
+
+// every stage works on the pipeline's payload and defers the next stage
+struct stage
+{
+	my_asio::io_context* io;
+	std::vector<unsigned char>* payload;
+	std::atomic<long long>* checksum;
+	int remaining;
+
+	void operator()() const
+	{
+		unsigned sum = 0;
+		for (unsigned char& b : *payload)
+			sum += ++b;
+		checksum->fetch_add(sum, std::memory_order_relaxed);
+
+		if (remaining)
+			my_asio::defer(*io, stage{ io, payload, checksum, remaining - 1 });
+	}
+};
+
+double stages_per_second(unsigned next_handler_limit)
+{
+	my_asio::io_context io;
+	io.set_next_handler_limit(next_handler_limit);
+	std::vector<std::vector<unsigned char>> payloads(NUMBER_OF_PIPELINES, std::vector<unsigned char>(PAYLOAD_SIZE));
+	std::atomic<long long> checksum(0);
+
+	for (auto& payload : payloads)
+		my_asio::post(io, stage{ &io, &payload, &checksum, PIPELINE_LENGTH });
+
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (int i = 0; i != NUMBER_OF_THREADS; ++i)
+		threads.emplace_back([&io]() { io.run(); });
+	for (auto& t : threads)
+		t.join();
+
+	return double(NUMBER_OF_PIPELINES) * (PIPELINE_LENGTH + 1) / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+MY_ASIO_BENCHMARK("next_handler/pipelines")(my_asio::bench::state& st)
+{
+	st.report("slot_off", stages_per_second(0), "stages/s");
+	st.report("slot_limit_8", stages_per_second(8), "stages/s");
+	st.report("slot_limit_64", stages_per_second(64), "stages/s");
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include <chrono>
+#include <vector>
+
+#include "bench.hpp"
+#include "priority_executor.hpp"
+
+namespace
+{
+
+constexpr int NUMBER_OF_BULK_HANDLERS = 100'000;
+constexpr int NUMBER_OF_CONTROL_HANDLERS = 1'000;
+
+// a control handler is queued after every 100 bulk handlers, its latency is the time from the start
+// of the run until it runs
+std::vector<double> control_latencies(const my_asio::priority_executor& control)
+{
+	my_asio::io_context& io = control.context();
+	std::vector<double> samples;
+	samples.reserve(NUMBER_OF_CONTROL_HANDLERS);
+	std::chrono::steady_clock::time_point start;
+
+	for (int i = 0; i != NUMBER_OF_BULK_HANDLERS; ++i)
+	{
+		my_asio::post(io, []() {});
+		if (i % (NUMBER_OF_BULK_HANDLERS / NUMBER_OF_CONTROL_HANDLERS) == 0)
+		{
+			my_asio::post(control, [&samples, &start]() {
+				samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+				});
+		}
+	}
+
+	start = std::chrono::steady_clock::now();
+	io.run();
+	return samples;
+}
+
+} // namespace
+
+MY_ASIO_BENCHMARK("priority/control_latency")(my_asio::bench::state& st)
+{
+	{
+		my_asio::io_context io;
+		st.report_percentiles("normal", control_latencies(my_asio::make_priority_executor(io, my_asio::handler_priority::normal)), "us");
+	}
+	{
+		my_asio::io_context io;
+		st.report_percentiles("high", control_latencies(my_asio::make_priority_executor(io, my_asio::handler_priority::high)), "us");
+	}
+}
\ No newline at end of file
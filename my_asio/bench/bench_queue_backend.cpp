@@ -0,0 +1,64 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "io_context.hpp"
+#include "executor_work_guard.hpp"
+
+namespace
+{
+
+// handlers per second with the given number of posting and running threads
+double producer_consumer_throughput(my_asio::queue_backend backend, int producers, int consumers)
+{
+	constexpr int NUMBER_OF_WORKS = 400'000;
+
+	my_asio::io_context io(backend);
+	auto work = std::make_unique<my_asio::executor_work_guard<my_asio::io_context::executor_type>>(io.get_executor());
+	std::atomic<int> counter(0);
+
+	std::vector<std::thread> consumer_threads;
+	for (int i = 0; i != consumers; ++i)
+		consumer_threads.emplace_back([&io]() { io.run(); });
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> producer_threads;
+	for (int i = 0; i != producers; ++i)
+		producer_threads.emplace_back([&io, &counter, producers]() {
+			for (int j = 0; j != NUMBER_OF_WORKS / producers; ++j)
+				my_asio::post(io, [&counter]() { counter.fetch_add(1, std::memory_order_relaxed); });
+			});
+
+	for (auto& t : producer_threads)
+		t.join();
+	work.reset();
+	for (auto& t : consumer_threads)
+		t.join();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return counter / seconds;
+}
+
+void report_scaling(my_asio::bench::state& st, my_asio::queue_backend backend)
+{
+	for (int threads : { 1, 2, 4, 8 })
+		st.report(std::to_string(threads) + "p_" + std::to_string(threads) + "c",
+			producer_consumer_throughput(backend, threads, threads), "handlers/s");
+}
+
+} // namespace
+
+MY_ASIO_BENCHMARK("queue_backend/mutex")(my_asio::bench::state& st)
+{
+	report_scaling(st, my_asio::queue_backend::mutex);
+}
+
+MY_ASIO_BENCHMARK("queue_backend/lock_free")(my_asio::bench::state& st)
+{
+	report_scaling(st, my_asio::queue_backend::lock_free);
+}
\ No newline at end of file
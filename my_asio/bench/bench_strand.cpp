@@ -0,0 +1,124 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "io_context.hpp"
+#include "executor_work_guard.hpp"
+#include "strand.hpp"
+
+namespace
+{
+
+constexpr int NUMBER_OF_WORKS = 200'000;
+constexpr int NUMBER_OF_WORKERS = 4;
+
+struct contention_result
+{
+	double handlers_per_second;
+	double post_ns;
+};
+
+// many producers feed one strand while NUMBER_OF_WORKERS threads run the io_context
+contention_result strand_contention(int producers)
+{
+	my_asio::io_context io;
+	my_asio::strand<my_asio::io_context::executor_type> strand_(io.get_executor());
+	auto work = std::make_unique<my_asio::executor_work_guard<my_asio::io_context::executor_type>>(io.get_executor());
+	std::atomic<long long> post_time(0);
+	int counter(0);
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != NUMBER_OF_WORKERS; ++i)
+		workers.emplace_back([&io]() { io.run(); });
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> producer_threads;
+	for (int i = 0; i != producers; ++i)
+		producer_threads.emplace_back([&strand_, &counter, &post_time, producers]() {
+			const auto posting = std::chrono::steady_clock::now();
+			for (int j = 0; j != NUMBER_OF_WORKS / producers; ++j)
+				my_asio::post(strand_, [&counter]() { ++counter; });
+			post_time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - posting).count();
+			});
+
+	for (auto& t : producer_threads)
+		t.join();
+	work.reset();
+	for (auto& t : workers)
+		t.join();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return { counter / seconds, double(post_time) / NUMBER_OF_WORKS };
+}
+
+} // namespace
+
+MY_ASIO_BENCHMARK("strand/contention")(my_asio::bench::state& st)
+{
+	for (int producers : { 1, 2, 4, 8, 16 })
+	{
+		const contention_result result = strand_contention(producers);
+		st.report(std::to_string(producers) + "_producers", result.handlers_per_second, "handlers/s");
+		st.report(std::to_string(producers) + "_producers_post", result.post_ns, "ns/post");
+	}
+}
+
+namespace
+{
+
+struct budget_result
+{
+	double handlers_per_second;
+	double handlers_per_turn;
+};
+
+// one strand shares NUMBER_OF_WORKERS threads with the same amount of plain io_context work
+budget_result strand_turn_budget(size_t max_handlers, std::chrono::microseconds max_time)
+{
+	my_asio::io_context io;
+	my_asio::strand<my_asio::io_context::executor_type> strand_(io.get_executor());
+	strand_.set_turn_budget(max_handlers, max_time);
+	std::atomic<int> plain_counter(0);
+	int counter(0);
+
+	for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+	{
+		my_asio::post(strand_, [&counter]() { ++counter; });
+		my_asio::post(io, [&plain_counter]() { ++plain_counter; });
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != NUMBER_OF_WORKERS; ++i)
+		workers.emplace_back([&io]() { io.run(); });
+	for (auto& t : workers)
+		t.join();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return { counter / seconds, strand_.stats().handlers_per_turn() };
+}
+
+} // namespace
+
+MY_ASIO_BENCHMARK("strand/turn_budget")(my_asio::bench::state& st)
+{
+	for (size_t max_handlers : { 1, 4, 16, 64, 256 })
+	{
+		const budget_result result = strand_turn_budget(max_handlers, std::chrono::microseconds(0));
+		st.report(std::to_string(max_handlers) + "_handlers", result.handlers_per_second, "handlers/s");
+		st.report(std::to_string(max_handlers) + "_handlers_per_turn", result.handlers_per_turn, "handlers/turn");
+	}
+
+	for (long long max_time : { 10, 100 })
+	{
+		const budget_result result = strand_turn_budget(size_t(-1), std::chrono::microseconds(max_time));
+		st.report(std::to_string(max_time) + "us", result.handlers_per_second, "handlers/s");
+		st.report(std::to_string(max_time) + "us_per_turn", result.handlers_per_turn, "handlers/turn");
+	}
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "io_context.hpp"
+#include "strand_pool.hpp"
+
+namespace
+{
+
+using executor_type = my_asio::io_context::executor_type;
+
+constexpr size_t NUMBER_OF_STRANDS = 1'000'000;
+constexpr int HANDLERS_PER_STRAND = 4;
+constexpr int NUMBER_OF_THREADS = 4;
+
+// posts HANDLERS_PER_STRAND handlers to every strand, then runs them
+template<typename Strands>
+double handlers_per_second(my_asio::io_context& io, Strands& strands)
+{
+	std::atomic<long long> count(0);
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i != HANDLERS_PER_STRAND; ++i)
+		for (auto& s : strands)
+			my_asio::post(s, [&count]() { count.fetch_add(1, std::memory_order_relaxed); });
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i != NUMBER_OF_THREADS; ++i)
+		threads.emplace_back([&io]() { io.run(); });
+	for (auto& t : threads)
+		t.join();
+
+	return double(count.load()) / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+MY_ASIO_BENCHMARK("strand_pool/million_strands")(my_asio::bench::state& st)
+{
+	{
+		my_asio::io_context io;
+		std::vector<my_asio::strand<executor_type>> strands;
+		strands.reserve(NUMBER_OF_STRANDS);
+		for (size_t i = 0; i != NUMBER_OF_STRANDS; ++i)
+			strands.emplace_back(io.get_executor());
+
+		st.report("strands_bytes_per_strand", double(sizeof(my_asio::strand<executor_type>)), "B");
+		st.report("strands_throughput", handlers_per_second(io, strands), "handlers/s");
+	}
+
+	{
+		my_asio::io_context io;
+		my_asio::strand_pool<executor_type> pool(io.get_executor());
+		std::vector<my_asio::pooled_strand<executor_type>> strands;
+		strands.reserve(NUMBER_OF_STRANDS);
+		for (size_t i = 0; i != NUMBER_OF_STRANDS; ++i)
+			strands.push_back(pool.make_strand());
+
+		st.report("pooled_bytes_per_strand", sizeof(my_asio::pooled_strand<executor_type>)
+			+ double(pool.size() * sizeof(my_asio::strand<executor_type>)) / NUMBER_OF_STRANDS, "B");
+		st.report("pooled_throughput", handlers_per_second(io, strands), "handlers/s");
+	}
+}
\ No newline at end of file
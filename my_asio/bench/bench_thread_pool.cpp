@@ -0,0 +1,50 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "bench.hpp"
+#include "thread_pool.hpp"
+
+namespace
+{
+
+constexpr int NUMBER_OF_CHAINS = 64;
+constexpr int CHAIN_LENGTH = 10'000;
+constexpr size_t NUMBER_OF_WORKERS = 4;
+
+// every handler posts its successor, so a chain's handlers are allocated and freed by the workers
+struct chain_step
+{
+	my_asio::thread_pool* pool;
+	std::atomic<long long>* counter;
+	int remaining;
+
+	void operator()() const
+	{
+		counter->fetch_add(1, std::memory_order_relaxed);
+		if (remaining != 0)
+			my_asio::post(pool->get_executor(), chain_step{ pool, counter, remaining - 1 });
+	}
+};
+
+double handlers_per_second(my_asio::thread_affinity affinity)
+{
+	my_asio::thread_pool pool(NUMBER_OF_WORKERS, affinity);
+	std::atomic<long long> counter(0);
+
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i != NUMBER_OF_CHAINS; ++i)
+		my_asio::post(pool.get_executor(), chain_step{ &pool, &counter, CHAIN_LENGTH });
+	pool.join();
+
+	return counter / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+MY_ASIO_BENCHMARK("thread_pool/chains")(my_asio::bench::state& st)
+{
+	st.report("affinity_none", handlers_per_second(my_asio::thread_affinity::none), "handlers/s");
+	st.report("affinity_core", handlers_per_second(my_asio::thread_affinity::core), "handlers/s");
+	st.report("affinity_numa_node", handlers_per_second(my_asio::thread_affinity::numa_node), "handlers/s");
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include <chrono>
+#include <memory>
+#include <random>
+#include <system_error>
+#include <vector>
+
+#include "bench.hpp"
+#include "io_context.hpp"
+#include "executor_work_guard.hpp"
+#include "steady_timer.hpp"
+
+namespace
+{
+
+constexpr int NUMBER_OF_OPERATIONS = 10'000'000;
+constexpr int NUMBER_OF_TIMERS = 100'000;
+constexpr int NUMBER_OF_WAKEUPS = 200;
+
+} // namespace
+
+// connection timeouts: most timers are armed far in the future and cancelled before they expire
+MY_ASIO_BENCHMARK("timer/arm_cancel")(my_asio::bench::state& st)
+{
+	my_asio::io_context io;
+	auto work = my_asio::make_work_guard(io);
+	std::vector<std::unique_ptr<my_asio::steady_timer>> timers;
+	for (int i = 0; i != NUMBER_OF_TIMERS; ++i)
+		timers.emplace_back(new my_asio::steady_timer(io));
+
+	std::mt19937 random(1);
+	std::uniform_int_distribution<int> timeout_ms(1'000, 60'000);
+	int cancelled(0);
+
+	std::chrono::steady_clock::duration arm_time(0);
+	std::chrono::steady_clock::duration cancel_time(0);
+
+	for (int round = 0; round != NUMBER_OF_OPERATIONS / NUMBER_OF_TIMERS; ++round)
+	{
+		const auto arming = std::chrono::steady_clock::now();
+		for (auto& timer : timers)
+		{
+			timer->expires_after(std::chrono::milliseconds(timeout_ms(random)));
+			timer->async_wait([&cancelled](const std::error_code& ec) {
+				if (ec)
+					++cancelled;
+				});
+		}
+
+		const auto cancelling = std::chrono::steady_clock::now();
+		for (auto& timer : timers)
+			timer->cancel();
+		io.poll();
+
+		arm_time += cancelling - arming;
+		cancel_time += std::chrono::steady_clock::now() - cancelling;
+	}
+
+	const double operations = double(NUMBER_OF_OPERATIONS / NUMBER_OF_TIMERS) * NUMBER_OF_TIMERS;
+	st.report("arm", std::chrono::duration<double, std::nano>(arm_time).count() / operations, "ns/timer");
+	st.report("cancel_and_complete", std::chrono::duration<double, std::nano>(cancel_time).count() / operations, "ns/timer");
+	st.report("cancelled", cancelled, "handlers");
+}
+
+// how late a parked run() wakes up for an expiring timer
+MY_ASIO_BENCHMARK("timer/wakeup_latency")(my_asio::bench::state& st)
+{
+	my_asio::io_context io;
+	my_asio::steady_timer timer(io);
+	std::chrono::steady_clock::duration lateness(0);
+
+	for (int i = 0; i != NUMBER_OF_WAKEUPS; ++i)
+	{
+		timer.expires_after(std::chrono::microseconds(500));
+		timer.async_wait([&lateness, &timer](const std::error_code&) {
+			lateness += std::chrono::steady_clock::now() - timer.expiry();
+			});
+		io.restart();
+		io.run();
+	}
+
+	st.report("mean_lateness", std::chrono::duration<double, std::micro>(lateness).count() / NUMBER_OF_WAKEUPS, "us");
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "executor_work_guard.hpp"
+#include "io_context.hpp"
+
+namespace
+{
+
+using clock_type = std::chrono::steady_clock;
+using work_guard_type = my_asio::executor_work_guard<my_asio::io_context::executor_type>;
+
+constexpr int NUMBER_OF_BATCHES = 100;
+constexpr int BATCH_SIZE = 10'000;
+
+template<typename Operation>
+std::vector<double> ns_per_operation(Operation operation)
+{
+	std::vector<double> samples;
+	samples.reserve(NUMBER_OF_BATCHES);
+
+	for (int i = 0; i != NUMBER_OF_BATCHES; ++i)
+	{
+		const auto start = clock_type::now();
+		for (int j = 0; j != BATCH_SIZE; ++j)
+			operation();
+		samples.push_back(std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / BATCH_SIZE);
+	}
+	return samples;
+}
+
+// every thread runs one handler that performs operation in batches, the work it counts is settled with the thread's credits
+template<typename Operation>
+std::vector<double> inside_handlers(int threads, Operation operation)
+{
+	my_asio::io_context io;
+	std::vector<std::vector<double>> samples(threads);
+	std::atomic<int> ready(0);
+
+	for (int i = 0; i != threads; ++i)
+		my_asio::post(io, [&, i]() {
+			ready.fetch_add(1);
+			while (ready.load() != threads)
+				std::this_thread::yield();
+			samples[i] = ns_per_operation([&]() { operation(io); });
+			});
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != threads; ++i)
+		workers.emplace_back([&io]() { io.run(); });
+	for (auto& t : workers)
+		t.join();
+
+	std::vector<double> all;
+	for (const auto& s : samples)
+		all.insert(all.end(), s.begin(), s.end());
+	return all;
+}
+
+} // namespace
+
+MY_ASIO_BENCHMARK("work_accounting/inside_handlers")(my_asio::bench::state& st)
+{
+	for (int threads : { 1, 2, 4 })
+	{
+		const std::string name = std::to_string(threads) + "_threads";
+
+		st.report_percentiles(name + "_guard", inside_handlers(threads, [](my_asio::io_context& io) {
+			work_guard_type guard(io.get_executor());
+			}), "ns/op");
+
+		// the posted handlers are run by the other threads while the batch goes on
+		st.report_percentiles(name + "_post", inside_handlers(threads, [](my_asio::io_context& io) {
+			my_asio::post(io, []() {});
+			}), "ns/op");
+	}
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "io_context.hpp"
+
+namespace
+{
+
+// handlers per second for a workload where every root handler posts a batch of children
+double fan_out_throughput(my_asio::scheduler_mode mode, int threads)
+{
+	constexpr int NUMBER_OF_ROOTS = 200;
+	constexpr int NUMBER_OF_CHILDREN = 2000;
+
+	my_asio::io_context io(mode);
+	std::atomic<int> counter(0);
+
+	for (int i = 0; i != NUMBER_OF_ROOTS; ++i)
+		my_asio::post(io, [&io, &counter]() {
+			for (int j = 0; j != NUMBER_OF_CHILDREN; ++j)
+				my_asio::post(io, [&counter]() { counter.fetch_add(1, std::memory_order_relaxed); });
+			});
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != threads; ++i)
+		workers.emplace_back([&io]() { io.run(); });
+	for (auto& t : workers)
+		t.join();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return (NUMBER_OF_ROOTS + counter) / seconds;
+}
+
+void report_scaling(my_asio::bench::state& st, my_asio::scheduler_mode mode)
+{
+	for (int threads : { 1, 2, 4, 8 })
+		st.report(std::to_string(threads) + "_threads", fan_out_throughput(mode, threads), "handlers/s");
+}
+
+} // namespace
+
+MY_ASIO_BENCHMARK("fan_out/shared_queue")(my_asio::bench::state& st)
+{
+	report_scaling(st, my_asio::scheduler_mode::shared_queue);
+}
+
+MY_ASIO_BENCHMARK("fan_out/work_stealing")(my_asio::bench::state& st)
+{
+	report_scaling(st, my_asio::scheduler_mode::work_stealing);
+}
\ No newline at end of file
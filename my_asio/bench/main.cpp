@@ -0,0 +1,106 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "bench.hpp"
+
+namespace
+{
+
+enum class output_format
+{
+	text,
+	csv,
+	json
+};
+
+// metric names and units are plain identifiers, only quotes and backslashes need escaping
+std::string json_string(const std::string& s)
+{
+	std::string quoted("\"");
+	for (char c : s)
+	{
+		if (c == '"' || c == '\\')
+			quoted += '\\';
+		quoted += c;
+	}
+	return quoted + '"';
+}
+
+// JSON has no representation of infinity or NaN
+std::string json_number(double value)
+{
+	if (!std::isfinite(value))
+		return "null";
+
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%.6g", value);
+	return buffer;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	// an optional argument selects the cases whose name contains it,
+	// --format=csv or --format=json prints one record per metric for comparing runs
+	const char* filter = "";
+	output_format format = output_format::text;
+
+	for (int i = 1; i != argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--format=text") == 0)
+			format = output_format::text;
+		else if (std::strcmp(argv[i], "--format=csv") == 0)
+			format = output_format::csv;
+		else if (std::strcmp(argv[i], "--format=json") == 0)
+			format = output_format::json;
+		else if (std::strncmp(argv[i], "--", 2) == 0)
+		{
+			std::fprintf(stderr, "usage: %s [--format=text|csv|json] [filter]\n", argv[0]);
+			return 1;
+		}
+		else
+			filter = argv[i];
+	}
+
+	if (format == output_format::csv)
+		std::printf("case,metric,value,unit\n");
+	else if (format == output_format::json)
+		std::printf("[");
+
+	bool first = true;
+	for (const auto& c : my_asio::bench::registry())
+	{
+		if (std::strstr(c.name, filter) == nullptr)
+			continue;
+
+		my_asio::bench::state st;
+		c.function(st);
+
+		for (const auto& m : st.metrics())
+		{
+			switch (format)
+			{
+			case output_format::text:
+				std::printf("%-40s %-28s %16.3f %s\n", c.name, m.name.c_str(), m.value, m.unit.c_str());
+				break;
+			case output_format::csv:
+				std::printf("%s,%s,%.6g,%s\n", c.name, m.name.c_str(), m.value, m.unit.c_str());
+				break;
+			case output_format::json:
+				std::printf("%s\n  {\"case\": %s, \"metric\": %s, \"value\": %s, \"unit\": %s}", first ? "" : ",",
+					json_string(c.name).c_str(), json_string(m.name).c_str(), json_number(m.value).c_str(), json_string(m.unit).c_str());
+				break;
+			}
+			first = false;
+		}
+		std::fflush(stdout);
+	}
+
+	if (format == output_format::json)
+		std::printf("\n]\n");
+
+	return 0;
+}
\ No newline at end of file
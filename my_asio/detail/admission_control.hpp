@@ -0,0 +1,317 @@
+#ifndef MY_ASIO_DETAIL_ADMISSION_CONTROL_HPP
+#define MY_ASIO_DETAIL_ADMISSION_CONTROL_HPP
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <utility>
+
+#include "any_handler.hpp"
+#include "queue_limits.hpp"
+
+namespace my_asio
+{
+namespace detail
+{
+
+// A handler waiting in post_when_ready() for room in the queue, and the completion of the wait.
+// cancel() makes the completion report operation_canceled
+struct admission_waiter
+{
+	admission_waiter* next = nullptr;
+	any_handler handler;
+	any_handler completion;
+	void (*cancel)(any_handler& completion) = nullptr;
+};
+
+/*
+The counting side of queue_limits, shared by io_context and strand. queued_ counts the handlers
+that have been admitted and have not started yet. Waiters are kept in FIFO order and have
+precedence over try_admit(), the owner hands them to the queue once a slot is theirs.
+A producer appending a waiter and a consumer releasing a slot each update their counter before
+reading the other one, so a slot released while a waiter is being appended is not missed
+*/
+class admission_control
+{
+public:
+	explicit admission_control(const queue_limits& limits)
+		: capacity_(unbounded)
+		, high_watermark_(unbounded)
+		, low_watermark_(0)
+		, queued_(0)
+		, waiting_(0)
+		, above_high_watermark_(false)
+		, first_(nullptr)
+		, last_(nullptr)
+	{
+		set_limits(limits);
+	}
+
+	admission_control(const admission_control&) = delete;
+	admission_control& operator=(const admission_control&) = delete;
+
+	// the owner has shut down already, a waiter left would have no one to complete it
+	~admission_control()
+	{
+		shutdown([](std::unique_ptr<admission_waiter>) {});
+	}
+
+	// a raised capacity takes effect for the waiters with the next drain()
+	void set_limits(const queue_limits& limits)
+	{
+		std::lock_guard<std::mutex> lock(guard_);
+		capacity_.store(limits.capacity ? limits.capacity : unbounded, std::memory_order_relaxed);
+		high_watermark_.store(limits.high_watermark ? limits.high_watermark : limits.capacity ? limits.capacity : unbounded,
+			std::memory_order_relaxed);
+		low_watermark_.store(limits.low_watermark, std::memory_order_relaxed);
+		on_high_watermark_ = limits.on_high_watermark;
+		on_low_watermark_ = limits.on_low_watermark;
+	}
+
+	size_t queued() const
+	{
+		return queued_.load(std::memory_order_relaxed);
+	}
+
+	// counts a handler that is queued whatever the capacity
+	void admit()
+	{
+		check_high_watermark(queued_.fetch_add(1) + 1);
+	}
+
+	// false at capacity, or while producers are waiting in post_when_ready()
+	bool try_admit()
+	{
+		if (waiting_.load())
+			return false;
+
+		size_t queued;
+		if (!reserve(queued))
+			return false;
+
+		check_high_watermark(queued);
+		return true;
+	}
+
+	// queues the waiter, admit(std::unique_ptr<admission_waiter>) is called for it at once if there is room
+	template<typename Admit>
+	void wait(std::unique_ptr<admission_waiter> waiter, Admit&& admit)
+	{
+		{
+			std::lock_guard<std::mutex> lock(guard_);
+			admission_waiter* w = waiter.release();
+			if (last_)
+				last_->next = w;
+			else
+				first_ = w;
+			last_ = w;
+			waiting_.fetch_add(1);
+		}
+
+		drain(std::forward<Admit>(admit));
+	}
+
+	// a counted handler has started running, or has been destroyed. Waiters are admitted to the slot
+	template<typename Admit>
+	void release(Admit&& admit)
+	{
+		const size_t queued = queued_.fetch_sub(1) - 1;
+		if (queued <= low_watermark_.load(std::memory_order_relaxed) && above_high_watermark_.load(std::memory_order_relaxed)
+			&& above_high_watermark_.exchange(false))
+			notify(on_low_watermark_, queued);
+
+		if (waiting_.load())
+			drain(std::forward<Admit>(admit));
+	}
+
+	// admits waiters in FIFO order while there is room
+	template<typename Admit>
+	void drain(Admit&& admit)
+	{
+		admission_waiter* admitted = nullptr;
+		admission_waiter** tail = &admitted;
+		size_t queued = 0;
+		{
+			std::lock_guard<std::mutex> lock(guard_);
+			while (first_ && reserve(queued))
+			{
+				admission_waiter* w = first_;
+				first_ = w->next;
+				if (!first_)
+					last_ = nullptr;
+				w->next = nullptr;
+				*tail = w;
+				tail = &w->next;
+				waiting_.fetch_sub(1);
+			}
+		}
+
+		if (!admitted)
+			return;
+
+		check_high_watermark(queued);
+		while (admitted)
+		{
+			admission_waiter* w = admitted;
+			admitted = w->next;
+			admit(std::unique_ptr<admission_waiter>(w));
+		}
+	}
+
+	// the owner is being destroyed: no callback is called any more, and every waiter is handed to
+	// cancel(std::unique_ptr<admission_waiter>) with its completion set to report operation_canceled
+	template<typename Cancel>
+	void shutdown(Cancel&& cancel)
+	{
+		admission_waiter* canceled;
+		{
+			std::lock_guard<std::mutex> lock(guard_);
+			canceled = first_;
+			first_ = last_ = nullptr;
+			waiting_.store(0);
+			on_high_watermark_ = nullptr;
+			on_low_watermark_ = nullptr;
+		}
+
+		while (canceled)
+		{
+			admission_waiter* w = canceled;
+			canceled = w->next;
+			w->next = nullptr;
+			w->cancel(w->completion);
+			cancel(std::unique_ptr<admission_waiter>(w));
+		}
+	}
+
+private:
+	static constexpr size_t unbounded = std::numeric_limits<size_t>::max();
+
+	bool reserve(size_t& queued)
+	{
+		queued = queued_.load();
+		do
+		{
+			if (queued >= capacity_.load(std::memory_order_relaxed))
+				return false;
+		} while (!queued_.compare_exchange_weak(queued, queued + 1));
+
+		++queued;
+		return true;
+	}
+
+	void check_high_watermark(size_t queued)
+	{
+		if (queued >= high_watermark_.load(std::memory_order_relaxed) && !above_high_watermark_.load(std::memory_order_relaxed)
+			&& !above_high_watermark_.exchange(true))
+			notify(on_high_watermark_, queued);
+	}
+
+	// the callback is copied, so set_limits() can replace it while it runs
+	void notify(const std::function<void(size_t)>& callback, size_t queued)
+	{
+		std::function<void(size_t)> f;
+		{
+			std::lock_guard<std::mutex> lock(guard_);
+			f = callback;
+		}
+
+		if (f)
+			f(queued);
+	}
+
+	std::atomic<size_t> capacity_;
+	std::atomic<size_t> high_watermark_;
+	std::atomic<size_t> low_watermark_;
+	std::atomic<size_t> queued_;
+	std::atomic<size_t> waiting_;
+	std::atomic<bool> above_high_watermark_;
+
+	// the waiters and the callbacks
+	std::mutex guard_;
+	admission_waiter* first_;
+	admission_waiter* last_;
+	std::function<void(size_t)> on_high_watermark_;
+	std::function<void(size_t)> on_low_watermark_;
+};
+
+// A counted handler, its slot is released when it starts running or is destroyed without running
+template<typename Owner>
+class admitted_handler
+{
+public:
+	admitted_handler(any_handler&& handler, Owner* owner)
+		: handler_(std::move(handler))
+		, owner_(owner)
+	{	}
+
+	admitted_handler(admitted_handler&& other) noexcept
+		: handler_(std::move(other.handler_))
+		, owner_(std::exchange(other.owner_, nullptr))
+	{	}
+
+	~admitted_handler()
+	{
+		if (owner_)
+			owner_->release_admission();
+	}
+
+	void operator()()
+	{
+		std::exchange(owner_, nullptr)->release_admission();
+		handler_();
+	}
+
+private:
+	any_handler handler_;
+	Owner* owner_;
+};
+
+// The completion handler of post_when_ready(), called as handler(ec)
+template<typename Handler>
+struct admission_completion
+{
+	Handler handler;
+	std::error_code ec;
+
+	void operator()()
+	{
+		handler(ec);
+	}
+
+	static void cancel(any_handler& completion)
+	{
+		completion.target<admission_completion>()->ec = std::make_error_code(std::errc::operation_canceled);
+	}
+};
+
+// Starts post_when_ready() on the owner, an io_context or a strand
+template<typename Owner>
+struct initiate_post_when_ready
+{
+	Owner* owner;
+	std::unique_ptr<admission_waiter> waiter;
+
+	template<typename Handler>
+	void operator()(Handler&& handler)
+	{
+		using completion_type = admission_completion<typename std::decay<Handler>::type>;
+		waiter->completion = any_handler(completion_type{ std::forward<Handler>(handler), std::error_code() });
+		waiter->cancel = &completion_type::cancel;
+		owner->post_when_ready_handler(std::move(waiter));
+	}
+};
+
+template<typename Handler>
+std::unique_ptr<admission_waiter> make_admission_waiter(Handler&& f)
+{
+	std::unique_ptr<admission_waiter> waiter(new admission_waiter());
+	waiter->handler = any_handler(std::forward<Handler>(f));
+	return waiter;
+}
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // MY_ASIO_DETAIL_ADMISSION_CONTROL_HPP
\ No newline at end of file
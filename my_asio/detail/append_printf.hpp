@@ -0,0 +1,37 @@
+#ifndef MY_ASIO_DETAIL_APPEND_PRINTF_HPP
+#define MY_ASIO_DETAIL_APPEND_PRINTF_HPP
+
+#include <cstdio>
+#include <string>
+
+namespace my_asio
+{
+namespace detail
+{
+
+// appends like printf, the output is never truncated
+template<typename... Args>
+void append_printf(std::string& out, const char* format, Args... args)
+{
+	char line[256];
+	const int length = std::snprintf(line, sizeof(line), format, args...);
+	if (length <= 0)
+		return;
+
+	if (size_t(length) < sizeof(line))
+	{
+		out.append(line, size_t(length));
+		return;
+	}
+
+	// a long line is formatted a second time, straight into the string
+	const size_t start = out.size();
+	out.resize(start + size_t(length) + 1);
+	std::snprintf(&out[start], size_t(length) + 1, format, args...);
+	out.resize(start + size_t(length));
+}
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // MY_ASIO_DETAIL_APPEND_PRINTF_HPP
\ No newline at end of file
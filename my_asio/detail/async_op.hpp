@@ -0,0 +1,130 @@
+#ifndef MY_ASIO_DETAIL_ASYNC_OP_HPP
+#define MY_ASIO_DETAIL_ASYNC_OP_HPP
+
+#include <cstddef>
+#include <system_error>
+
+namespace my_asio
+{
+namespace detail
+{
+
+// A pending asynchronous operation (a timer wait or a socket operation). Once the operation
+// has finished, ec and bytes_transferred hold its result and complete() runs the handler
+class async_op
+{
+public:
+	async_op* next = nullptr;
+	std::error_code ec;
+	size_t bytes_transferred = 0;
+
+	// invokes the handler and frees the op
+	void complete()
+	{
+		func_(this, true);
+	}
+
+	// frees the op without invoking the handler
+	void destroy()
+	{
+		func_(this, false);
+	}
+
+protected:
+	using func_type = void (*)(async_op*, bool invoke);
+
+	explicit async_op(func_type func)
+		: func_(func)
+	{	}
+
+	~async_op() = default;
+
+private:
+	func_type func_;
+};
+
+// Singly linked FIFO of operations, linked through async_op::next
+class op_queue
+{
+public:
+	bool empty() const
+	{
+		return front_ == nullptr;
+	}
+
+	async_op* front() const
+	{
+		return front_;
+	}
+
+	void push(async_op* op)
+	{
+		op->next = nullptr;
+		if (back_)
+			back_->next = op;
+		else
+			front_ = op;
+		back_ = op;
+	}
+
+	async_op* pop()
+	{
+		async_op* op = front_;
+		front_ = op->next;
+		if (!front_)
+			back_ = nullptr;
+		op->next = nullptr;
+		return op;
+	}
+
+	// leaves the queue empty, the caller owns the returned list
+	async_op* release()
+	{
+		async_op* ops = front_;
+		front_ = back_ = nullptr;
+		return ops;
+	}
+
+private:
+	async_op* front_ = nullptr;
+	async_op* back_ = nullptr;
+};
+
+// Queued in place of a completed operation, frees the op if it is destroyed without being run
+class op_completion
+{
+public:
+	explicit op_completion(async_op* op)
+		: op_(op)
+	{	}
+
+	op_completion(op_completion&& other) noexcept
+		: op_(other.op_)
+	{
+		other.op_ = nullptr;
+	}
+
+	op_completion(const op_completion&) = delete;
+	op_completion& operator=(const op_completion&) = delete;
+
+	~op_completion()
+	{
+		if (op_)
+			op_->destroy();
+	}
+
+	void operator()()
+	{
+		async_op* op = op_;
+		op_ = nullptr;
+		op->complete();
+	}
+
+private:
+	async_op* op_;
+};
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // MY_ASIO_DETAIL_ASYNC_OP_HPP
\ No newline at end of file
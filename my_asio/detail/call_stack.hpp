@@ -1,10 +1,20 @@
 #ifndef MY_ASIO_DETAIL_CALLSTACK_HPP
 #define MY_ASIO_DETAIL_CALLSTACK_HPP
 
+#include <cstddef>
+#include <cstdint>
+
 namespace my_asio
 {
 namespace detail
 {
+
+/*
+The keys (io_contexts, strands, ...) the calling thread is currently running, innermost first.
+Besides the stack, each thread keeps a small table that hashes a key to the innermost context
+of the keys sharing its slot. contains() only looks at that slot's chain, which holds a single
+context unless keys collide, so it does not get slower with the nesting depth
+*/
 template<typename Key, typename Value = void>
 class call_stack
 {
@@ -16,24 +26,26 @@ public:
 	{
 	public:
 		context(Key* key)
-			: key(key)
-			, value(reinterpret_cast<void*>(this))
-			, next(top)
-		{
-			top = this;
-		}
+			: context(key, reinterpret_cast<Value*>(this))
+		{	}
 
 		context(Key* key, Value* value)
 			: key(key)
 			, value(value)
-			, next(top)
 		{
-			top = this;
+			thread_stack& s = stack;
+			context*& slot = s.slots[slot_of(key)];
+			next = s.top;
+			next_in_slot = slot;
+			s.top = this;
+			slot = this;
 		}
 
 		~context()
 		{
-			top = next;
+			thread_stack& s = stack;
+			s.top = next;
+			s.slots[slot_of(key)] = next_in_slot;
 		}
 
 	private:
@@ -42,34 +54,46 @@ public:
 		Key* key;
 		Value* value;
 		context* next;
+		context* next_in_slot;
 	};
 
 	static Value* contains(Key* key)
 	{
-		context* elem = top;
-		while (elem)
-		{
+		for (context* elem = stack.slots[slot_of(key)]; elem; elem = elem->next_in_slot)
 			if (elem->key == key)
 				return elem->value;
-			elem = elem->next;
-		}
 		return nullptr;
 	}
 
 	static Value* get_top()
 	{
-		if (top)
+		if (context* top = stack.top)
 			return top->value;
 		return nullptr;
 	}
 
 private:
 	friend class context;
-	thread_local static context* top;
+
+	static constexpr size_t slot_count = 16;
+
+	// Fibonacci hashing, the low bits of neighbouring objects' addresses differ little
+	static size_t slot_of(const Key* key)
+	{
+		return size_t((reinterpret_cast<uintptr_t>(key) * uint64_t(0x9E3779B97F4A7C15)) >> 60);
+	}
+
+	struct thread_stack
+	{
+		context* top;
+		context* slots[slot_count];
+	};
+
+	thread_local static thread_stack stack;
 };
 
 template<typename Key, typename Value>
-thread_local typename call_stack<Key, Value>::context* call_stack<Key, Value>::top = nullptr;
+thread_local typename call_stack<Key, Value>::thread_stack call_stack<Key, Value>::stack = {};
 
 } // namespace detail
 } // namespace my_asio
@@ -0,0 +1,30 @@
+#ifndef MY_ASIO_DETAIL_CPU_RELAX_HPP
+#define MY_ASIO_DETAIL_CPU_RELAX_HPP
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace my_asio
+{
+namespace detail
+{
+
+// Hint to the CPU that we are in a spin-wait loop
+inline void cpu_relax()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	_mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+	_mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // MY_ASIO_DETAIL_CPU_RELAX_HPP
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef MY_ASIO_DETAIL_EPOLL_REACTOR_HPP
+#define MY_ASIO_DETAIL_EPOLL_REACTOR_HPP
+
+#include "io_engine.hpp"
+
+#if defined(MY_ASIO_HAS_EPOLL)
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace my_asio
+{
+namespace detail
+{
+
+/*
+Edge-triggered epoll reactor, like asio's epoll_reactor.
+Every descriptor is registered once for both directions. An operation is attempted as soon as
+it is started if nothing of its kind is queued ahead of it, otherwise it waits for the next edge,
+which performs the queued operations in order until one would block.
+Finished operations are handed back to the caller, which queues their handlers
+*/
+class epoll_reactor : public io_engine
+{
+public:
+	// Descriptor states are reused, an event still in flight for a closed descriptor
+	// only causes a spurious attempt on the operations of the next one
+	class descriptor_state : public io_engine::descriptor_state
+	{
+	private:
+		friend class epoll_reactor;
+
+		std::mutex guard_;
+		int descriptor_ = -1;
+		op_queue ops_[max_ops];
+	};
+
+	// throws std::system_error
+	epoll_reactor();
+
+	~epoll_reactor() override;
+
+	io_engine::descriptor_state* register_descriptor(int descriptor) override;
+
+	void deregister_descriptor(io_engine::descriptor_state* state, op_queue& completed) override;
+
+	size_t cancel_ops(io_engine::descriptor_state* state, op_queue& completed) override;
+
+	void start_op(op_type type, io_engine::descriptor_state* state, reactor_op* op, op_queue& completed) override;
+
+	void run(bool block, std::chrono::steady_clock::time_point deadline, op_queue& completed) override;
+
+	void interrupt() override;
+
+private:
+	void set_timer(std::chrono::steady_clock::time_point deadline);
+
+	int epoll_fd_;
+	int interrupter_fd_;
+	int timer_fd_;
+
+	std::mutex registry_guard_;
+	std::vector<std::unique_ptr<descriptor_state>> states_;
+	std::vector<descriptor_state*> free_states_;
+};
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // defined(MY_ASIO_HAS_EPOLL)
+
+#endif // MY_ASIO_DETAIL_EPOLL_REACTOR_HPP
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef MY_ASIO_DETAIL_HANDLER_QUEUE_HPP
+#define MY_ASIO_DETAIL_HANDLER_QUEUE_HPP
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include "any_handler.hpp"
+#include "recycling_allocator.hpp"
+
+namespace my_asio
+{
+namespace detail
+{
+
+// Handler storage whose blocks come from the thread's recycling memory cache
+using handler_deque = std::deque<any_handler, recycling_allocator<any_handler>>;
+using handler_vector = std::vector<any_handler, recycling_allocator<any_handler>>;
+
+// Queue of ready handlers owned by an io_context, implementations must allow
+// any number of threads to push and pop concurrently
+class handler_queue
+{
+public:
+	handler_queue() = default;
+	handler_queue(const handler_queue&) = delete;
+	const handler_queue& operator=(const handler_queue&) = delete;
+
+	virtual ~handler_queue() = default;
+
+	virtual void push(any_handler&& handler) = 0;
+
+	// moves count handlers, in order, the moved-from handlers are left empty
+	virtual void push_all(any_handler* handlers, size_t count) = 0;
+
+	// push_all() from a thread that pops from the queue, which a single consumer queue can do without synchronization
+	virtual void push_all_from_consumer(any_handler* handlers, size_t count)
+	{
+		push_all(handlers, count);
+	}
+
+	// puts back count handlers popped from the queue, ahead of the queued ones and in order
+	virtual void push_front_all(any_handler* handlers, size_t count) = 0;
+
+	// returns false if the queue is empty
+	virtual bool try_pop(any_handler& handler) = 0;
+
+	// appends up to max_count handlers to batch, returns how many were taken
+	virtual size_t try_pop_batch(handler_vector& batch, size_t max_count) = 0;
+
+	// safe to call without synchronization, the result may be stale
+	virtual bool empty() const = 0;
+};
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // MY_ASIO_DETAIL_HANDLER_QUEUE_HPP
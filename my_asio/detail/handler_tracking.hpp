@@ -0,0 +1,72 @@
+#ifndef MY_ASIO_DETAIL_HANDLER_TRACKING_HPP
+#define MY_ASIO_DETAIL_HANDLER_TRACKING_HPP
+
+#include "any_handler.hpp"
+
+#if defined(MY_ASIO_ENABLE_HANDLER_TRACKING)
+
+#include <cstdint>
+
+#include "call_stack.hpp"
+
+namespace my_asio
+{
+namespace detail
+{
+
+/*
+Records a trace event when a handler is posted and when it has run, into a ring buffer of
+the calling thread. The id of a handler travels with its any_handler, the handler that was
+running when it was posted is its causal parent.
+Compiled in with MY_ASIO_ENABLE_HANDLER_TRACKING, the MY_ASIO_HANDLER_* macros below are
+empty otherwise
+*/
+class handler_tracking
+{
+public:
+	// the handler running on this thread, found through call_stack<const frame, const frame>
+	struct frame
+	{
+		uint64_t id;
+		const void* strand;
+	};
+
+	// gives the handler an id and records its post, strand is null for the io_context
+	static void creation(any_handler& handler, const void* strand);
+
+	// records the run of the handler, from construction to destruction, nested posts see it as their parent
+	class invocation
+	{
+	public:
+		invocation(const any_handler& handler, const void* strand);
+
+		invocation(const invocation&) = delete;
+		invocation& operator=(const invocation&) = delete;
+
+		~invocation();
+
+	private:
+		frame frame_;
+		int64_t started_;
+		call_stack<const frame, const frame>::context context_;
+	};
+};
+
+} // namespace detail
+} // namespace my_asio
+
+#define MY_ASIO_HANDLER_CREATION(handler, strand) \
+	my_asio::detail::handler_tracking::creation(handler, strand)
+
+#define MY_ASIO_HANDLER_INVOCATION(handler, strand) \
+	my_asio::detail::handler_tracking::invocation handler_tracking_invocation_(handler, strand)
+
+#else
+
+#define MY_ASIO_HANDLER_CREATION(handler, strand) ((void)0)
+
+#define MY_ASIO_HANDLER_INVOCATION(handler, strand) ((void)0)
+
+#endif // defined(MY_ASIO_ENABLE_HANDLER_TRACKING)
+
+#endif // MY_ASIO_DETAIL_HANDLER_TRACKING_HPP
\ No newline at end of file
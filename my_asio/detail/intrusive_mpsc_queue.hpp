@@ -0,0 +1,85 @@
+#ifndef MY_ASIO_DETAIL_INTRUSIVE_MPSC_QUEUE_HPP
+#define MY_ASIO_DETAIL_INTRUSIVE_MPSC_QUEUE_HPP
+
+#include <atomic>
+
+namespace my_asio
+{
+namespace detail
+{
+
+/*
+Unbounded intrusive multi-producer single-consumer FIFO (D. Vyukov's node based queue).
+Node must have a member std::atomic<Node*> next. push() is wait-free, pop() may report
+an empty queue while a producer is between its two steps, callers that know a node is
+coming simply retry
+*/
+template<typename Node>
+class intrusive_mpsc_queue
+{
+public:
+	intrusive_mpsc_queue()
+		: head_(&stub_)
+		, tail_(&stub_)
+	{
+		stub_.next.store(nullptr, std::memory_order_relaxed);
+	}
+
+	intrusive_mpsc_queue(const intrusive_mpsc_queue&) = delete;
+	const intrusive_mpsc_queue& operator=(const intrusive_mpsc_queue&) = delete;
+
+	// any thread
+	void push(Node* n)
+	{
+		n->next.store(nullptr, std::memory_order_relaxed);
+		Node* prev = head_.exchange(n, std::memory_order_acq_rel);
+		prev->next.store(n, std::memory_order_release);
+	}
+
+	// consumer thread only, returns nullptr if no node is available yet
+	Node* pop()
+	{
+		Node* tail = tail_;
+		Node* next = tail->next.load(std::memory_order_acquire);
+
+		if (tail == &stub_)
+		{
+			if (!next)
+				return nullptr;
+			tail_ = next;
+			tail = next;
+			next = next->next.load(std::memory_order_acquire);
+		}
+
+		if (next)
+		{
+			tail_ = next;
+			return tail;
+		}
+
+		// tail is the last node, unless a producer is in the middle of a push
+		if (tail != head_.load(std::memory_order_acquire))
+			return nullptr;
+
+		push(&stub_);
+
+		next = tail->next.load(std::memory_order_acquire);
+		if (next)
+		{
+			tail_ = next;
+			return tail;
+		}
+
+		return nullptr;
+	}
+
+private:
+	alignas(64) std::atomic<Node*> head_;
+	alignas(64) Node* tail_;
+	Node stub_;
+};
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // MY_ASIO_DETAIL_INTRUSIVE_MPSC_QUEUE_HPP
\ No newline at end of file
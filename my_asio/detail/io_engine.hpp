@@ -0,0 +1,145 @@
+#ifndef MY_ASIO_DETAIL_IO_ENGINE_HPP
+#define MY_ASIO_DETAIL_IO_ENGINE_HPP
+
+#if defined(__linux__)
+#define MY_ASIO_HAS_EPOLL 1
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define MY_ASIO_HAS_IO_URING 1
+#endif
+#endif
+#endif
+
+#if defined(MY_ASIO_HAS_EPOLL)
+
+#include <chrono>
+#include <cstddef>
+
+#include "async_op.hpp"
+
+namespace my_asio
+{
+namespace detail
+{
+
+// What a socket operation asks of the kernel, for engines that submit operations instead of polling readiness
+struct io_request
+{
+	enum kind_type
+	{
+		receive,
+		send,
+		accept
+	};
+
+	kind_type kind;
+	int descriptor;
+	void* data;
+	size_t size;
+};
+
+// An operation on a socket descriptor, carried out by the io_engine of its io_context
+class reactor_op : public async_op
+{
+public:
+	struct vtable
+	{
+		// one non-blocking attempt, false if the operation would block
+		bool (*perform)(reactor_op*);
+
+		io_request (*request)(reactor_op*);
+
+		// stores the result of the system call, a byte count or descriptor, or -errno
+		void (*set_result)(reactor_op*, long result);
+	};
+
+	bool perform()
+	{
+		return vtable_->perform(this);
+	}
+
+	io_request request()
+	{
+		return vtable_->request(this);
+	}
+
+	void set_result(long result)
+	{
+		vtable_->set_result(this, result);
+	}
+
+	// owned by the io_engine while the operation is pending
+	void* engine_state = nullptr;
+
+protected:
+	reactor_op(const vtable* operations, func_type complete_func)
+		: async_op(complete_func)
+		, vtable_(operations)
+	{	}
+
+	~reactor_op() = default;
+
+private:
+	const vtable* vtable_;
+};
+
+/*
+Drives the socket operations of an io_context, either by waiting for readiness (epoll_reactor)
+or by submitting the operations to the kernel (io_uring_engine).
+Finished operations are handed back to the caller, which queues their handlers.
+Implementations must allow any number of threads to use them concurrently
+*/
+class io_engine
+{
+public:
+	enum op_type
+	{
+		read_op = 0,
+		write_op = 1,
+		max_ops = 2
+	};
+
+	// the engine's per-descriptor state, reused once the descriptor has been deregistered
+	class descriptor_state
+	{
+	protected:
+		~descriptor_state() = default;
+	};
+
+	io_engine() = default;
+	io_engine(const io_engine&) = delete;
+	io_engine& operator=(const io_engine&) = delete;
+
+	virtual ~io_engine() = default;
+
+	// throws std::system_error
+	virtual descriptor_state* register_descriptor(int descriptor) = 0;
+
+	// must be called before the descriptor is closed, the pending operations
+	// are completed with operation_canceled
+	virtual void deregister_descriptor(descriptor_state* state, op_queue& completed) = 0;
+
+	// completes the pending operations with operation_canceled, returns how many there were
+	virtual size_t cancel_ops(descriptor_state* state, op_queue& completed) = 0;
+
+	// operations of one type on one descriptor are carried out in the order they were started
+	virtual void start_op(op_type type, descriptor_state* state, reactor_op* op, op_queue& completed) = 0;
+
+	// hands operations started since the last call to the kernel
+	virtual void submit()
+	{	}
+
+	// collects finished operations. A blocking run waits for a completion, an interrupt
+	// or the deadline, only a blocking run consumes interrupts
+	virtual void run(bool block, std::chrono::steady_clock::time_point deadline, op_queue& completed) = 0;
+
+	// makes a blocking run() return
+	virtual void interrupt() = 0;
+};
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // defined(MY_ASIO_HAS_EPOLL)
+
+#endif // MY_ASIO_DETAIL_IO_ENGINE_HPP
\ No newline at end of file
@@ -0,0 +1,125 @@
+#ifndef MY_ASIO_DETAIL_IO_URING_ENGINE_HPP
+#define MY_ASIO_DETAIL_IO_URING_ENGINE_HPP
+
+#include "io_engine.hpp"
+
+#if defined(MY_ASIO_HAS_IO_URING)
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <linux/io_uring.h>
+
+namespace my_asio
+{
+namespace detail
+{
+
+/*
+io_uring engine, talking to the kernel through the raw system calls.
+Operations are written to the submission ring as they are started and handed to the kernel
+in one io_uring_enter by submit(), which the io_context calls once the running handler has
+returned, or by the next run(). One operation of each kind per descriptor is in the kernel,
+the ones started behind it wait in the descriptor state, so their order is kept.
+An operation the kernel answers with EAGAIN is re-armed with a poll request.
+A cancelled operation stays in the kernel until its completion arrives, the memory of an
+operation is never touched once its completion has been handed back
+*/
+class io_uring_engine : public io_engine
+{
+public:
+	// A state is reused once the descriptor has been deregistered and its last operation has completed
+	class descriptor_state : public io_engine::descriptor_state
+	{
+	private:
+		friend class io_uring_engine;
+
+		std::mutex guard_;
+		bool registered_ = false;
+		reactor_op* in_flight_[max_ops] = {};
+		bool polling_[max_ops] = {};
+		bool canceled_[max_ops] = {};
+		op_queue ops_[max_ops];
+	};
+
+	// throws std::system_error if io_uring is not available or lacks a required feature
+	explicit io_uring_engine(unsigned entries = 1024);
+
+	~io_uring_engine() override;
+
+	io_engine::descriptor_state* register_descriptor(int descriptor) override;
+
+	void deregister_descriptor(io_engine::descriptor_state* state, op_queue& completed) override;
+
+	size_t cancel_ops(io_engine::descriptor_state* state, op_queue& completed) override;
+
+	void start_op(op_type type, io_engine::descriptor_state* state, reactor_op* op, op_queue& completed) override;
+
+	void submit() override;
+
+	void run(bool block, std::chrono::steady_clock::time_point deadline, op_queue& completed) override;
+
+	void interrupt() override;
+
+private:
+	// holds cq_guard_ until a completion, an interrupt or the deadline
+	void wait(std::chrono::steady_clock::time_point deadline, op_queue& completed);
+
+	// called with the state's guard held
+	void start_request(descriptor_state* state, op_type type, reactor_op* op);
+
+	// called with the state's guard held, cancels what the kernel holds for the in-flight operation
+	void cancel_request(descriptor_state* state, op_type type);
+
+	// queues an SQE, which the kernel sees on the next submit
+	void push_sqe(const io_uring_sqe& sqe);
+
+	// called with sq_guard_ held
+	void flush_backlog();
+
+	// called with cq_guard_ held, hands the finished operations to completed
+	void reap(op_queue& completed);
+
+	void complete(reactor_op* op, bool poll, int result, op_queue& completed);
+
+	void release_state(descriptor_state* state);
+
+	int ring_fd_;
+	void* ring_;
+	size_t ring_size_;
+	io_uring_sqe* sqes_;
+	size_t sqes_size_;
+
+	// submission ring, written under sq_guard_. SQEs that do not fit wait in backlog_
+	std::mutex sq_guard_;
+	unsigned* sq_head_;
+	unsigned* sq_tail_;
+	unsigned* sq_array_;
+	unsigned sq_mask_;
+	unsigned sq_entries_;
+	std::vector<io_uring_sqe> backlog_;
+
+	// completion ring, only the thread holding cq_guard_ reaps. A blocking run holds it while
+	// it waits, so an interrupt can not be reaped by anyone else
+	std::mutex cq_guard_;
+	unsigned* cq_head_;
+	unsigned* cq_tail_;
+	io_uring_cqe* cqes_;
+	unsigned cq_mask_;
+	std::atomic<bool> interrupted_;
+
+	std::mutex registry_guard_;
+	std::vector<std::unique_ptr<descriptor_state>> states_;
+	std::vector<descriptor_state*> free_states_;
+};
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // defined(MY_ASIO_HAS_IO_URING)
+
+#endif // MY_ASIO_DETAIL_IO_URING_ENGINE_HPP
\ No newline at end of file
@@ -0,0 +1,199 @@
+#ifndef MY_ASIO_DETAIL_LOCKFREE_HANDLER_QUEUE_HPP
+#define MY_ASIO_DETAIL_LOCKFREE_HANDLER_QUEUE_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <queue>
+
+#include "handler_queue.hpp"
+
+namespace my_asio
+{
+namespace detail
+{
+
+/*
+Bounded lock-free MPMC ring (D. Vyukov's sequence-numbered cells) used as the fast path.
+When the ring is full, handlers spill into a mutex protected overflow queue, while the
+overflow is non-empty producers keep appending to it so that handlers posted by one
+thread are still dequeued in FIFO order. Handlers put back with push_front_all() wait in
+a third, locked queue that is popped before the ring
+*/
+class lockfree_handler_queue : public handler_queue
+{
+public:
+	explicit lockfree_handler_queue(size_t capacity = 4096)
+		: mask_(round_up_to_power_of_two(capacity) - 1)
+		, cells_(new cell[mask_ + 1])
+		, enqueue_pos_(0)
+		, dequeue_pos_(0)
+		, overflow_size_(0)
+		, returned_size_(0)
+	{
+		for (size_t i = 0; i != mask_ + 1; ++i)
+			cells_[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	void push(any_handler&& handler) override
+	{
+		if (overflow_size_.load(std::memory_order_acquire) == 0 && try_push_ring(handler))
+			return;
+
+		std::lock_guard<std::mutex> lock(overflow_guard_);
+		overflow_.push(std::move(handler));
+		overflow_size_.fetch_add(1, std::memory_order_release);
+	}
+
+	void push_all(any_handler* handlers, size_t count) override
+	{
+		for (size_t i = 0; i != count; ++i)
+			push(std::move(handlers[i]));
+	}
+
+	void push_front_all(any_handler* handlers, size_t count) override
+	{
+		std::lock_guard<std::mutex> lock(overflow_guard_);
+		for (size_t i = count; i != 0; --i)
+			returned_.push_front(std::move(handlers[i - 1]));
+		returned_size_.fetch_add(count, std::memory_order_release);
+	}
+
+	bool try_pop(any_handler& handler) override
+	{
+		if (returned_size_.load(std::memory_order_acquire) != 0 && try_pop_returned(handler))
+			return true;
+
+		if (try_pop_ring(handler))
+			return true;
+
+		if (overflow_size_.load(std::memory_order_acquire) == 0)
+			return false;
+
+		std::lock_guard<std::mutex> lock(overflow_guard_);
+
+		// handlers that reached the ring before the overflow started are older
+		if (try_pop_ring(handler))
+			return true;
+
+		if (overflow_.empty())
+			return false;
+
+		handler = std::move(overflow_.front());
+		overflow_.pop();
+		overflow_size_.fetch_sub(1, std::memory_order_release);
+		return true;
+	}
+
+	size_t try_pop_batch(handler_vector& batch, size_t max_count) override
+	{
+		size_t count = 0;
+		any_handler handler;
+		for (; count != max_count && try_pop(handler); ++count)
+			batch.push_back(std::move(handler));
+		return count;
+	}
+
+	bool empty() const override
+	{
+		return enqueue_pos_.load(std::memory_order_acquire) == dequeue_pos_.load(std::memory_order_acquire)
+			&& overflow_size_.load(std::memory_order_acquire) == 0
+			&& returned_size_.load(std::memory_order_acquire) == 0;
+	}
+
+private:
+	struct cell
+	{
+		std::atomic<size_t> sequence;
+		any_handler handler;
+	};
+
+	static size_t round_up_to_power_of_two(size_t n)
+	{
+		size_t result = 2;
+		while (result < n)
+			result <<= 1;
+		return result;
+	}
+
+	bool try_pop_returned(any_handler& handler)
+	{
+		std::lock_guard<std::mutex> lock(overflow_guard_);
+		if (returned_.empty())
+			return false;
+
+		handler = std::move(returned_.front());
+		returned_.pop_front();
+		returned_size_.fetch_sub(1, std::memory_order_release);
+		return true;
+	}
+
+	bool try_push_ring(any_handler& handler)
+	{
+		size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+		cell* c;
+		for (;;)
+		{
+			c = &cells_[pos & mask_];
+			const size_t seq = c->sequence.load(std::memory_order_acquire);
+			const std::ptrdiff_t dif = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+			if (dif == 0)
+			{
+				if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (dif < 0)
+				return false; // full
+			else
+				pos = enqueue_pos_.load(std::memory_order_relaxed);
+		}
+
+		c->handler = std::move(handler);
+		c->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool try_pop_ring(any_handler& handler)
+	{
+		size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+		cell* c;
+		for (;;)
+		{
+			c = &cells_[pos & mask_];
+			const size_t seq = c->sequence.load(std::memory_order_acquire);
+			const std::ptrdiff_t dif = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+			if (dif == 0)
+			{
+				if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (dif < 0)
+				return false; // empty
+			else
+				pos = dequeue_pos_.load(std::memory_order_relaxed);
+		}
+
+		handler = std::move(c->handler);
+		c->sequence.store(pos + mask_ + 1, std::memory_order_release);
+		return true;
+	}
+
+	const size_t mask_;
+	const std::unique_ptr<cell[]> cells_;
+
+	// producers and consumers hammer different cache lines
+	alignas(64) std::atomic<size_t> enqueue_pos_;
+	alignas(64) std::atomic<size_t> dequeue_pos_;
+
+	// overflow_guard_ protects both the overflow and the returned handlers
+	alignas(64) std::atomic<size_t> overflow_size_;
+	std::atomic<size_t> returned_size_;
+	std::mutex overflow_guard_;
+	std::queue<any_handler, handler_deque> overflow_;
+	handler_deque returned_;
+};
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // MY_ASIO_DETAIL_LOCKFREE_HANDLER_QUEUE_HPP
@@ -0,0 +1,90 @@
+#ifndef MY_ASIO_DETAIL_MUTEX_HANDLER_QUEUE_HPP
+#define MY_ASIO_DETAIL_MUTEX_HANDLER_QUEUE_HPP
+
+#include <atomic>
+#include <mutex>
+
+#include "handler_queue.hpp"
+
+namespace my_asio
+{
+namespace detail
+{
+
+// FIFO protected by a single mutex
+class mutex_handler_queue : public handler_queue
+{
+public:
+	mutex_handler_queue()
+		: size_(0)
+	{	}
+
+	void push(any_handler&& handler) override
+	{
+		std::lock_guard<std::mutex> lock(queue_guard_);
+		work_queue_.push_back(std::move(handler));
+		size_.store(work_queue_.size(), std::memory_order_release);
+	}
+
+	void push_all(any_handler* handlers, size_t count) override
+	{
+		std::lock_guard<std::mutex> lock(queue_guard_);
+		for (size_t i = 0; i != count; ++i)
+			work_queue_.push_back(std::move(handlers[i]));
+		size_.store(work_queue_.size(), std::memory_order_release);
+	}
+
+	void push_front_all(any_handler* handlers, size_t count) override
+	{
+		std::lock_guard<std::mutex> lock(queue_guard_);
+		for (size_t i = count; i != 0; --i)
+			work_queue_.push_front(std::move(handlers[i - 1]));
+		size_.store(work_queue_.size(), std::memory_order_release);
+	}
+
+	bool try_pop(any_handler& handler) override
+	{
+		if (empty())
+			return false;
+
+		std::lock_guard<std::mutex> lock(queue_guard_);
+		if (work_queue_.empty())
+			return false;
+
+		handler = std::move(work_queue_.front());
+		work_queue_.pop_front();
+		size_.store(work_queue_.size(), std::memory_order_release);
+		return true;
+	}
+
+	size_t try_pop_batch(handler_vector& batch, size_t max_count) override
+	{
+		if (empty())
+			return 0;
+
+		std::lock_guard<std::mutex> lock(queue_guard_);
+		size_t count = 0;
+		for (; count != max_count && !work_queue_.empty(); ++count)
+		{
+			batch.push_back(std::move(work_queue_.front()));
+			work_queue_.pop_front();
+		}
+		size_.store(work_queue_.size(), std::memory_order_release);
+		return count;
+	}
+
+	bool empty() const override
+	{
+		return size_.load(std::memory_order_acquire) == 0;
+	}
+
+private:
+	std::mutex queue_guard_;
+	handler_deque work_queue_;
+	std::atomic<size_t> size_;
+};
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // MY_ASIO_DETAIL_MUTEX_HANDLER_QUEUE_HPP
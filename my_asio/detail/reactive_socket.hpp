@@ -0,0 +1,213 @@
+#ifndef MY_ASIO_DETAIL_REACTIVE_SOCKET_HPP
+#define MY_ASIO_DETAIL_REACTIVE_SOCKET_HPP
+
+#include "io_engine.hpp"
+
+#if defined(MY_ASIO_HAS_EPOLL)
+
+#include <new>
+#include <system_error>
+#include <utility>
+
+#include "io_context.hpp"
+#include "buffer.hpp"
+#include "recycling_allocator.hpp"
+
+namespace my_asio
+{
+namespace detail
+{
+
+// A non-blocking socket descriptor registered with the io_engine of its io_context
+class reactive_socket
+{
+public:
+	explicit reactive_socket(io_context& io);
+
+	reactive_socket(const reactive_socket&) = delete;
+	reactive_socket& operator=(const reactive_socket&) = delete;
+
+	~reactive_socket();
+
+	io_context& context() const;
+
+	bool is_open() const;
+
+	int native_handle() const;
+
+	// throws std::system_error
+	void open(int family, int type, int protocol);
+
+	// takes ownership of a non-blocking descriptor, which is closed if it can not be registered
+	std::error_code assign(int descriptor);
+
+	// the pending operations complete with operation_canceled
+	void close();
+
+	size_t cancel();
+
+	// the op's work is counted until its handler has run. On a closed socket the op fails with bad_file_descriptor
+	void start_op(io_engine::op_type type, reactor_op* op);
+
+private:
+	io_context& io_;
+	int descriptor_;
+	io_engine::descriptor_state* state_;
+};
+
+/*
+A socket operation allocated from the calling thread's memory cache. Operation supplies
+bool perform(reactor_op&), one non-blocking attempt, request(), the operation for engines that
+submit it, set_result(reactor_op&, long), which stores a system call result or -errno,
+complete(handler, ec, bytes_transferred), the upcall, and abandon(), which releases what the
+operation holds if the handler is never run
+*/
+template<typename Handler, typename Operation>
+class reactive_socket_op : public reactor_op
+{
+public:
+	template<typename H>
+	static reactor_op* create(H&& handler, const Operation& operation)
+	{
+		void* p = thread_memory_cache::allocate(sizeof(reactive_socket_op));
+		return new (p) reactive_socket_op(std::forward<H>(handler), operation);
+	}
+
+private:
+	template<typename H>
+	reactive_socket_op(H&& handler, const Operation& operation)
+		: reactor_op(&operations, &reactive_socket_op::do_complete)
+		, handler_(std::forward<H>(handler))
+		, operation_(operation)
+	{	}
+
+	static bool do_perform(reactor_op* base)
+	{
+		reactive_socket_op* op = static_cast<reactive_socket_op*>(base);
+		return op->operation_.perform(*op);
+	}
+
+	static io_request do_request(reactor_op* base)
+	{
+		return static_cast<reactive_socket_op*>(base)->operation_.request();
+	}
+
+	static void do_set_result(reactor_op* base, long result)
+	{
+		reactive_socket_op* op = static_cast<reactive_socket_op*>(base);
+		op->operation_.set_result(*op, result);
+	}
+
+	// the memory is released before the upcall, so the handler can start the next operation
+	static void do_complete(async_op* base, bool invoke)
+	{
+		reactive_socket_op* op = static_cast<reactive_socket_op*>(base);
+		Handler handler(std::move(op->handler_));
+		Operation operation(op->operation_);
+		const std::error_code ec = op->ec;
+		const size_t bytes_transferred = op->bytes_transferred;
+
+		op->~reactive_socket_op();
+		thread_memory_cache::deallocate(op, sizeof(reactive_socket_op));
+
+		if (invoke)
+			operation.complete(handler, ec, bytes_transferred);
+		else
+			operation.abandon();
+	}
+
+	static const vtable operations;
+
+	Handler handler_;
+	Operation operation_;
+};
+
+template<typename Handler, typename Operation>
+const reactor_op::vtable reactive_socket_op<Handler, Operation>::operations = {
+	&reactive_socket_op::do_perform,
+	&reactive_socket_op::do_request,
+	&reactive_socket_op::do_set_result
+};
+
+struct receive_operation
+{
+	int descriptor;
+	mutable_buffer buffer;
+
+	bool perform(reactor_op& op);
+
+	io_request request() const
+	{
+		return { io_request::receive, descriptor, buffer.data(), buffer.size() };
+	}
+
+	// a read of a connection closed by the peer fails with error::eof
+	void set_result(reactor_op& op, long result);
+
+	template<typename Handler>
+	void complete(Handler& handler, const std::error_code& ec, size_t bytes_transferred)
+	{
+		handler(ec, bytes_transferred);
+	}
+
+	void abandon()
+	{	}
+};
+
+struct send_operation
+{
+	int descriptor;
+	const_buffer buffer;
+
+	bool perform(reactor_op& op);
+
+	io_request request() const
+	{
+		return { io_request::send, descriptor, const_cast<void*>(buffer.data()), buffer.size() };
+	}
+
+	void set_result(reactor_op& op, long result);
+
+	template<typename Handler>
+	void complete(Handler& handler, const std::error_code& ec, size_t bytes_transferred)
+	{
+		handler(ec, bytes_transferred);
+	}
+
+	void abandon()
+	{	}
+};
+
+// the accepted descriptor is handed to the peer socket just before the upcall
+struct accept_operation
+{
+	int descriptor;
+	reactive_socket* peer;
+	int new_descriptor = -1;
+
+	bool perform(reactor_op& op);
+
+	io_request request() const
+	{
+		return { io_request::accept, descriptor, nullptr, 0 };
+	}
+
+	void set_result(reactor_op& op, long result);
+
+	template<typename Handler>
+	void complete(Handler& handler, const std::error_code& ec, size_t)
+	{
+		handler(ec ? ec : take_new_descriptor());
+	}
+
+	void abandon();
+
+	std::error_code take_new_descriptor();
+};
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // defined(MY_ASIO_HAS_EPOLL)
+
+#endif // MY_ASIO_DETAIL_REACTIVE_SOCKET_HPP
\ No newline at end of file
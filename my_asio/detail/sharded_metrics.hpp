@@ -0,0 +1,132 @@
+#ifndef MY_ASIO_DETAIL_SHARDED_METRICS_HPP
+#define MY_ASIO_DETAIL_SHARDED_METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "metrics.hpp"
+
+namespace my_asio
+{
+namespace detail
+{
+
+constexpr size_t metrics_shards = 16;
+
+// shard of the calling thread, threads are spread over the shards in the order they first ask
+inline size_t this_thread_metrics_shard()
+{
+	// constant initialized, so reading it needs no thread_local guard
+	thread_local size_t shard = metrics_shards;
+	if (shard == metrics_shards)
+	{
+		static std::atomic<size_t> next_shard(0);
+		shard = next_shard.fetch_add(1, std::memory_order_relaxed) % metrics_shards;
+	}
+	return shard;
+}
+
+// true once every interval calls on the calling thread
+inline bool this_thread_takes_sample(unsigned interval)
+{
+	thread_local unsigned ticks = 0;
+	if (++ticks < interval)
+		return false;
+	ticks = 0;
+	return true;
+}
+
+/*
+Counter split into cache line sized shards, a thread only writes its own shard, so
+concurrent increments do not bounce a cache line between cores unless more threads
+than shards are counting.
+Reading sums the shards and is not atomic with respect to concurrent increments
+*/
+class sharded_counter
+{
+public:
+	void add(uint64_t n)
+	{
+		shards_[this_thread_metrics_shard()].value.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	uint64_t load() const
+	{
+		uint64_t sum = 0;
+		for (const shard& s : shards_)
+			sum += s.value.load(std::memory_order_relaxed);
+		return sum;
+	}
+
+private:
+	struct alignas(64) shard
+	{
+		std::atomic<uint64_t> value{ 0 };
+	};
+
+	shard shards_[metrics_shards];
+};
+
+// Sharded log-linear histogram of durations, see histogram_snapshot for the bucket layout
+class latency_histogram
+{
+public:
+	void record(std::chrono::steady_clock::duration duration)
+	{
+		const long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+		const uint64_t value = ns > 0 ? uint64_t(ns) : 0;
+
+		shard& s = shards_[this_thread_metrics_shard()];
+		s.count.fetch_add(1, std::memory_order_relaxed);
+		s.sum.fetch_add(value, std::memory_order_relaxed);
+		s.buckets[histogram_snapshot::bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	histogram_snapshot snapshot() const;
+
+private:
+	struct alignas(64) shard
+	{
+		std::atomic<uint64_t> count{ 0 };
+		std::atomic<uint64_t> sum{ 0 };
+		std::atomic<uint64_t> buckets[histogram_snapshot::bucket_count] = {};
+	};
+
+	shard shards_[metrics_shards];
+};
+
+// Collected by an io_context once enable_metrics() has been called
+struct io_context_metrics_state
+{
+	explicit io_context_metrics_state(unsigned interval)
+		: sample_interval(interval)
+	{	}
+
+	const unsigned sample_interval;
+	sharded_counter handlers_queued;
+	sharded_counter handlers_run;
+	sharded_counter next_handler_hits;
+	sharded_counter next_handler_spills;
+	latency_histogram queue_wait;
+	latency_histogram run_time;
+};
+
+// Collected by a strand once enable_metrics() has been called
+struct strand_metrics_state
+{
+	explicit strand_metrics_state(unsigned interval)
+		: sample_interval(interval)
+	{	}
+
+	const unsigned sample_interval;
+	sharded_counter handlers_posted;
+	latency_histogram queue_wait;
+	latency_histogram run_time;
+};
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // MY_ASIO_DETAIL_SHARDED_METRICS_HPP
\ No newline at end of file
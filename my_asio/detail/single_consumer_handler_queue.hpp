@@ -0,0 +1,95 @@
+#ifndef MY_ASIO_DETAIL_SINGLE_CONSUMER_HANDLER_QUEUE_HPP
+#define MY_ASIO_DETAIL_SINGLE_CONSUMER_HANDLER_QUEUE_HPP
+
+#include "handler_queue.hpp"
+#include "lockfree_handler_queue.hpp"
+
+namespace my_asio
+{
+namespace detail
+{
+
+/*
+The queue of an io_context run by a single thread. Handlers queued by the consumer are kept in
+a plain deque, no lock nor atomic operation involved. Other threads push into a lock-free ring,
+the inbox, which the consumer moves to the end of the deque before it pops, so the handlers of
+every producer stay in FIFO order.
+Unlike the other handler_queues only one thread at a time may pop, and call empty()
+*/
+class single_consumer_handler_queue : public handler_queue
+{
+public:
+	static constexpr size_t inbox_capacity = 1024;
+
+	single_consumer_handler_queue()
+		: inbox_(inbox_capacity)
+	{	}
+
+	void push(any_handler&& handler) override
+	{
+		inbox_.push(std::move(handler));
+	}
+
+	void push_all(any_handler* handlers, size_t count) override
+	{
+		inbox_.push_all(handlers, count);
+	}
+
+	void push_all_from_consumer(any_handler* handlers, size_t count) override
+	{
+		for (size_t i = 0; i != count; ++i)
+			local_.push_back(std::move(handlers[i]));
+	}
+
+	// also only called by the consumer
+	void push_front_all(any_handler* handlers, size_t count) override
+	{
+		for (size_t i = count; i != 0; --i)
+			local_.push_front(std::move(handlers[i - 1]));
+	}
+
+	bool try_pop(any_handler& handler) override
+	{
+		if (local_.empty())
+			return inbox_.try_pop(handler);
+
+		take_inbox();
+		handler = std::move(local_.front());
+		local_.pop_front();
+		return true;
+	}
+
+	size_t try_pop_batch(handler_vector& batch, size_t max_count) override
+	{
+		take_inbox();
+		size_t count = 0;
+		for (; count != max_count && !local_.empty(); ++count)
+		{
+			batch.push_back(std::move(local_.front()));
+			local_.pop_front();
+		}
+		return count;
+	}
+
+	bool empty() const override
+	{
+		return local_.empty() && inbox_.empty();
+	}
+
+private:
+	// at most a ring's worth, so producers that keep posting can not hold up the consumer
+	void take_inbox()
+	{
+		any_handler handler;
+		for (size_t i = 0; i != inbox_capacity && !inbox_.empty() && inbox_.try_pop(handler); ++i)
+			local_.push_back(std::move(handler));
+	}
+
+	lockfree_handler_queue inbox_;
+	handler_deque local_;
+};
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // MY_ASIO_DETAIL_SINGLE_CONSUMER_HANDLER_QUEUE_HPP
\ No newline at end of file
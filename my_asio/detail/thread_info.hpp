@@ -0,0 +1,64 @@
+#ifndef MY_ASIO_DETAIL_THREAD_INFO_HPP
+#define MY_ASIO_DETAIL_THREAD_INFO_HPP
+
+#include <memory>
+
+#include "handler_queue.hpp"
+#include "work_stealing_queue.hpp"
+
+namespace my_asio
+{
+namespace detail
+{
+
+// State of a thread while it is inside io_context::run/run_one/poll/poll_one,
+// reachable through call_stack<io_context, thread_info>
+struct thread_info
+{
+	// handlers deferred by the running handler and their work, both are handed over
+	// to the shared queue and outstanding work count when the handler returns
+	handler_vector private_queue;
+	size_t private_outstanding_work = 0;
+
+	// work finished on this thread that the outstanding work count still includes. Work started
+	// on the thread uses it up first, the rest is retired when the thread runs out of handlers
+	size_t work_credits = 0;
+
+	// the only handler deferred by the last handler, it runs next on this thread.
+	// next_handler_streak counts the handlers run from the slot in a row
+	any_handler next_handler;
+	unsigned next_handler_streak = 0;
+
+	// the running handler has yielded, its continuation goes to the queue rather than the slot
+	bool yielded = false;
+
+	// handlers taken from the shared queue in one go, batch[batch_pos] is the next to run
+	handler_vector batch;
+	size_t batch_pos = 0;
+
+	// how many handlers may be taken from the shared queue at once
+	size_t batch_limit = 1;
+
+	// only allocated in scheduler_mode::work_stealing
+	std::unique_ptr<work_stealing_queue> local_queue;
+
+	// handlers taken from the local queue since the shared queue was last checked
+	unsigned local_ticks = 0;
+
+	// where the next steal attempt starts
+	size_t next_victim = 0;
+
+	// handlers run since the reactor was last polled
+	unsigned reactor_ticks = 0;
+
+	// handlers run since the timers were last checked
+	unsigned timer_ticks = 0;
+
+	// the running handler has started socket operations the io_engine has not submitted yet
+	bool io_submit_pending = false;
+};
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // MY_ASIO_DETAIL_THREAD_INFO_HPP
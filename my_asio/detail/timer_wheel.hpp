@@ -0,0 +1,311 @@
+#ifndef MY_ASIO_DETAIL_TIMER_WHEEL_HPP
+#define MY_ASIO_DETAIL_TIMER_WHEEL_HPP
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace my_asio
+{
+namespace detail
+{
+
+inline unsigned lowest_bit(uint64_t x)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return index;
+#elif defined(__GNUC__)
+	return __builtin_ctzll(x);
+#else
+	unsigned index = 0;
+	while (!(x & 1))
+	{
+		x >>= 1;
+		++index;
+	}
+	return index;
+#endif
+}
+
+inline unsigned highest_bit(uint64_t x)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, x);
+	return index;
+#elif defined(__GNUC__)
+	return 63 - __builtin_clzll(x);
+#else
+	unsigned index = 0;
+	while (x >>= 1)
+		++index;
+	return index;
+#endif
+}
+
+/*
+Hierarchical timing wheel with microsecond ticks.
+Level l has 64 slots of 64^l ticks each. An entry sits on the level of the highest base-64
+digit in which its expiry differs from the current tick, in the slot given by that digit, and
+moves down a level each time the current tick reaches its slot. Scheduling and cancelling are
+O(1), every entry is moved at most once per level.
+Occupancy bitmaps let advance() jump straight to the next occupied slot, so idle time costs nothing.
+Not thread-safe
+*/
+class timer_wheel
+{
+public:
+	using clock = std::chrono::steady_clock;
+	using tick_duration = std::chrono::microseconds;
+
+	struct entry
+	{
+		entry* prev = nullptr;
+		entry* next = nullptr;
+		uint64_t expiry = 0;
+		unsigned slot = not_scheduled;
+	};
+
+	timer_wheel()
+		: origin_(clock::now())
+		, current_tick_(0)
+		, size_(0)
+		, occupied_()
+		, slots_()
+	{	}
+
+	timer_wheel(const timer_wheel&) = delete;
+	timer_wheel& operator=(const timer_wheel&) = delete;
+
+	bool empty() const
+	{
+		return size_ == 0;
+	}
+
+	size_t size() const
+	{
+		return size_;
+	}
+
+	static bool scheduled(const entry& e)
+	{
+		return e.slot != not_scheduled;
+	}
+
+	// an entry expiring at or before the current tick is due on the next advance()
+	void schedule(entry& e, clock::time_point expiry)
+	{
+		e.expiry = expiry_tick(expiry);
+		place(e);
+		++size_;
+	}
+
+	void cancel(entry& e)
+	{
+		if (!scheduled(e))
+			return;
+
+		unlink(e);
+		--size_;
+	}
+
+	// calls on_expired(entry&) for every entry expired by now, in expiry order. The entries are
+	// unscheduled before the call
+	template<typename Function>
+	void advance(clock::time_point now, Function&& on_expired)
+	{
+		const uint64_t now_tick = elapsed_ticks(now);
+
+		expire_slot(due_slot, on_expired);
+
+		while (size_ && current_tick_ < now_tick)
+		{
+			const uint64_t tick = next_event_tick();
+			if (tick > now_tick)
+				break;
+
+			current_tick_ = tick;
+
+			// coarser slots first, their entries cascade into the finer slots of the same tick
+			for (unsigned level = levels; level-- != 0;)
+			{
+				const unsigned shift = level * slot_bits;
+				if (level != 0 && (current_tick_ & ((uint64_t(1) << shift) - 1)) != 0)
+					continue;
+
+				expire_slot(level * slots_per_level + unsigned((current_tick_ >> shift) & slot_mask), on_expired);
+			}
+		}
+
+		if (current_tick_ < now_tick)
+			current_tick_ = now_tick;
+	}
+
+	// when advance() next has something to do, either an expiry or an entry moving down a level.
+	// clock::time_point::max() if the wheel is empty
+	clock::time_point next_event() const
+	{
+		if (size_ == 0)
+			return clock::time_point::max();
+
+		const uint64_t tick = next_event_tick();
+		if (tick >= max_tick())
+			return clock::time_point::max();
+
+		return origin_ + tick_duration(tick);
+	}
+
+private:
+	static constexpr unsigned slot_bits = 6;
+	static constexpr unsigned slots_per_level = 1u << slot_bits;
+	static constexpr uint64_t slot_mask = slots_per_level - 1;
+	static constexpr unsigned levels = (64 + slot_bits - 1) / slot_bits;
+
+	// entries that were already expired when scheduled
+	static constexpr unsigned due_slot = levels * slots_per_level;
+	static constexpr unsigned not_scheduled = due_slot + 1;
+
+	struct slot_list
+	{
+		entry* head;
+		entry* tail;
+	};
+
+	uint64_t max_tick() const
+	{
+		return uint64_t(std::chrono::duration_cast<tick_duration>(clock::time_point::max() - origin_).count());
+	}
+
+	// the first tick at which the expiry has been reached
+	uint64_t expiry_tick(clock::time_point expiry) const
+	{
+		if (expiry <= origin_)
+			return 0;
+
+		const clock::duration since_origin = expiry - origin_;
+		tick_duration ticks = std::chrono::duration_cast<tick_duration>(since_origin);
+		if (ticks < since_origin)
+			++ticks;
+		return uint64_t(ticks.count());
+	}
+
+	uint64_t elapsed_ticks(clock::time_point now) const
+	{
+		if (now <= origin_)
+			return 0;
+
+		return uint64_t(std::chrono::duration_cast<tick_duration>(now - origin_).count());
+	}
+
+	// every occupied slot lies after the current tick, and the finest occupied level holds the earliest
+	uint64_t next_event_tick() const
+	{
+		if (slots_[due_slot].head)
+			return current_tick_;
+
+		for (unsigned level = 0; level != levels; ++level)
+		{
+			if (!occupied_[level])
+				continue;
+
+			const unsigned shift = level * slot_bits;
+			const unsigned upper_shift = shift + slot_bits;
+			const uint64_t upper = upper_shift < 64 ? (current_tick_ >> upper_shift) << upper_shift : 0;
+			return upper | (uint64_t(lowest_bit(occupied_[level])) << shift);
+		}
+
+		return current_tick_;
+	}
+
+	void place(entry& e)
+	{
+		if (e.expiry <= current_tick_)
+		{
+			link(e, due_slot);
+			return;
+		}
+
+		const unsigned level = highest_bit(e.expiry ^ current_tick_) / slot_bits;
+		const unsigned index = unsigned((e.expiry >> (level * slot_bits)) & slot_mask);
+		occupied_[level] |= uint64_t(1) << index;
+		link(e, level * slots_per_level + index);
+	}
+
+	void link(entry& e, unsigned slot)
+	{
+		slot_list& list = slots_[slot];
+		e.slot = slot;
+		e.next = nullptr;
+		e.prev = list.tail;
+		if (list.tail)
+			list.tail->next = &e;
+		else
+			list.head = &e;
+		list.tail = &e;
+	}
+
+	void unlink(entry& e)
+	{
+		slot_list& list = slots_[e.slot];
+		if (e.prev)
+			e.prev->next = e.next;
+		else
+			list.head = e.next;
+		if (e.next)
+			e.next->prev = e.prev;
+		else
+			list.tail = e.prev;
+
+		if (!list.head && e.slot != due_slot)
+			occupied_[e.slot / slots_per_level] &= ~(uint64_t(1) << (e.slot % slots_per_level));
+
+		e.prev = e.next = nullptr;
+		e.slot = not_scheduled;
+	}
+
+	// expires the entries of the slot that are due and moves the others down
+	template<typename Function>
+	void expire_slot(unsigned slot, Function& on_expired)
+	{
+		entry* e = slots_[slot].head;
+		if (!e)
+			return;
+
+		slots_[slot].head = slots_[slot].tail = nullptr;
+		if (slot != due_slot)
+			occupied_[slot / slots_per_level] &= ~(uint64_t(1) << (slot % slots_per_level));
+
+		while (e)
+		{
+			entry* next = e->next;
+			if (e->expiry <= current_tick_)
+			{
+				e->prev = e->next = nullptr;
+				e->slot = not_scheduled;
+				--size_;
+				on_expired(*e);
+			}
+			else
+			{
+				place(*e);
+			}
+			e = next;
+		}
+	}
+
+	const clock::time_point origin_;
+	uint64_t current_tick_;
+	size_t size_;
+	uint64_t occupied_[levels];
+	slot_list slots_[due_slot + 1];
+};
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // MY_ASIO_DETAIL_TIMER_WHEEL_HPP
\ No newline at end of file
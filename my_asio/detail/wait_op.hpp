@@ -0,0 +1,64 @@
+#ifndef MY_ASIO_DETAIL_WAIT_OP_HPP
+#define MY_ASIO_DETAIL_WAIT_OP_HPP
+
+#include <new>
+#include <system_error>
+#include <utility>
+
+#include "async_op.hpp"
+#include "recycling_allocator.hpp"
+#include "timer_wheel.hpp"
+
+namespace my_asio
+{
+namespace detail
+{
+
+// A pending async_wait, the handler is invoked as handler(ec)
+template<typename Handler>
+class wait_handler : public async_op
+{
+public:
+	// the op is allocated from the calling thread's memory cache
+	template<typename H>
+	static async_op* create(H&& handler)
+	{
+		void* p = thread_memory_cache::allocate(sizeof(wait_handler));
+		return new (p) wait_handler(std::forward<H>(handler));
+	}
+
+private:
+	template<typename H>
+	explicit wait_handler(H&& handler)
+		: async_op(&wait_handler::do_complete)
+		, handler_(std::forward<H>(handler))
+	{	}
+
+	// the handler is moved out and the memory released before the upcall, so the handler can start a new wait
+	static void do_complete(async_op* base, bool invoke)
+	{
+		wait_handler* op = static_cast<wait_handler*>(base);
+		Handler handler(std::move(op->handler_));
+		const std::error_code ec = op->ec;
+
+		op->~wait_handler();
+		thread_memory_cache::deallocate(op, sizeof(wait_handler));
+
+		if (invoke)
+			handler(ec);
+	}
+
+	Handler handler_;
+};
+
+// The io_context side of a steady_timer: its place in the timer wheel and the waits on it
+struct timer_data : timer_wheel::entry
+{
+	async_op* first_waiter = nullptr;
+	async_op* last_waiter = nullptr;
+};
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // MY_ASIO_DETAIL_WAIT_OP_HPP
\ No newline at end of file
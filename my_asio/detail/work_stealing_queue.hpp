@@ -0,0 +1,89 @@
+#ifndef MY_ASIO_DETAIL_WORK_STEALING_QUEUE_HPP
+#define MY_ASIO_DETAIL_WORK_STEALING_QUEUE_HPP
+
+#include <atomic>
+#include <mutex>
+
+#include "handler_queue.hpp"
+
+namespace my_asio
+{
+namespace detail
+{
+
+// Local FIFO of a worker thread, the owner pushes and pops, idle peers steal half of it.
+// The lock is almost always uncontended since only thieves compete with the owner
+class work_stealing_queue
+{
+public:
+	work_stealing_queue()
+		: size_(0)
+	{	}
+
+	work_stealing_queue(const work_stealing_queue&) = delete;
+	const work_stealing_queue& operator=(const work_stealing_queue&) = delete;
+
+	void push(any_handler&& handler)
+	{
+		std::lock_guard<std::mutex> lock(guard_);
+		handlers_.push_back(std::move(handler));
+		size_.store(handlers_.size(), std::memory_order_release);
+	}
+
+	bool try_pop(any_handler& handler)
+	{
+		if (empty())
+			return false;
+
+		std::lock_guard<std::mutex> lock(guard_);
+		if (handlers_.empty())
+			return false;
+
+		handler = std::move(handlers_.front());
+		handlers_.pop_front();
+		size_.store(handlers_.size(), std::memory_order_release);
+		return true;
+	}
+
+	// moves the older half of victim's handlers to this queue, the oldest one is returned in handler
+	bool steal_from(work_stealing_queue& victim, any_handler& handler)
+	{
+		if (victim.empty())
+			return false;
+
+		std::unique_lock<std::mutex> lock(guard_, std::defer_lock);
+		std::unique_lock<std::mutex> victim_lock(victim.guard_, std::defer_lock);
+		std::lock(lock, victim_lock);
+
+		const size_t count = (victim.handlers_.size() + 1) / 2;
+		if (count == 0)
+			return false;
+
+		handler = std::move(victim.handlers_.front());
+		victim.handlers_.pop_front();
+		for (size_t i = 1; i != count; ++i)
+		{
+			handlers_.push_back(std::move(victim.handlers_.front()));
+			victim.handlers_.pop_front();
+		}
+
+		victim.size_.store(victim.handlers_.size(), std::memory_order_release);
+		size_.store(handlers_.size(), std::memory_order_release);
+		return true;
+	}
+
+	bool empty() const
+	{
+		return size_.load(std::memory_order_acquire) == 0;
+	}
+
+private:
+	std::mutex guard_;
+	handler_deque handlers_;
+	std::atomic<size_t> size_;
+};
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // MY_ASIO_DETAIL_WORK_STEALING_QUEUE_HPP
@@ -0,0 +1,257 @@
+#ifndef MY_ASIO_ANY_HANDLER_HPP
+#define MY_ASIO_ANY_HANDLER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "recycling_allocator.hpp"
+
+namespace my_asio
+{
+
+#if defined(MY_ASIO_ENABLE_HANDLER_TRACKING)
+namespace detail
+{
+
+class handler_tracking;
+
+} // namespace detail
+#endif
+
+/*
+Move-only type-erased void() callable. Callables that fit into the inline buffer and are
+nothrow move constructible are stored in place, larger ones are allocated from the
+thread's recycling memory cache.
+The whole object occupies a single cache line, also with the trace id of handler tracking
+*/
+class any_handler
+{
+public:
+	static constexpr std::size_t inline_size = 48;
+	static constexpr std::size_t inline_alignment = alignof(std::max_align_t);
+
+	any_handler() noexcept
+		: vtable_(nullptr)
+	{	}
+
+	any_handler(std::nullptr_t) noexcept
+		: vtable_(nullptr)
+	{	}
+
+	template<typename F, typename = typename std::enable_if<
+		!std::is_same<typename std::decay<F>::type, any_handler>::value>::type>
+	any_handler(F&& f)
+		: vtable_(&vtable_for<typename std::decay<F>::type>::value)
+	{
+		using handler_type = typename std::decay<F>::type;
+		construct<handler_type>(std::forward<F>(f), is_inline<handler_type>());
+	}
+
+	any_handler(any_handler&& other) noexcept
+		: vtable_(other.vtable_)
+#if defined(MY_ASIO_ENABLE_HANDLER_TRACKING)
+		, trace_id_(other.trace_id_)
+#endif
+	{
+		if (vtable_)
+		{
+			vtable_->move(&storage_, &other.storage_);
+			other.vtable_ = nullptr;
+		}
+	}
+
+	any_handler(const any_handler&) = delete;
+	any_handler& operator=(const any_handler&) = delete;
+
+	~any_handler()
+	{
+		reset();
+	}
+
+	any_handler& operator=(any_handler&& other) noexcept
+	{
+		if (this != &other)
+		{
+			reset();
+			if (other.vtable_)
+			{
+				other.vtable_->move(&storage_, &other.storage_);
+				vtable_ = other.vtable_;
+				other.vtable_ = nullptr;
+			}
+#if defined(MY_ASIO_ENABLE_HANDLER_TRACKING)
+			trace_id_ = other.trace_id_;
+#endif
+		}
+		return *this;
+	}
+
+	any_handler& operator=(std::nullptr_t) noexcept
+	{
+		reset();
+		return *this;
+	}
+
+	explicit operator bool() const noexcept
+	{
+		return vtable_ != nullptr;
+	}
+
+	void operator()()
+	{
+		vtable_->invoke(&storage_);
+	}
+
+	// the stored callable if it is an F, as std::function::target()
+	template<typename F>
+	F* target() noexcept
+	{
+		if (vtable_ != &vtable_for<F>::value)
+			return nullptr;
+		return is_inline<F>::value ? reinterpret_cast<F*>(&storage_) : *reinterpret_cast<F**>(&storage_);
+	}
+
+private:
+#if defined(MY_ASIO_ENABLE_HANDLER_TRACKING)
+	friend class detail::handler_tracking;
+#endif
+
+	struct vtable
+	{
+		void (*invoke)(void* storage);
+		void (*move)(void* to, void* from) noexcept;
+		void (*destroy)(void* storage) noexcept;
+	};
+
+	template<typename F>
+	using is_inline = std::integral_constant<bool,
+		sizeof(F) <= inline_size
+		&& alignof(F) <= inline_alignment
+		&& std::is_nothrow_move_constructible<F>::value>;
+
+	template<typename F>
+	using is_recyclable = std::integral_constant<bool, alignof(F) <= alignof(std::max_align_t)>;
+
+	template<typename F>
+	struct inline_ops
+	{
+		static void invoke(void* storage)
+		{
+			(*static_cast<F*>(storage))();
+		}
+
+		static void move(void* to, void* from) noexcept
+		{
+			new (to) F(std::move(*static_cast<F*>(from)));
+			static_cast<F*>(from)->~F();
+		}
+
+		static void destroy(void* storage) noexcept
+		{
+			static_cast<F*>(storage)->~F();
+		}
+	};
+
+	template<typename F>
+	struct heap_ops
+	{
+		static void invoke(void* storage)
+		{
+			(**static_cast<F**>(storage))();
+		}
+
+		static void move(void* to, void* from) noexcept
+		{
+			*static_cast<F**>(to) = *static_cast<F**>(from);
+		}
+
+		static void destroy(void* storage) noexcept
+		{
+			F* f = *static_cast<F**>(storage);
+			f->~F();
+			deallocate_heap<F>(f, is_recyclable<F>());
+		}
+	};
+
+	template<typename F>
+	struct vtable_for
+	{
+		using ops = typename std::conditional<is_inline<F>::value, inline_ops<F>, heap_ops<F>>::type;
+		static const vtable value;
+	};
+
+	template<typename F, typename Arg>
+	void construct(Arg&& f, std::true_type)
+	{
+		new (&storage_) F(std::forward<Arg>(f));
+	}
+
+	template<typename F, typename Arg>
+	void construct(Arg&& f, std::false_type)
+	{
+		void* p = allocate_heap<F>(is_recyclable<F>());
+		try
+		{
+			*reinterpret_cast<F**>(&storage_) = new (p) F(std::forward<Arg>(f));
+		}
+		catch (...)
+		{
+			deallocate_heap<F>(p, is_recyclable<F>());
+			throw;
+		}
+	}
+
+	template<typename F>
+	static void* allocate_heap(std::true_type)
+	{
+		return detail::thread_memory_cache::allocate(sizeof(F));
+	}
+
+	template<typename F>
+	static void* allocate_heap(std::false_type)
+	{
+		return std::allocator<F>().allocate(1);
+	}
+
+	template<typename F>
+	static void deallocate_heap(void* p, std::true_type) noexcept
+	{
+		detail::thread_memory_cache::deallocate(p, sizeof(F));
+	}
+
+	template<typename F>
+	static void deallocate_heap(void* p, std::false_type) noexcept
+	{
+		std::allocator<F>().deallocate(static_cast<F*>(p), 1);
+	}
+
+	void reset() noexcept
+	{
+		if (vtable_)
+		{
+			vtable_->destroy(&storage_);
+			vtable_ = nullptr;
+		}
+	}
+
+	alignas(inline_alignment) unsigned char storage_[inline_size];
+	const vtable* vtable_;
+#if defined(MY_ASIO_ENABLE_HANDLER_TRACKING)
+	uint64_t trace_id_ = 0;
+#endif
+};
+
+template<typename F>
+const any_handler::vtable any_handler::vtable_for<F>::value = {
+	&any_handler::vtable_for<F>::ops::invoke,
+	&any_handler::vtable_for<F>::ops::move,
+	&any_handler::vtable_for<F>::ops::destroy
+};
+
+} // namespace my_asio
+
+#endif // MY_ASIO_ANY_HANDLER_HPP
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef MY_ASIO_ASYNC_RESULT_HPP
+#define MY_ASIO_ASYNC_RESULT_HPP
+
+#include <type_traits>
+#include <utility>
+
+namespace my_asio
+{
+
+/*
+Turns the completion token passed to an asynchronous operation into its completion handler and
+the operation's return value. Signature is the call the handler receives, e.g.
+void(std::error_code, size_t). By default the token is the handler and the operation returns
+nothing, use_awaitable specializes it to return something a coroutine can co_await
+*/
+template<typename CompletionToken, typename Signature>
+struct async_result
+{
+	using return_type = void;
+
+	template<typename Initiation, typename Handler>
+	static return_type initiate(Initiation&& initiation, Handler&& handler)
+	{
+		std::forward<Initiation>(initiation)(std::forward<Handler>(handler));
+	}
+};
+
+// starts an asynchronous operation: initiation(handler) is called with the handler made from token
+template<typename Signature, typename CompletionToken, typename Initiation>
+typename async_result<typename std::decay<CompletionToken>::type, Signature>::return_type
+async_initiate(Initiation&& initiation, CompletionToken&& token)
+{
+	return async_result<typename std::decay<CompletionToken>::type, Signature>::initiate(
+		std::forward<Initiation>(initiation), std::forward<CompletionToken>(token));
+}
+
+} // namespace my_asio
+
+#endif // MY_ASIO_ASYNC_RESULT_HPP
\ No newline at end of file
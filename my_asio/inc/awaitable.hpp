@@ -0,0 +1,572 @@
+#ifndef MY_ASIO_AWAITABLE_HPP
+#define MY_ASIO_AWAITABLE_HPP
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define MY_ASIO_HAS_CO_AWAIT 1
+#endif
+#endif
+
+#if defined(MY_ASIO_HAS_CO_AWAIT)
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <optional>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "async_result.hpp"
+#include "bind_executor.hpp"
+#include "is_executor.hpp"
+#include "recycling_allocator.hpp"
+
+namespace my_asio
+{
+
+template<typename T>
+class awaitable;
+
+// Completion token making an asynchronous operation return something a coroutine can co_await.
+// A leading error code is thrown as std::system_error, the remaining arguments are the result
+struct use_awaitable_t
+{
+	constexpr use_awaitable_t()
+	{	}
+};
+
+constexpr use_awaitable_t use_awaitable;
+
+// Completion handler of co_spawn that ignores the result, including an exception
+struct detached_t
+{
+	constexpr detached_t()
+	{	}
+
+	template<typename... Args>
+	void operator()(Args&&...) const
+	{	}
+};
+
+constexpr detached_t detached;
+
+namespace detail
+{
+
+// small enough to be stored inline by any_handler
+struct coroutine_resumer
+{
+	std::coroutine_handle<> handle;
+
+	void operator()()
+	{
+		handle.resume();
+	}
+};
+
+// A reference to the executor a coroutine runs on, io_context::executor_type or strand<Executor>
+class coroutine_executor
+{
+public:
+	coroutine_executor() noexcept
+		: executor_(nullptr)
+		, ops_(nullptr)
+	{	}
+
+	template<typename Executor>
+	explicit coroutine_executor(Executor& executor) noexcept
+		: executor_(&executor)
+		, ops_(&ops_for<Executor>::value)
+	{	}
+
+	// resumes the coroutine inline if the calling thread already runs on the executor
+	void dispatch(std::coroutine_handle<> handle) const
+	{
+		ops_->dispatch(executor_, handle);
+	}
+
+	void post(std::coroutine_handle<> handle) const
+	{
+		ops_->post(executor_, handle);
+	}
+
+private:
+	struct ops
+	{
+		void (*dispatch)(void*, std::coroutine_handle<>);
+		void (*post)(void*, std::coroutine_handle<>);
+	};
+
+	template<typename Executor>
+	struct ops_for
+	{
+		static void dispatch(void* executor, std::coroutine_handle<> handle)
+		{
+			static_cast<Executor*>(executor)->dispatch(coroutine_resumer{ handle });
+		}
+
+		static void post(void* executor, std::coroutine_handle<> handle)
+		{
+			static_cast<Executor*>(executor)->post(coroutine_resumer{ handle });
+		}
+
+		static constexpr ops value = { &dispatch, &post };
+	};
+
+	void* executor_;
+	const ops* ops_;
+};
+
+// coroutine frames are allocated from the calling thread's memory cache
+struct recycled_frame
+{
+	static void* operator new(size_t size)
+	{
+		return thread_memory_cache::allocate(size);
+	}
+
+	static void operator delete(void* p, size_t size) noexcept
+	{
+		thread_memory_cache::deallocate(p, size);
+	}
+};
+
+/*
+An awaitable starts suspended and runs when it is awaited, on the awaiting coroutine's executor.
+Awaiting it and returning from it are symmetric transfers, a chain of awaitables never goes
+through the executor. Optimizing compilers turn the transfers into tail calls, so the chain does
+not grow the stack either, GCC does not at -O0
+*/
+class awaitable_promise_base : public recycled_frame
+{
+public:
+	struct final_awaiter
+	{
+		bool await_ready() const noexcept
+		{
+			return false;
+		}
+
+		template<typename Promise>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+		{
+			return static_cast<awaitable_promise_base&>(handle.promise()).continuation_;
+		}
+
+		void await_resume() const noexcept
+		{	}
+	};
+
+	std::suspend_always initial_suspend() noexcept
+	{
+		return {};
+	}
+
+	final_awaiter final_suspend() noexcept
+	{
+		return {};
+	}
+
+	void unhandled_exception()
+	{
+		exception_ = std::current_exception();
+	}
+
+	const coroutine_executor& executor() const noexcept
+	{
+		return executor_;
+	}
+
+	void set_caller(std::coroutine_handle<> caller, const coroutine_executor& executor) noexcept
+	{
+		continuation_ = caller;
+		executor_ = executor;
+	}
+
+protected:
+	void rethrow_exception()
+	{
+		if (exception_)
+			std::rethrow_exception(exception_);
+	}
+
+private:
+	std::coroutine_handle<> continuation_;
+	coroutine_executor executor_;
+	std::exception_ptr exception_;
+};
+
+template<typename T>
+class awaitable_promise : public awaitable_promise_base
+{
+public:
+	awaitable<T> get_return_object() noexcept;
+
+	template<typename U>
+	void return_value(U&& value)
+	{
+		value_.emplace(std::forward<U>(value));
+	}
+
+	T result()
+	{
+		rethrow_exception();
+		return std::move(*value_);
+	}
+
+private:
+	std::optional<T> value_;
+};
+
+template<>
+class awaitable_promise<void> : public awaitable_promise_base
+{
+public:
+	awaitable<void> get_return_object() noexcept;
+
+	void return_void() noexcept
+	{	}
+
+	void result()
+	{
+		rethrow_exception();
+	}
+};
+
+} // namespace detail
+
+/*
+The return type of a coroutine that can be awaited by another one, or started with co_spawn.
+The frame is allocated from the memory cache of the thread that calls the coroutine
+*/
+template<typename T = void>
+class awaitable
+{
+public:
+	using promise_type = detail::awaitable_promise<T>;
+
+	awaitable(awaitable&& other) noexcept
+		: handle_(std::exchange(other.handle_, nullptr))
+	{	}
+
+	awaitable(const awaitable&) = delete;
+	awaitable& operator=(const awaitable&) = delete;
+
+	~awaitable()
+	{
+		if (handle_)
+			handle_.destroy();
+	}
+
+	bool await_ready() const noexcept
+	{
+		return false;
+	}
+
+	template<typename Promise>
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> caller) noexcept
+	{
+		handle_.promise().set_caller(caller, caller.promise().executor());
+		return handle_;
+	}
+
+	T await_resume()
+	{
+		return handle_.promise().result();
+	}
+
+private:
+	friend promise_type;
+
+	explicit awaitable(std::coroutine_handle<promise_type> handle) noexcept
+		: handle_(handle)
+	{	}
+
+	std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail
+{
+
+template<typename T>
+awaitable<T> awaitable_promise<T>::get_return_object() noexcept
+{
+	return awaitable<T>(std::coroutine_handle<awaitable_promise>::from_promise(*this));
+}
+
+inline awaitable<void> awaitable_promise<void>::get_return_object() noexcept
+{
+	return awaitable<void>(std::coroutine_handle<awaitable_promise>::from_promise(*this));
+}
+
+/*
+What co_await of an asynchronous operation started with use_awaitable suspends on. The operation is
+initiated once the coroutine has suspended, its completion handler stores the arguments here and
+dispatches the coroutine to its executor, so an operation completing on a thread running the
+io_context resumes the coroutine inline. The initiation is kept inline and the handler is a few
+pointers, nothing is allocated besides the operation itself
+*/
+template<typename... Args>
+class async_op_awaiter
+{
+public:
+	static constexpr size_t max_initiation_size = 64;
+
+	template<typename Initiation>
+	explicit async_op_awaiter(Initiation&& initiation)
+	{
+		using initiation_type = typename std::decay<Initiation>::type;
+		static_assert(sizeof(initiation_type) <= max_initiation_size && alignof(initiation_type) <= alignof(std::max_align_t),
+			"the initiation does not fit into async_op_awaiter");
+
+		new (&initiation_) initiation_type(std::forward<Initiation>(initiation));
+		initiate_ = &do_initiate<initiation_type>;
+		destroy_ = &do_destroy<initiation_type>;
+	}
+
+	// only ever used as a prvalue, guaranteed copy elision lets it be returned
+	async_op_awaiter(const async_op_awaiter&) = delete;
+	async_op_awaiter& operator=(const async_op_awaiter&) = delete;
+
+	~async_op_awaiter()
+	{
+		destroy_(&initiation_);
+	}
+
+	bool await_ready() const noexcept
+	{
+		return false;
+	}
+
+	// once the operation is initiated the coroutine may already be running on another thread
+	template<typename Promise>
+	void await_suspend(std::coroutine_handle<Promise> caller)
+	{
+		initiate_(&initiation_, handler{ this, caller, caller.promise().executor() });
+	}
+
+	auto await_resume()
+	{
+		return take_result(std::move(*result_));
+	}
+
+private:
+	using result_type = std::tuple<typename std::decay<Args>::type...>;
+
+	struct handler
+	{
+		async_op_awaiter* self;
+		std::coroutine_handle<> caller;
+		coroutine_executor executor;
+
+		template<typename... A>
+		void operator()(A&&... args)
+		{
+			self->result_.emplace(std::forward<A>(args)...);
+			executor.dispatch(caller);
+		}
+	};
+
+	template<typename Initiation>
+	static void do_initiate(void* initiation, handler&& h)
+	{
+		(*static_cast<Initiation*>(initiation))(std::move(h));
+	}
+
+	template<typename Initiation>
+	static void do_destroy(void* initiation) noexcept
+	{
+		static_cast<Initiation*>(initiation)->~Initiation();
+	}
+
+	template<typename... Values>
+	static auto take_result(std::tuple<Values...>&& values)
+	{
+		if constexpr (sizeof...(Values) == 0)
+			return;
+		else if constexpr (std::is_same<typename std::tuple_element<0, std::tuple<Values...>>::type, std::error_code>::value)
+			return take_error(std::move(values), std::make_index_sequence<sizeof...(Values) - 1>());
+		else if constexpr (sizeof...(Values) == 1)
+			return std::move(std::get<0>(values));
+		else
+			return std::move(values);
+	}
+
+	template<typename... Values, size_t... I>
+	static auto take_error(std::tuple<Values...>&& values, std::index_sequence<I...>)
+	{
+		if (std::get<0>(values))
+			throw std::system_error(std::get<0>(values));
+
+		if constexpr (sizeof...(I) == 0)
+			return;
+		else if constexpr (sizeof...(I) == 1)
+			return std::move(std::get<1>(values));
+		else
+			return std::make_tuple(std::move(std::get<I + 1>(values))...);
+	}
+
+	alignas(std::max_align_t) unsigned char initiation_[max_initiation_size];
+	void (*initiate_)(void*, handler&&);
+	void (*destroy_)(void*) noexcept;
+	std::optional<result_type> result_;
+};
+
+// The outermost frame of co_spawn, it owns the executor and the completion handler and destroys itself
+class spawn_entry
+{
+public:
+	struct promise_type : recycled_frame
+	{
+		template<typename Executor, typename... Args>
+		promise_type(Executor& executor, Args&...) noexcept
+			: executor_(executor)
+		{	}
+
+		spawn_entry get_return_object() noexcept
+		{
+			return spawn_entry{ std::coroutine_handle<promise_type>::from_promise(*this) };
+		}
+
+		// started by posting it to the executor
+		std::suspend_always initial_suspend() noexcept
+		{
+			return {};
+		}
+
+		std::suspend_never final_suspend() noexcept
+		{
+			return {};
+		}
+
+		void return_void() noexcept
+		{	}
+
+		// the body catches everything the awaitable throws
+		void unhandled_exception() noexcept
+		{
+			std::terminate();
+		}
+
+		const coroutine_executor& executor() const noexcept
+		{
+			return executor_;
+		}
+
+	private:
+		coroutine_executor executor_;
+	};
+
+	std::coroutine_handle<promise_type> handle;
+};
+
+// the completion handler is posted, so an exception it throws leaves run() like any handler's
+template<typename Executor, typename T, typename Handler>
+spawn_entry co_spawn_entry(Executor executor, awaitable<T> a, Handler handler)
+{
+	std::exception_ptr e;
+	if constexpr (std::is_void<T>::value)
+	{
+		try
+		{
+			co_await std::move(a);
+		}
+		catch (...)
+		{
+			e = std::current_exception();
+		}
+
+		executor.post(bound_call<Handler, std::exception_ptr>(std::move(handler), e));
+	}
+	else
+	{
+		std::optional<T> value;
+		try
+		{
+			value.emplace(co_await std::move(a));
+		}
+		catch (...)
+		{
+			e = std::current_exception();
+		}
+
+		executor.post(bound_call<Handler, std::exception_ptr, T>(std::move(handler), e, value ? std::move(*value) : T()));
+	}
+}
+
+template<typename Executor>
+struct initiate_post
+{
+	Executor executor;
+
+	template<typename Handler>
+	void operator()(Handler&& handler)
+	{
+		executor.post(std::forward<Handler>(handler));
+	}
+};
+
+template<typename Executor>
+struct initiate_dispatch
+{
+	Executor executor;
+
+	template<typename Handler>
+	void operator()(Handler&& handler)
+	{
+		executor.dispatch(std::forward<Handler>(handler));
+	}
+};
+
+} // namespace detail
+
+template<typename R, typename... Args>
+struct async_result<use_awaitable_t, R(Args...)>
+{
+	using return_type = detail::async_op_awaiter<Args...>;
+
+	template<typename Initiation>
+	static return_type initiate(Initiation&& initiation, use_awaitable_t)
+	{
+		return return_type(std::forward<Initiation>(initiation));
+	}
+};
+
+/*
+Runs the awaitable on the executor, io_context::executor_type or a strand, and calls
+handler(std::exception_ptr) or handler(std::exception_ptr, T) once it has finished, T is
+default constructed if the awaitable threw. The coroutine resumes on that executor after each
+asynchronous operation, a strand must outlive it
+*/
+template<typename Executor, typename T, typename CompletionHandler>
+typename enable_if_executor<Executor>::type co_spawn(Executor&& executor, awaitable<T> a, CompletionHandler&& handler)
+{
+	detail::spawn_entry entry = detail::co_spawn_entry<detail::executor_storage_t<Executor>, T, typename std::decay<CompletionHandler>::type>(
+		std::forward<Executor>(executor), std::move(a), std::forward<CompletionHandler>(handler));
+
+	entry.handle.promise().executor().post(entry.handle);
+}
+
+// co_await post(executor, use_awaitable) suspends the coroutine and resumes it from a handler posted
+// to the executor, e.g. to continue inside a strand
+template<typename Executor>
+typename enable_if_executor<Executor, detail::async_op_awaiter<>>::type post(Executor&& executor, use_awaitable_t)
+{
+	return async_initiate<void()>(detail::initiate_post<detail::executor_storage_t<Executor>>{ std::forward<Executor>(executor) }, use_awaitable);
+}
+
+// resumes inline if the coroutine already runs on the executor
+template<typename Executor>
+typename enable_if_executor<Executor, detail::async_op_awaiter<>>::type dispatch(Executor&& executor, use_awaitable_t)
+{
+	return async_initiate<void()>(detail::initiate_dispatch<detail::executor_storage_t<Executor>>{ std::forward<Executor>(executor) }, use_awaitable);
+}
+
+} // namespace my_asio
+
+#endif // defined(MY_ASIO_HAS_CO_AWAIT)
+
+#endif // MY_ASIO_AWAITABLE_HPP
\ No newline at end of file
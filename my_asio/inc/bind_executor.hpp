@@ -0,0 +1,91 @@
+#ifndef MY_ASIO_BIND_EXECUTOR_HPP
+#define MY_ASIO_BIND_EXECUTOR_HPP
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "is_executor.hpp"
+
+namespace my_asio
+{
+namespace detail
+{
+
+// A completion handler together with the arguments it is to be called with
+template<typename Handler, typename... Args>
+class bound_call
+{
+public:
+	template<typename H, typename... A>
+	explicit bound_call(H&& handler, A&&... args)
+		: handler_(std::forward<H>(handler))
+		, args_(std::forward<A>(args)...)
+	{	}
+
+	void operator()()
+	{
+		invoke(std::index_sequence_for<Args...>());
+	}
+
+private:
+	template<size_t... I>
+	void invoke(std::index_sequence<I...>)
+	{
+		handler_(std::move(std::get<I>(args_))...);
+	}
+
+	Handler handler_;
+	std::tuple<Args...> args_;
+};
+
+// copyable executors are stored by value, others (strand) by reference
+template<typename Executor>
+using executor_storage_t = typename std::conditional<
+	std::is_copy_constructible<typename std::decay<Executor>::type>::value,
+	typename std::decay<Executor>::type,
+	Executor>::type;
+
+} // namespace detail
+
+/*
+A completion handler that runs on the given executor: calling the binder dispatches the call,
+with a copy of its arguments, to the executor. Binding to a strand serializes the completions
+of asynchronous operations with the strand's other handlers.
+A binder is called at most once
+*/
+template<typename Handler, typename Executor>
+class executor_binder
+{
+public:
+	template<typename E, typename H>
+	executor_binder(E&& executor, H&& handler)
+		: executor_(std::forward<E>(executor))
+		, handler_(std::forward<H>(handler))
+	{	}
+
+	template<typename... Args>
+	void operator()(Args&&... args)
+	{
+		executor_.dispatch(detail::bound_call<Handler, typename std::decay<Args>::type...>(
+			std::move(handler_), std::forward<Args>(args)...));
+	}
+
+private:
+	Executor executor_;
+	Handler handler_;
+};
+
+template<typename Executor, typename Handler>
+executor_binder<typename std::decay<Handler>::type, detail::executor_storage_t<Executor>>
+bind_executor(Executor&& executor, Handler&& handler)
+{
+	static_assert(is_executor<typename std::decay<Executor>::type>::value, "bind_executor requires an executor");
+
+	return executor_binder<typename std::decay<Handler>::type, detail::executor_storage_t<Executor>>(
+		std::forward<Executor>(executor), std::forward<Handler>(handler));
+}
+
+} // namespace my_asio
+
+#endif // MY_ASIO_BIND_EXECUTOR_HPP
\ No newline at end of file
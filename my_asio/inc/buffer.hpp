@@ -0,0 +1,108 @@
+#ifndef MY_ASIO_BUFFER_HPP
+#define MY_ASIO_BUFFER_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace my_asio
+{
+
+// A non-owning view of writable memory, the memory must stay valid until the operation using it completes
+class mutable_buffer
+{
+public:
+	mutable_buffer()
+		: data_(nullptr)
+		, size_(0)
+	{	}
+
+	mutable_buffer(void* data, size_t size)
+		: data_(data)
+		, size_(size)
+	{	}
+
+	void* data() const { return data_; }
+
+	size_t size() const { return size_; }
+
+private:
+	void* data_;
+	size_t size_;
+};
+
+// A non-owning view of readable memory, the memory must stay valid until the operation using it completes
+class const_buffer
+{
+public:
+	const_buffer()
+		: data_(nullptr)
+		, size_(0)
+	{	}
+
+	const_buffer(const void* data, size_t size)
+		: data_(data)
+		, size_(size)
+	{	}
+
+	const_buffer(const mutable_buffer& buffer)
+		: data_(buffer.data())
+		, size_(buffer.size())
+	{	}
+
+	const void* data() const { return data_; }
+
+	size_t size() const { return size_; }
+
+private:
+	const void* data_;
+	size_t size_;
+};
+
+inline mutable_buffer buffer(void* data, size_t size)
+{
+	return mutable_buffer(data, size);
+}
+
+inline const_buffer buffer(const void* data, size_t size)
+{
+	return const_buffer(data, size);
+}
+
+template<typename T, size_t N>
+mutable_buffer buffer(T (&data)[N])
+{
+	return mutable_buffer(data, sizeof(data));
+}
+
+template<typename T, size_t N>
+const_buffer buffer(const T (&data)[N])
+{
+	return const_buffer(data, sizeof(data));
+}
+
+template<typename T, typename Allocator>
+mutable_buffer buffer(std::vector<T, Allocator>& data)
+{
+	return mutable_buffer(data.data(), data.size() * sizeof(T));
+}
+
+template<typename T, typename Allocator>
+const_buffer buffer(const std::vector<T, Allocator>& data)
+{
+	return const_buffer(data.data(), data.size() * sizeof(T));
+}
+
+inline mutable_buffer buffer(std::string& data)
+{
+	return mutable_buffer(&data[0], data.size());
+}
+
+inline const_buffer buffer(const std::string& data)
+{
+	return const_buffer(data.data(), data.size());
+}
+
+} // namespace my_asio
+
+#endif // MY_ASIO_BUFFER_HPP
\ No newline at end of file
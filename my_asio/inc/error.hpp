@@ -0,0 +1,57 @@
+#ifndef MY_ASIO_ERROR_HPP
+#define MY_ASIO_ERROR_HPP
+
+#include <string>
+#include <system_error>
+
+namespace my_asio
+{
+namespace error
+{
+
+// Errors that have no std::errc equivalent. Cancelled operations complete with std::errc::operation_canceled
+enum misc_errors
+{
+	eof = 1	// the peer closed the connection
+};
+
+inline const std::error_category& get_misc_category()
+{
+	class misc_category : public std::error_category
+	{
+	public:
+		const char* name() const noexcept override
+		{
+			return "my_asio.misc";
+		}
+
+		std::string message(int value) const override
+		{
+			if (value == eof)
+				return "End of file";
+			return "my_asio.misc error";
+		}
+	};
+
+	static const misc_category category;
+	return category;
+}
+
+inline std::error_code make_error_code(misc_errors e)
+{
+	return std::error_code(static_cast<int>(e), get_misc_category());
+}
+
+} // namespace error
+} // namespace my_asio
+
+namespace std
+{
+
+template<>
+struct is_error_code_enum<my_asio::error::misc_errors> : true_type
+{	};
+
+} // namespace std
+
+#endif // MY_ASIO_ERROR_HPP
\ No newline at end of file
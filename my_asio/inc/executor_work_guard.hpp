@@ -12,6 +12,8 @@ class executor_work_guard
 public:
 	using executor_type = Executor;
 
+	static_assert(is_executor<Executor>::value, "executor_work_guard requires an executor");
+
 	// Constructor
 	executor_work_guard(const executor_type& executor)
 		: owns_work_(true)
@@ -32,8 +34,10 @@ public:
 	// Move constructor
 	executor_work_guard(executor_work_guard&& other)
 		: owns_work_(other.owns_work_)
-		, executor_(std::move(other.executor))
-	{ }
+		, executor_(std::move(other.executor_))
+	{
+		other.owns_work_ = false;
+	}
 
 	~executor_work_guard()
 	{
@@ -59,6 +63,18 @@ private:
 	executor_type executor_;
 };
 
+template<typename Executor>
+typename enable_if_executor<Executor, executor_work_guard<typename std::decay<Executor>::type>>::type
+make_work_guard(Executor&& executor)
+{
+	return executor_work_guard<typename std::decay<Executor>::type>(std::forward<Executor>(executor));
+}
+
+inline executor_work_guard<io_context::executor_type> make_work_guard(io_context& io)
+{
+	return executor_work_guard<io_context::executor_type>(io.get_executor());
+}
+
 } // namespace my_asio
 
 #endif // EXECUTOR_WORK_GUARD_HPP
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef MY_ASIO_HANDLER_TRACE_HPP
+#define MY_ASIO_HANDLER_TRACE_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace my_asio
+{
+
+// true if my_asio is built with MY_ASIO_ENABLE_HANDLER_TRACKING (cmake -DMY_ASIO_HANDLER_TRACKING=ON)
+#if defined(MY_ASIO_ENABLE_HANDLER_TRACKING)
+constexpr bool handler_tracking_enabled = true;
+#else
+constexpr bool handler_tracking_enabled = false;
+#endif
+
+// trace events kept per thread, the oldest are overwritten
+constexpr size_t handler_trace_capacity = 8192;
+
+/*
+The handler trace of every thread in the Chrome trace event format, for chrome://tracing
+or ui.perfetto.dev. Each handler run is a slice on the thread that ran it, with its id, the
+id of its causal parent (the handler that posted it), its strand and the time it spent
+queued, and a flow arrow from its post. Empty if handler tracking is not compiled in
+*/
+std::string handler_trace_json();
+
+// drops the events recorded so far
+void clear_handler_trace();
+
+} // namespace my_asio
+
+#endif // MY_ASIO_HANDLER_TRACE_HPP
\ No newline at end of file
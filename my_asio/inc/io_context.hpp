@@ -1,32 +1,95 @@
 #ifndef MY_ASIO_IO_CONTEXT_HPP
 #define MY_ASIO_IO_CONTEXT_HPP
 
-#include <queue>
-#include <functional>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
-
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "admission_control.hpp"
+#include "any_handler.hpp"
+#include "async_result.hpp"
+#include "is_executor.hpp"
+#include "metrics.hpp"
+#include "queue_limits.hpp"
 #include "call_stack.hpp"
+#include "io_engine.hpp"
+#include "handler_queue.hpp"
+#include "thread_info.hpp"
+#include "timer_wheel.hpp"
+#include "wait_op.hpp"
 
 namespace my_asio
 {
 
+// Implementation of the ready handler queue, selected when an io_context is constructed
+enum class queue_backend
+{
+	mutex,		// std::queue guarded by a single mutex
+	lock_free	// bounded lock-free MPMC ring that spills into a locked overflow queue
+};
+
+// How handlers are distributed between the threads running an io_context
+enum class scheduler_mode
+{
+	shared_queue,	// every thread pulls from the single shared queue
+	work_stealing	// handlers posted from inside a handler go to the worker's local queue, idle workers steal
+};
+
+// How socket operations are carried out, selected when an io_context is constructed
+enum class io_backend
+{
+	epoll,		// edge-triggered readiness notification, the operations are performed by the threads running the io_context
+	io_uring	// the operations are submitted to the kernel in batches, falls back to epoll where io_uring is not available
+};
+
+// Scheduling class of a handler, see priority_executor
+enum class handler_priority
+{
+	high,		// control plane: health checks, shutdown, configuration
+	normal,		// everything posted through io_context::executor_type
+	low			// background work
+};
+
+class priority_executor;
+
+namespace detail
+{
+
+class reactive_socket;
+struct io_context_metrics_state;
+
+} // namespace detail
+
 class io_context
 {
 public:
 	class executor_type;
 	friend class executor_type;
+	friend class steady_timer;
+	friend class priority_executor;
+	friend class detail::reactive_socket;
+	template<typename> friend class detail::admitted_handler;
+	template<typename> friend struct detail::initiate_post_when_ready;
 
 	io_context(const io_context&) = delete;	
 	const io_context& operator=(const io_context&) = delete;
 
-	io_context()
-		: stopped_(0)
-		, outstanding_work_(0)
-	{	}
+	explicit io_context(queue_backend backend = queue_backend::mutex, scheduler_mode mode = scheduler_mode::shared_queue,
+		io_backend io = io_backend::epoll);
 
-	~io_context()
-	{	}
+	explicit io_context(scheduler_mode mode);
+
+	explicit io_context(io_backend io);
+
+	// a concurrency_hint of 1 promises that at most one thread at a time runs the io_context.
+	// Handlers posted from that thread are then queued without locking, other threads post
+	// through a lock-free inbox. Any other hint is the same as io_context()
+	explicit io_context(int concurrency_hint);
+
+	~io_context();
 
 	executor_type get_executor();
 
@@ -44,18 +107,236 @@ public:
 
 	void restart();
 
+	// run() and poll() take up to batch_size handlers from the shared queue per lock acquisition,
+	// stop() is still honoured between handlers. 1 (the default) disables batching
+	void set_batch_size(size_t batch_size);
+
+	size_t batch_size() const;
+
+	// when a handler defers a single handler, that continuation runs next on the same thread while
+	// its data is still in the cache, ahead of the queue but not of high and low priority handlers.
+	// After limit continuations in a row the next one is queued, so the queue is not starved.
+	// One interrupted by stop() goes back to the front of the queue. 0 turns this off, the default is 8.
+	// Posts to the local queues of scheduler_mode::work_stealing are not affected
+	void set_next_handler_limit(unsigned limit);
+
+	// while handlers of several priorities are queued, each is picked in proportion to its
+	// weight, so a busy priority can not starve the lower ones. The defaults are 8, 4 and 1
+	void set_priority_weights(unsigned high, unsigned normal, unsigned low);
+
+	// bounds the handlers queued through the executors, see queue_limits. Counting starts with
+	// the first call, handlers queued before are not counted. Completions of timers and socket
+	// operations are never counted, their work is accounted for when they are started
+	void set_queue_limits(const queue_limits& limits);
+
+	// the counted handlers that have not started yet, 0 without queue limits
+	size_t queued_handlers() const;
+
+	// io_backend::epoll if io_uring has been asked for but is not available
+	io_backend io_backend_in_use() const;
+
+	// starts collecting metrics. Counters are exact, the queue wait and run time of one in
+	// sample_interval handlers are measured. Once enabled metrics stay on, later calls do nothing
+	void enable_metrics(unsigned sample_interval = 64);
+
+	// a snapshot, io_context_metrics::enabled is false if enable_metrics() has not been called
+	io_context_metrics metrics() const;
+
 private:
-	size_t do_one(bool blocking);
+	class thread_context;
+
+	io_context(queue_backend backend, scheduler_mode mode, io_backend io, bool single_threaded);
+
+	// run(), run_one(), poll() and poll_one()
+	size_t run_handlers(bool blocking, size_t max_handlers);
+
+	size_t do_one(detail::thread_info& this_thread, bool blocking);
+
+	// records the handler's metrics, submits the operations it started and queues the handlers it deferred
+	void handler_finished(detail::thread_info& this_thread, detail::io_context_metrics_state* metrics,
+		std::chrono::steady_clock::time_point started);
+
+	// counts the work of the handlers and queues them as one batch
+	void post_handlers(any_handler* handlers, size_t count);
+
+	// counts the work of a handler and queues it, other threads can run it right away
+	void post_handler(any_handler&& handler);
+
+	// post_handler() for a continuation. From inside a handler it is kept on the thread until
+	// that handler returns, then handed to the shared queue together with the other ones
+	void defer_handler(any_handler&& handler);
+
+	// post_handler() behind the queued handlers, even as the only continuation of a handler
+	void yield_handler(any_handler&& handler);
+
+	// post_handler() if the queue limits have room for the handler
+	bool try_post_handler(any_handler&& handler);
+
+	// queues the waiter's handler once the queue limits have room for it, then its completion
+	void post_when_ready_handler(std::unique_ptr<detail::admission_waiter> waiter);
+
+	// counts the handler against the queue limits, if there are any
+	void admit_handler(any_handler& handler);
+
+	// called by a counted handler when it starts running or is destroyed
+	void release_admission();
+
+	void admit_waiter(std::unique_ptr<detail::admission_waiter> waiter);
 
+	// post_handler(), or defer_handler() for a continuation, without counting the handler against the queue limits
+	void enqueue_handler(any_handler&& handler, bool continuation = false);
+
+	// handlers of high and low priority go straight to the queue of their priority
+	void post_handler(any_handler&& handler, handler_priority priority);
+
+	// moves the handlers posted by the current handler to the shared queue. The work of
+	// finished_handlers already counted handlers is retired in the same update
+	void flush_private_handlers(detail::thread_info& this_thread, size_t finished_handlers);
+
+	bool try_pop_handler(detail::thread_info& this_thread, any_handler& handler);
+
+	// pops from the priority picked by the weighted round, or from any other that has handlers
+	bool try_pop_prioritized_handler(detail::thread_info& this_thread, any_handler& handler);
+
+	// the handlers of normal priority: the batch, the local queue and the shared queue
+	bool try_pop_normal_handler(detail::thread_info& this_thread, any_handler& handler);
+
+	bool normal_handlers_queued(detail::thread_info& this_thread);
+
+	bool try_pop_shared_handler(detail::thread_info& this_thread, any_handler& handler);
+
+	bool try_steal_handler(detail::thread_info& this_thread, any_handler& handler);
+
+	// true if no handler is queued, neither in the shared queue nor in any worker's local queue
+	bool all_queues_empty();
+
+	void register_worker(detail::thread_info& this_thread);
+
+	void unregister_worker(detail::thread_info& this_thread);
+
+	// from a thread running the io_context, the work is settled with the thread's work credits
 	void work_started();
 
 	void work_finished();
 
+	// counts started work, using up the thread's work credits first
+	void work_started(detail::thread_info& this_thread, size_t count);
+
+	// leaves finished work to the thread's credits, retired together later
+	void work_finished(detail::thread_info& this_thread, size_t count);
+
+	// retires the thread's work credits, stops the io_context if no work is left
+	void retire_work_credits(detail::thread_info& this_thread);
+
+	// spins for a short, adaptively sized period waiting for a handler to be queued
+	bool spin_for_work();
+
+	// parks the calling thread until a handler is queued or the context is stopped
+	void wait_for_work();
+
+	// wakes one parked thread after a handler has been queued
+	void wake_one_idle_thread();
+
+	void wake_idle_threads(size_t count);
+
+	// called with wakeup_guard_ held. Threads waiting for handlers are woken first, the
+	// thread blocked in the reactor is interrupted if there are not enough of them
+	void notify_idle_threads(size_t count);
+
+	// wakes every parked thread, including the one blocked in the reactor
+	void notify_all_idle_threads();
+
+	// queues the wait until the timer expires. Its work stays counted until the handler has run
+	void schedule_timer(detail::timer_data& timer, std::chrono::steady_clock::time_point expiry, detail::async_op* op);
+
+	// completes every wait on the timer with operation_canceled, returns how many there were
+	size_t cancel_timer(detail::timer_data& timer);
+
+	// true if the timer wheel has expired timers, or timers to move down a level
+	bool timers_due() const;
+
+	// queues the handlers of the timers that have expired
+	void run_expired_timers();
+
+	// hands completed operations to the shared queue, their work has been counted when they were started
+	void post_completed_ops(detail::async_op* ops);
+
+	// called with timers_guard_ held
+	void update_next_timer_event();
+
+#if defined(MY_ASIO_HAS_EPOLL)
+	// the epoll_reactor is created when the first socket is opened, the io_uring_engine with the io_context
+	detail::io_engine& reactor();
+
+	// counts the work of the op, like executor_type::on_work_started. The epoll_reactor performs it right
+	// away if the descriptor is ready, the io_uring_engine submits it once the calling handler has returned
+	void start_reactor_op(detail::io_engine::descriptor_state* state, detail::io_engine::op_type type, detail::reactor_op* op);
+
+	// queues the operations made ready by descriptor events, without blocking
+	bool poll_reactor();
+#endif
+
 	std::atomic<bool> stopped_;
+
+	// includes the work credits of the threads running the io_context, so it only drops to zero
+	// once they have run out of handlers
 	std::atomic<size_t> outstanding_work_;
 
-	std::mutex queue_guard_;
-	std::queue<std::function<void()>> work_queue_;
+	// set once by set_queue_limits(), null while the queue is unbounded. Declared before the
+	// queues, so the counted handlers still queued can release their slots when they are destroyed
+	std::once_flag admission_once_;
+	std::unique_ptr<detail::admission_control> admission_owner_;
+	std::atomic<detail::admission_control*> admission_;
+
+	std::unique_ptr<detail::handler_queue> work_queue_;
+	std::atomic<size_t> batch_size_;
+	std::atomic<unsigned> next_handler_limit_;
+
+	// handlers of high and low priority, normal ones are in work_queue_. While prioritized_handlers_
+	// is zero the queues are not looked at. The weighted round is protected by priority_guard_
+	static constexpr size_t priority_levels = 3;
+	std::unique_ptr<detail::handler_queue> priority_queues_[priority_levels];
+	std::atomic<size_t> prioritized_handlers_;
+	std::mutex priority_guard_;
+	unsigned priority_weights_[priority_levels];
+	unsigned priority_credits_[priority_levels];
+
+	// set by a concurrency_hint of 1, work_queue_ is a single_consumer_handler_queue
+	const bool single_threaded_;
+
+	// work stealing, workers_ is protected by workers_guard_
+	const scheduler_mode mode_;
+	std::mutex workers_guard_;
+	std::vector<detail::work_stealing_queue*> workers_;
+
+	// idle wait, wakeup_guard_ only serializes parking with notification
+	std::mutex wakeup_guard_;
+	std::condition_variable wakeup_event_;
+	std::atomic<size_t> idle_threads_;
+	std::atomic<size_t> spin_limit_;
+	const size_t max_spin_limit_;
+
+	// steady_timers and sockets. Only one idle thread, the event waiter, blocks in the reactor
+	// or sleeps until the next timer event, the others wait for handlers. event_waiter_ and
+	// reactor_waiting_ are protected by wakeup_guard_
+	std::mutex timers_guard_;
+	detail::timer_wheel timers_;
+	std::atomic<std::chrono::steady_clock::rep> next_timer_event_;
+	bool event_waiter_;
+	bool reactor_waiting_;
+
+	io_backend io_backend_;
+
+	// set once by enable_metrics(), null while metrics are off
+	std::once_flag metrics_once_;
+	std::unique_ptr<detail::io_context_metrics_state> metrics_owner_;
+	std::atomic<detail::io_context_metrics_state*> metrics_;
+
+#if defined(MY_ASIO_HAS_EPOLL)
+	std::once_flag reactor_once_;
+	std::unique_ptr<detail::io_engine> reactor_owner_;
+	std::atomic<detail::io_engine*> reactor_;
+#endif
 };
 
 class io_context::executor_type
@@ -79,7 +360,9 @@ public:
 
 	bool running_in_this_thread() const;
 
-	void execute(std::function<void()> f) const;
+	// invokes the handler in place
+	template<typename Handler>
+	void execute(Handler&& f) const;
 
 	io_context& context() const;
 
@@ -89,9 +372,41 @@ public:
 
 	bool can_dispatch() const;
 
-	void dispatch(std::function<void()> f) const;
-
-	void post(std::function<void()> f) const;
+	// runs the handler inline, without type erasure, if called from a thread running the io_context
+	template<typename Handler>
+	void dispatch(Handler&& f) const;
+
+	// the handler is type-erased once, straight into the queued any_handler
+	template<typename Handler>
+	void post(Handler&& f) const;
+
+	// posts the handler unless the io_context's queue limits are reached, see queue_limits
+	template<typename Handler>
+	bool try_post(Handler&& f) const;
+
+	// posts the handler once the queue limits have room for it, then completes with
+	// handler(std::error_code), or resumes the coroutine with use_awaitable. Producers waiting
+	// are admitted in FIFO order, before any try_post(). If the io_context is destroyed first the
+	// handler is dropped and the completion called by the destructor with operation_canceled
+	template<typename Handler, typename CompletionToken>
+	typename async_result<typename std::decay<CompletionToken>::type, void(std::error_code)>::return_type
+	post_when_ready(Handler&& f, CompletionToken&& token) const;
+
+	// posts every handler of the range with a single work count update and queue operation.
+	// Elements of an rvalue range are moved from
+	template<typename Range>
+	void post_bulk(Range&& handlers) const;
+
+	// posts a continuation of the calling handler. Unlike post(), from inside a handler it is queued
+	// on the calling thread and only handed to the shared queue when the handler returns, so no
+	// other thread can run it before. Outside a handler it is the same as post()
+	template<typename Handler>
+	void defer(Handler&& f) const;
+
+	// post() that never takes the next handler slot, see io_context::set_next_handler_limit().
+	// For handlers that give way to the queued ones, as a strand at the end of its turn
+	template<typename Handler>
+	void yield(Handler&& f) const;
 
 private:
 	friend class io_context;
@@ -109,9 +424,141 @@ private:
 	io_context* io_ptr;
 };
 
-void post(io_context& io, std::function<void()> f);
+template<typename Handler>
+void io_context::executor_type::execute(Handler&& f) const
+{
+	f();
+}
+
+template<typename Handler>
+void io_context::executor_type::dispatch(Handler&& f) const
+{
+	if (can_dispatch())
+		execute(std::forward<Handler>(f));
+	else
+		post(std::forward<Handler>(f));
+}
+
+template<typename Handler>
+void io_context::executor_type::post(Handler&& f) const
+{
+	io_ptr->post_handler(any_handler(std::forward<Handler>(f)));
+}
+
+template<typename Handler>
+bool io_context::executor_type::try_post(Handler&& f) const
+{
+	return io_ptr->try_post_handler(any_handler(std::forward<Handler>(f)));
+}
+
+template<typename Handler, typename CompletionToken>
+typename async_result<typename std::decay<CompletionToken>::type, void(std::error_code)>::return_type
+io_context::executor_type::post_when_ready(Handler&& f, CompletionToken&& token) const
+{
+	return async_initiate<void(std::error_code)>(detail::initiate_post_when_ready<io_context>{ io_ptr, detail::make_admission_waiter(std::forward<Handler>(f)) },
+		std::forward<CompletionToken>(token));
+}
+
+template<typename Range>
+void io_context::executor_type::post_bulk(Range&& handlers) const
+{
+	detail::handler_vector erased;
+	for (auto&& f : handlers)
+	{
+		using element_type = typename std::conditional<std::is_lvalue_reference<Range>::value,
+			decltype(f), typename std::remove_reference<decltype(f)>::type&&>::type;
+		erased.emplace_back(static_cast<element_type>(f));
+	}
+
+	io_ptr->post_handlers(erased.data(), erased.size());
+}
+
+template<typename Handler>
+void io_context::executor_type::defer(Handler&& f) const
+{
+	io_ptr->defer_handler(any_handler(std::forward<Handler>(f)));
+}
+
+template<typename Handler>
+void io_context::executor_type::yield(Handler&& f) const
+{
+	io_ptr->yield_handler(any_handler(std::forward<Handler>(f)));
+}
+
+template<typename Executor, typename Handler>
+typename enable_if_executor<Executor>::type post(Executor&& ex, Handler&& f)
+{
+	ex.post(std::forward<Handler>(f));
+}
 
-void dispatch(io_context& io, std::function<void()> f);
+template<typename Executor, typename Handler>
+typename enable_if_executor<Executor>::type dispatch(Executor&& ex, Handler&& f)
+{
+	ex.dispatch(std::forward<Handler>(f));
+}
+
+template<typename Executor, typename Handler>
+typename enable_if_executor<Executor>::type defer(Executor&& ex, Handler&& f)
+{
+	ex.defer(std::forward<Handler>(f));
+}
+
+template<typename Executor, typename Range>
+typename enable_if_executor<Executor>::type post_bulk(Executor&& ex, Range&& handlers)
+{
+	ex.post_bulk(std::forward<Range>(handlers));
+}
+
+// executors with queue limits: io_context::executor_type and strand
+template<typename Executor, typename Handler>
+auto try_post(Executor&& ex, Handler&& f) -> decltype(ex.try_post(std::forward<Handler>(f)))
+{
+	return ex.try_post(std::forward<Handler>(f));
+}
+
+template<typename Executor, typename Handler, typename CompletionToken>
+auto post_when_ready(Executor&& ex, Handler&& f, CompletionToken&& token)
+	-> decltype(ex.post_when_ready(std::forward<Handler>(f), std::forward<CompletionToken>(token)))
+{
+	return ex.post_when_ready(std::forward<Handler>(f), std::forward<CompletionToken>(token));
+}
+
+template<typename Handler>
+void post(io_context& io, Handler&& f)
+{
+	io.get_executor().post(std::forward<Handler>(f));
+}
+
+template<typename Handler>
+void dispatch(io_context& io, Handler&& f)
+{
+	io.get_executor().dispatch(std::forward<Handler>(f));
+}
+
+template<typename Handler>
+void defer(io_context& io, Handler&& f)
+{
+	io.get_executor().defer(std::forward<Handler>(f));
+}
+
+template<typename Range>
+void post_bulk(io_context& io, Range&& handlers)
+{
+	io.get_executor().post_bulk(std::forward<Range>(handlers));
+}
+
+template<typename Handler>
+bool try_post(io_context& io, Handler&& f)
+{
+	return io.get_executor().try_post(std::forward<Handler>(f));
+}
+
+template<typename Handler, typename CompletionToken>
+typename async_result<typename std::decay<CompletionToken>::type, void(std::error_code)>::return_type
+post_when_ready(io_context& io, Handler&& f, CompletionToken&& token)
+{
+	return io.get_executor().post_when_ready(std::forward<Handler>(f), std::forward<CompletionToken>(token));
+}
 
 } // namespace my_asio
 
@@ -0,0 +1,53 @@
+#ifndef MY_ASIO_IS_EXECUTOR_HPP
+#define MY_ASIO_IS_EXECUTOR_HPP
+
+#include <type_traits>
+#include <utility>
+
+namespace my_asio
+{
+namespace detail
+{
+
+template<typename...>
+struct make_void
+{
+	using type = void;
+};
+
+template<typename... Ts>
+using void_t = typename make_void<Ts...>::type;
+
+// stands in for a user handler when checking what an executor accepts
+struct executor_probe_handler
+{
+	void operator()() {}
+};
+
+} // namespace detail
+
+/*
+Executor requirements: an lvalue e of type T supports
+e.post(h), e.dispatch(h), e.defer(h), e.on_work_started(), e.on_work_finished()
+and e.running_in_this_thread()
+*/
+template<typename T, typename = void>
+struct is_executor : std::false_type
+{	};
+
+template<typename T>
+struct is_executor<T, detail::void_t<
+	decltype(std::declval<T&>().post(detail::executor_probe_handler())),
+	decltype(std::declval<T&>().dispatch(detail::executor_probe_handler())),
+	decltype(std::declval<T&>().defer(detail::executor_probe_handler())),
+	decltype(std::declval<T&>().on_work_started()),
+	decltype(std::declval<T&>().on_work_finished()),
+	decltype(std::declval<T&>().running_in_this_thread())>> : std::true_type
+{	};
+
+template<typename T, typename R = void>
+using enable_if_executor = std::enable_if<is_executor<typename std::decay<T>::type>::value, R>;
+
+} // namespace my_asio
+
+#endif // MY_ASIO_IS_EXECUTOR_HPP
\ No newline at end of file
@@ -0,0 +1,110 @@
+#ifndef MY_ASIO_METRICS_HPP
+#define MY_ASIO_METRICS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "timer_wheel.hpp"
+
+namespace my_asio
+{
+
+namespace detail
+{
+
+class latency_histogram;
+
+} // namespace detail
+
+/*
+Distribution of durations in nanoseconds. Buckets are log-linear: values below 4 have a
+bucket each, above that every power of two is split into 4 equal buckets, so a value is
+known to within 25% whatever its magnitude
+*/
+class histogram_snapshot
+{
+public:
+	static constexpr size_t sub_buckets = 4;
+	static constexpr size_t bucket_count = 252;
+
+	static size_t bucket_index(uint64_t value)
+	{
+		if (value < sub_buckets)
+			return size_t(value);
+
+		const unsigned exponent = detail::highest_bit(value);
+		return sub_buckets * (exponent - 1) + size_t((value >> (exponent - 2)) & (sub_buckets - 1));
+	}
+
+	// the largest value that falls into the bucket
+	static uint64_t bucket_upper_bound(size_t index);
+
+	histogram_snapshot()
+		: buckets_(bucket_count)
+	{	}
+
+	uint64_t count() const { return count_; }
+
+	uint64_t sum() const { return sum_; }
+
+	double mean() const { return count_ ? double(sum_) / count_ : 0.0; }
+
+	// upper bound of the bucket holding the q-th quantile (0 <= q <= 1), 0 if nothing was recorded
+	uint64_t percentile(double q) const;
+
+	// upper bound of the highest non-empty bucket
+	uint64_t max() const { return percentile(1.0); }
+
+	const std::vector<uint64_t>& buckets() const { return buckets_; }
+
+private:
+	friend class detail::latency_histogram;
+
+	uint64_t count_ = 0;
+	uint64_t sum_ = 0;
+	std::vector<uint64_t> buckets_;
+};
+
+// Snapshot of the metrics of an io_context, see io_context::enable_metrics()
+struct io_context_metrics
+{
+	bool enabled = false;
+	uint64_t handlers_queued = 0;		// handlers handed to the io_context, posted or completed operations
+	uint64_t handlers_run = 0;
+	uint64_t ready_handlers = 0;		// queued but not run yet
+	size_t outstanding_work = 0;
+	uint64_t next_handler_hits = 0;		// continuations run right after the handler that posted them
+	uint64_t next_handler_spills = 0;	// continuations queued instead, because of the limit on a row of them
+	histogram_snapshot queue_wait;		// sampled time from post() to the start of the handler
+	histogram_snapshot run_time;		// sampled handler run time
+};
+
+// Snapshot of the metrics of a strand, see strand::enable_metrics()
+struct strand_metrics
+{
+	bool enabled = false;
+	uint64_t handlers_posted = 0;
+	uint64_t handlers_run = 0;
+	size_t backlog = 0;					// handlers queued or running
+	size_t turns = 0;
+	size_t max_handlers_per_turn = 0;
+	histogram_snapshot queue_wait;		// sampled time from post() to the start of the handler
+	histogram_snapshot run_time;		// sampled handler run time
+};
+
+// Prometheus text exposition format, every metric name starts with prefix.
+// Durations are exported in seconds, with buckets at the powers of two of nanoseconds
+std::string to_prometheus(const io_context_metrics& metrics, const std::string& prefix = "my_asio_io_context");
+
+std::string to_prometheus(const strand_metrics& metrics, const std::string& prefix = "my_asio_strand");
+
+// One JSON object, durations in nanoseconds
+std::string to_json(const io_context_metrics& metrics);
+
+std::string to_json(const strand_metrics& metrics);
+
+} // namespace my_asio
+
+#endif // MY_ASIO_METRICS_HPP
\ No newline at end of file
@@ -0,0 +1,85 @@
+#ifndef MY_ASIO_PRIORITY_EXECUTOR_HPP
+#define MY_ASIO_PRIORITY_EXECUTOR_HPP
+
+#include <utility>
+
+#include "io_context.hpp"
+
+namespace my_asio
+{
+
+/*
+Executor of an io_context that posts its handlers with a priority. Each priority has its own
+queue and the threads running the io_context take handlers from them by weighted round, see
+io_context::set_priority_weights(). Like the io_context's executor, dispatch() runs the
+handler inline when called from a thread running the io_context, the priority only orders
+queued handlers. A strand<priority_executor> schedules its turns with the priority
+*/
+class priority_executor
+{
+public:
+	priority_executor(const io_context::executor_type& executor, handler_priority priority)
+		: executor_(executor)
+		, priority_(priority)
+	{	}
+
+	handler_priority priority() const { return priority_; }
+
+	io_context::executor_type get_inner_executor() const { return executor_; }
+
+	io_context& context() const { return executor_.context(); }
+
+	bool running_in_this_thread() const { return executor_.running_in_this_thread(); }
+
+	void on_work_started() const { executor_.on_work_started(); }
+
+	void on_work_finished() const { executor_.on_work_finished(); }
+
+	template<typename Handler>
+	void post(Handler&& f) const
+	{
+		executor_.context().post_handler(any_handler(std::forward<Handler>(f)), priority_);
+	}
+
+	template<typename Handler>
+	void dispatch(Handler&& f) const
+	{
+		if (executor_.can_dispatch())
+			executor_.execute(std::forward<Handler>(f));
+		else
+			post(std::forward<Handler>(f));
+	}
+
+	// only handlers of normal priority are kept on the calling thread until its handler returns
+	template<typename Handler>
+	void defer(Handler&& f) const
+	{
+		if (priority_ == handler_priority::normal)
+			executor_.defer(std::forward<Handler>(f));
+		else
+			post(std::forward<Handler>(f));
+	}
+
+	// high and low priority handlers never take the next handler slot
+	template<typename Handler>
+	void yield(Handler&& f) const
+	{
+		if (priority_ == handler_priority::normal)
+			executor_.yield(std::forward<Handler>(f));
+		else
+			post(std::forward<Handler>(f));
+	}
+
+private:
+	io_context::executor_type executor_;
+	handler_priority priority_;
+};
+
+inline priority_executor make_priority_executor(io_context& io, handler_priority priority)
+{
+	return priority_executor(io.get_executor(), priority);
+}
+
+} // namespace my_asio
+
+#endif // MY_ASIO_PRIORITY_EXECUTOR_HPP
\ No newline at end of file
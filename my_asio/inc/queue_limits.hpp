@@ -0,0 +1,30 @@
+#ifndef MY_ASIO_QUEUE_LIMITS_HPP
+#define MY_ASIO_QUEUE_LIMITS_HPP
+
+#include <cstddef>
+#include <functional>
+
+namespace my_asio
+{
+
+/*
+Bounds the handlers queued on an io_context or a strand, see io_context::set_queue_limits().
+Every handler posted counts until it starts running. post() always queues, try_post() fails
+and post_when_ready() waits once capacity handlers are queued.
+The watermark callbacks are called with the number of queued handlers, from the thread that
+queues or starts the handler crossing the watermark. on_high_watermark is called once the
+queue has grown to high_watermark, on_low_watermark once it has drained back to low_watermark
+*/
+struct queue_limits
+{
+	size_t capacity = 0;		// 0 is unbounded
+	size_t high_watermark = 0;	// 0 is capacity
+	size_t low_watermark = 0;
+
+	std::function<void(size_t)> on_high_watermark;
+	std::function<void(size_t)> on_low_watermark;
+};
+
+} // namespace my_asio
+
+#endif // MY_ASIO_QUEUE_LIMITS_HPP
\ No newline at end of file
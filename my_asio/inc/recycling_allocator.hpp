@@ -0,0 +1,90 @@
+#ifndef MY_ASIO_RECYCLING_ALLOCATOR_HPP
+#define MY_ASIO_RECYCLING_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace my_asio
+{
+
+// Counters of the calling thread's memory cache
+struct recycling_allocator_stats
+{
+	size_t hits = 0;		// allocations served from the cache
+	size_t misses = 0;		// allocations of a cached size class that went to operator new
+	size_t oversized = 0;	// allocations larger than the largest size class
+	size_t recycled = 0;	// deallocations kept in the cache
+	size_t released = 0;	// deallocations returned to operator delete
+
+	double hit_rate() const
+	{
+		const size_t total = hits + misses + oversized;
+		return total ? double(hits) / total : 0.0;
+	}
+};
+
+namespace detail
+{
+
+/*
+Per-thread cache of free blocks grouped by size class, similar to asio's thread_info_base.
+A block released on a thread goes to that thread's cache, so handler storage allocated and
+freed by the same thread is reused while it is still warm.
+Blocks are aligned for std::max_align_t
+*/
+class thread_memory_cache
+{
+public:
+	static void* allocate(size_t size);
+
+	static void deallocate(void* p, size_t size) noexcept;
+
+	// fills the calling thread's cache with blocks allocated, and first touched, by this thread,
+	// so on a NUMA system they come from the thread's node
+	static void fill();
+};
+
+} // namespace detail
+
+// Sets the block sizes and the number of cached blocks per size, all threads must share
+// one configuration, so it can only be changed before any thread has used the cache.
+// Returns false if it is too late
+bool configure_recycling_allocator(std::vector<size_t> size_classes, size_t blocks_per_class);
+
+recycling_allocator_stats this_thread_recycling_stats();
+
+// Standard allocator drawing from the calling thread's memory cache
+template<typename T>
+class recycling_allocator
+{
+public:
+	using value_type = T;
+
+	static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+
+	recycling_allocator() noexcept = default;
+
+	template<typename U>
+	recycling_allocator(const recycling_allocator<U>&) noexcept
+	{	}
+
+	T* allocate(size_t n)
+	{
+		return static_cast<T*>(detail::thread_memory_cache::allocate(n * sizeof(T)));
+	}
+
+	void deallocate(T* p, size_t n) noexcept
+	{
+		detail::thread_memory_cache::deallocate(p, n * sizeof(T));
+	}
+
+	template<typename U>
+	bool operator==(const recycling_allocator<U>&) const noexcept { return true; }
+
+	template<typename U>
+	bool operator!=(const recycling_allocator<U>&) const noexcept { return false; }
+};
+
+} // namespace my_asio
+
+#endif // MY_ASIO_RECYCLING_ALLOCATOR_HPP
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef MY_ASIO_STEADY_TIMER_HPP
+#define MY_ASIO_STEADY_TIMER_HPP
+
+#include <chrono>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "async_result.hpp"
+#include "io_context.hpp"
+#include "wait_op.hpp"
+
+namespace my_asio
+{
+
+/*
+A timer on std::chrono::steady_clock, kept in the timer wheel of its io_context.
+async_wait handlers are called as handler(const std::error_code&) from a thread running the
+io_context, with an empty error code once the timer expires, or with std::errc::operation_canceled
+if the wait is cancelled. A pending wait counts as work of the io_context.
+The io_context must outlive the timer. A timer object is not thread-safe
+*/
+class steady_timer
+{
+public:
+	using clock_type = std::chrono::steady_clock;
+	using duration = clock_type::duration;
+	using time_point = clock_type::time_point;
+	using executor_type = io_context::executor_type;
+
+	explicit steady_timer(io_context& io);
+
+	steady_timer(io_context& io, duration expiry_time);
+
+	steady_timer(io_context& io, time_point expiry_time);
+
+	steady_timer(const steady_timer&) = delete;
+	steady_timer& operator=(const steady_timer&) = delete;
+
+	// cancels the pending waits
+	~steady_timer();
+
+	executor_type get_executor();
+
+	time_point expiry() const;
+
+	// setting the expiry cancels the pending waits, returns how many were cancelled
+	size_t expires_at(time_point expiry_time);
+
+	size_t expires_after(duration expiry_time);
+
+	size_t cancel();
+
+	// handler(const std::error_code&), or a completion token such as use_awaitable
+	template<typename WaitHandler>
+	typename async_result<typename std::decay<WaitHandler>::type, void(std::error_code)>::return_type
+	async_wait(WaitHandler&& handler);
+
+private:
+	io_context& io_;
+	time_point expiry_;
+	detail::timer_data data_;
+};
+
+template<typename WaitHandler>
+typename async_result<typename std::decay<WaitHandler>::type, void(std::error_code)>::return_type
+steady_timer::async_wait(WaitHandler&& handler)
+{
+	return async_initiate<void(std::error_code)>([this](auto&& h) {
+		using handler_type = typename std::decay<decltype(h)>::type;
+
+		io_.schedule_timer(data_, expiry_, detail::wait_handler<handler_type>::create(std::forward<decltype(h)>(h)));
+		}, std::forward<WaitHandler>(handler));
+}
+
+} // namespace my_asio
+
+#endif // MY_ASIO_STEADY_TIMER_HPP
\ No newline at end of file
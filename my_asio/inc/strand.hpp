@@ -1,68 +1,469 @@
 #ifndef STRAND_HPP
 #define STRAND_HPP
 
-#include <functional>
 #include <atomic>
-#include <mutex>
-#include <queue>
+#include <chrono>
+#include <new>
 
 #include "io_context.hpp"
+#include "admission_control.hpp"
+#include "cpu_relax.hpp"
+#include "intrusive_mpsc_queue.hpp"
+#include "handler_tracking.hpp"
+#include "sharded_metrics.hpp"
 
 namespace my_asio
 {
+namespace detail
+{
+
+// executors with a next handler slot have yield(), which queues the handler behind the others
+template<typename Executor, typename Handler>
+auto yield_to(Executor& executor, Handler&& f, int) -> decltype(executor.yield(std::forward<Handler>(f)))
+{
+	return executor.yield(std::forward<Handler>(f));
+}
 
+template<typename Executor, typename Handler>
+void yield_to(Executor& executor, Handler&& f, long)
+{
+	executor.post(std::forward<Handler>(f));
+}
+
+} // namespace detail
+
+// Counters of the handlers a strand ran per scheduling turn
+struct strand_stats
+{
+	size_t turns = 0;
+	size_t handlers = 0;
+	size_t max_handlers_per_turn = 0;
+
+	double handlers_per_turn() const
+	{
+		return turns ? double(handlers) / turns : 0.0;
+	}
+};
+
+/*
+Handlers posted to a strand run one at a time, in FIFO order, never concurrently.
+Producers push onto a lock-free intrusive queue, pending_ counts the queued and running
+handlers and whoever moves it from 0 to 1 schedules the strand on the executor. The
+handlers run with no lock held, so posting to a busy strand, even from its own handler,
+never blocks.
+Each time the strand is scheduled it runs pending handlers until its turn budget (a number
+of handlers and optionally a duration) is used up, then yields back to the executor
+*/
 template<typename Executor>
 class strand
 {
 public:
 	using executor_type = Executor;
 
+	static constexpr size_t default_max_handlers_per_turn = 16;
+
 	strand(const executor_type& executor)
 		: executor_(executor)
-		, running_strand(0)
+		, pending_(0)
+		, max_handlers_per_turn_(default_max_handlers_per_turn)
+		, max_turn_time_us_(0)
+		, turns_(0)
+		, handlers_run_(0)
+		, max_handlers_in_turn_(0)
+		, metrics_(nullptr)
+		, admission_(nullptr)
 	{	}
 
+	// only an idle strand (no handler queued or running) can be moved from, its metrics and queue limits move along
 	strand(strand&& other)
 		: executor_(std::move(other.executor_))
-		, running_strand(other.running_strand)
-		, work_queue_(std::move(work_queue_))
+		, pending_(0)
+		, max_handlers_per_turn_(other.max_handlers_per_turn_.load())
+		, max_turn_time_us_(other.max_turn_time_us_.load())
+		, turns_(0)
+		, handlers_run_(0)
+		, max_handlers_in_turn_(0)
+		, metrics_(other.metrics_.exchange(nullptr))
+		, admission_(other.admission_.exchange(nullptr))
 	{	}
 
+	~strand();
+
 	bool running_in_this_thread();
 
-	void post(std::function<void()> f);
+	executor_type get_inner_executor() const { return executor_; }
+
+	void on_work_started() const { executor_.on_work_started(); }
+
+	void on_work_finished() const { executor_.on_work_finished(); }
+
+	template<typename Handler>
+	void post(Handler&& f);
+
+	// posts the handler unless the strand's queue limits are reached, see queue_limits
+	template<typename Handler>
+	bool try_post(Handler&& f);
+
+	// posts the handler once the queue limits have room for it, then completes with
+	// handler(std::error_code) through the inner executor, with operation_canceled if the
+	// strand is destroyed first
+	template<typename Handler, typename CompletionToken>
+	typename async_result<typename std::decay<CompletionToken>::type, void(std::error_code)>::return_type
+	post_when_ready(Handler&& f, CompletionToken&& token);
 
-	void dispatch(std::function<void()> f);
+	// runs the handler inline, without type erasure, if already inside this strand
+	template<typename Handler>
+	void dispatch(Handler&& f);
+
+	template<typename Handler>
+	void defer(Handler&& f);
+
+	// a turn ends after max_handlers handlers, or once max_time has elapsed if it is non-zero
+	void set_turn_budget(size_t max_handlers, std::chrono::microseconds max_time = std::chrono::microseconds(0));
+
+	strand_stats stats() const;
+
+	// starts collecting metrics. Counters are exact, the queue wait and run time of one in
+	// sample_interval handlers are measured. Once enabled metrics stay on, later calls do nothing
+	void enable_metrics(unsigned sample_interval = 64);
+
+	// a snapshot, strand_metrics::enabled is false if enable_metrics() has not been called
+	strand_metrics metrics() const;
+
+	// bounds the handlers queued on the strand, see queue_limits. Counting starts with the first
+	// call, handlers queued before are not counted
+	void set_queue_limits(const queue_limits& limits);
+
+	// the counted handlers that have not started yet, 0 without queue limits
+	size_t queued_handlers() const;
 
 private:
 	friend executor_type;
+	template<typename> friend class detail::admitted_handler;
+	template<typename> friend struct detail::initiate_post_when_ready;
+
+	struct node
+	{
+		std::atomic<node*> next;
+		any_handler handler;
+
+		// only set for the handlers whose queue wait is sampled
+		std::chrono::steady_clock::time_point queued;
+	};
 
+	static node* make_node(any_handler&& handler);
+
+	static void destroy_node(node* n);
+
+	// enqueues the handler, scheduling the strand if it was idle
+	void enqueue(any_handler&& handler);
+
+	void schedule();
+
+	// schedules the strand behind the work already queued on the executor, at the end of a turn
+	void yield();
+
+	// counts the handler against the queue limits, if there are any
+	void admit_handler(any_handler& handler);
+
+	void post_when_ready_handler(std::unique_ptr<detail::admission_waiter> waiter);
+
+	// called by a counted handler when it starts running or is destroyed
+	void release_admission();
+
+	void admit_waiter(std::unique_ptr<detail::admission_waiter> waiter);
+
+	// runs pending handlers for one turn, the strand is re-scheduled while handlers are pending
 	void execute();
 
+	// pops, runs and releases the oldest handler. If the handler throws, the strand is passed on
+	void run_next_handler();
+
+	// blocks only while a producer is between the two steps of its push
+	node* pop_pending_node();
+
 	executor_type executor_;
-	std::mutex queue_guard_;
-	std::atomic<bool> running_strand;
-	std::queue<std::function<void()>> work_queue_;
+	std::atomic<size_t> pending_;
+	detail::intrusive_mpsc_queue<node> work_queue_;
+
+	std::atomic<size_t> max_handlers_per_turn_;
+	std::atomic<long long> max_turn_time_us_;
+
+	// only written by the thread running the strand
+	std::atomic<size_t> turns_;
+	std::atomic<size_t> handlers_run_;
+	std::atomic<size_t> max_handlers_in_turn_;
+
+	// owned, set once by enable_metrics()
+	std::atomic<detail::strand_metrics_state*> metrics_;
+
+	// owned, set once by set_queue_limits()
+	std::atomic<detail::admission_control*> admission_;
 };
 
+template<typename Executor>
+strand<Executor>::~strand()
+{
+	// producers still waiting in post_when_ready() are completed with operation_canceled
+	detail::admission_control* admission = admission_.load(std::memory_order_relaxed);
+	if (admission)
+		admission->shutdown([this](std::unique_ptr<detail::admission_waiter> w) {
+			executor_.post(std::move(w->completion));
+			});
+
+	// handlers that never ran, e.g. the io_context was not run again
+	while (node* n = work_queue_.pop())
+		destroy_node(n);
+
+	delete metrics_.load(std::memory_order_relaxed);
+	delete admission;
+}
+
+template<typename Executor>
+typename strand<Executor>::node* strand<Executor>::make_node(any_handler&& handler)
+{
+	void* p = detail::thread_memory_cache::allocate(sizeof(node));
+	node* n = new (p) node;
+	n->handler = std::move(handler);
+	return n;
+}
+
+template<typename Executor>
+void strand<Executor>::destroy_node(node* n)
+{
+	n->~node();
+	detail::thread_memory_cache::deallocate(n, sizeof(node));
+}
+
+template<typename Executor>
+void strand<Executor>::enqueue(any_handler&& handler)
+{
+	MY_ASIO_HANDLER_CREATION(handler, this);
+	node* n = make_node(std::move(handler));
+
+	if (detail::strand_metrics_state* metrics = metrics_.load(std::memory_order_acquire))
+	{
+		metrics->handlers_posted.add(1);
+		if (detail::this_thread_takes_sample(metrics->sample_interval))
+			n->queued = std::chrono::steady_clock::now();
+	}
+
+	work_queue_.push(n);
+
+	if (pending_.fetch_add(1, std::memory_order_acq_rel) == 0)
+		schedule();
+}
+
+template<typename Executor>
+void strand<Executor>::schedule()
+{
+	executor_.post([this]() {
+		execute();
+		});
+}
+
+template<typename Executor>
+void strand<Executor>::yield()
+{
+	detail::yield_to(executor_, [this]() {
+		execute();
+		}, 0);
+}
+
+template<typename Executor>
+void strand<Executor>::admit_handler(any_handler& handler)
+{
+	if (detail::admission_control* admission = admission_.load(std::memory_order_acquire))
+	{
+		admission->admit();
+		handler = any_handler(detail::admitted_handler<strand>(std::move(handler), this));
+	}
+}
+
+template<typename Executor>
+void strand<Executor>::post_when_ready_handler(std::unique_ptr<detail::admission_waiter> waiter)
+{
+	detail::admission_control* admission = admission_.load(std::memory_order_acquire);
+	if (!admission)
+	{
+		enqueue(std::move(waiter->handler));
+		executor_.post(std::move(waiter->completion));
+		return;
+	}
+
+	admission->wait(std::move(waiter), [this](std::unique_ptr<detail::admission_waiter> w) {
+		admit_waiter(std::move(w));
+		});
+}
+
+template<typename Executor>
+void strand<Executor>::release_admission()
+{
+	admission_.load(std::memory_order_relaxed)->release([this](std::unique_ptr<detail::admission_waiter> w) {
+		admit_waiter(std::move(w));
+		});
+}
+
+template<typename Executor>
+void strand<Executor>::admit_waiter(std::unique_ptr<detail::admission_waiter> waiter)
+{
+	// the handler's slot has been reserved, the completion runs outside the strand
+	enqueue(any_handler(detail::admitted_handler<strand>(std::move(waiter->handler), this)));
+	executor_.post(std::move(waiter->completion));
+}
+
+template<typename Executor>
+typename strand<Executor>::node* strand<Executor>::pop_pending_node()
+{
+	node* n;
+	while (!(n = work_queue_.pop()))
+		detail::cpu_relax();
+	return n;
+}
+
 template<typename Executor>
 void strand<Executor>::execute()
 {
+	using clock = std::chrono::steady_clock;
+
 	typename detail::call_stack<strand>::context ctx(this);
 
-	std::lock_guard<std::mutex> lock(queue_guard_);
-	work_queue_.front()();
-	work_queue_.pop();
+	const size_t max_handlers = max_handlers_per_turn_.load(std::memory_order_relaxed);
+	const std::chrono::microseconds max_time(max_turn_time_us_.load(std::memory_order_relaxed));
+	const clock::time_point turn_start = max_time.count() ? clock::now() : clock::time_point();
 
-	if (!work_queue_.empty())
+	size_t handlers = 0;
+	bool more;
+	do
 	{
-		executor_.post([this]() {
-			execute();
-			});
-		executor_.on_work_finished();
+		run_next_handler();
+		++handlers;
+		more = pending_.fetch_sub(1, std::memory_order_acq_rel) > 1;
+	} while (more && handlers < max_handlers && (!max_time.count() || clock::now() - turn_start < max_time));
+
+	turns_.store(turns_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	handlers_run_.store(handlers_run_.load(std::memory_order_relaxed) + handlers, std::memory_order_relaxed);
+	if (handlers > max_handlers_in_turn_.load(std::memory_order_relaxed))
+		max_handlers_in_turn_.store(handlers, std::memory_order_relaxed);
+
+	if (more)
+		yield();
+}
+
+template<typename Executor>
+void strand<Executor>::run_next_handler()
+{
+	struct node_guard
+	{
+		strand* self;
+		node* n;
+		bool completed;
+
+		~node_guard()
+		{
+			destroy_node(n);
+			if (!completed && self->pending_.fetch_sub(1, std::memory_order_acq_rel) > 1)
+				self->schedule();
+		}
+	};
+
+	node_guard guard{ this, pop_pending_node(), false };
+
+	std::chrono::steady_clock::time_point started;
+	detail::strand_metrics_state* metrics = metrics_.load(std::memory_order_acquire);
+	if (metrics)
+	{
+		if (guard.n->queued != std::chrono::steady_clock::time_point())
+			metrics->queue_wait.record(std::chrono::steady_clock::now() - guard.n->queued);
+		if (detail::this_thread_takes_sample(metrics->sample_interval))
+			started = std::chrono::steady_clock::now();
 	}
-	else
-		running_strand = false;
+
+	{
+		MY_ASIO_HANDLER_INVOCATION(guard.n->handler, this);
+		guard.n->handler();
+	}
+	guard.completed = true;
+
+	if (started != std::chrono::steady_clock::time_point())
+		metrics->run_time.record(std::chrono::steady_clock::now() - started);
+}
+
+template<typename Executor>
+void strand<Executor>::set_turn_budget(size_t max_handlers, std::chrono::microseconds max_time)
+{
+	max_handlers_per_turn_.store(max_handlers ? max_handlers : 1, std::memory_order_relaxed);
+	max_turn_time_us_.store(max_time.count(), std::memory_order_relaxed);
+}
+
+template<typename Executor>
+strand_stats strand<Executor>::stats() const
+{
+	strand_stats result;
+	result.turns = turns_.load(std::memory_order_relaxed);
+	result.handlers = handlers_run_.load(std::memory_order_relaxed);
+	result.max_handlers_per_turn = max_handlers_in_turn_.load(std::memory_order_relaxed);
+	return result;
+}
+
+template<typename Executor>
+void strand<Executor>::enable_metrics(unsigned sample_interval)
+{
+	if (metrics_.load(std::memory_order_acquire))
+		return;
+
+	detail::strand_metrics_state* metrics = new detail::strand_metrics_state(sample_interval ? sample_interval : 1);
+	detail::strand_metrics_state* expected = nullptr;
+	if (!metrics_.compare_exchange_strong(expected, metrics, std::memory_order_acq_rel))
+		delete metrics;
+}
+
+template<typename Executor>
+strand_metrics strand<Executor>::metrics() const
+{
+	strand_metrics result;
+	result.backlog = pending_.load(std::memory_order_relaxed);
+
+	const detail::strand_metrics_state* metrics = metrics_.load(std::memory_order_acquire);
+	if (!metrics)
+		return result;
+
+	const strand_stats turn_stats = stats();
+	result.enabled = true;
+	result.handlers_posted = metrics->handlers_posted.load();
+	result.handlers_run = turn_stats.handlers;
+	result.turns = turn_stats.turns;
+	result.max_handlers_per_turn = turn_stats.max_handlers_per_turn;
+	result.queue_wait = metrics->queue_wait.snapshot();
+	result.run_time = metrics->run_time.snapshot();
+	return result;
+}
+
+template<typename Executor>
+void strand<Executor>::set_queue_limits(const queue_limits& limits)
+{
+	detail::admission_control* admission = admission_.load(std::memory_order_acquire);
+	if (!admission)
+	{
+		detail::admission_control* created = new detail::admission_control(limits);
+		if (admission_.compare_exchange_strong(admission, created, std::memory_order_acq_rel))
+			admission = created;
+		else
+			delete created;
+	}
+
+	// a raised capacity makes room for the producers waiting
+	admission->set_limits(limits);
+	admission->drain([this](std::unique_ptr<detail::admission_waiter> w) {
+		admit_waiter(std::move(w));
+		});
+}
+
+template<typename Executor>
+size_t strand<Executor>::queued_handlers() const
+{
+	const detail::admission_control* admission = admission_.load(std::memory_order_acquire);
+	return admission ? admission->queued() : 0;
 }
 
 template<typename Executor>
@@ -72,40 +473,54 @@ bool strand<Executor>::running_in_this_thread()
 }
 
 template<typename Executor>
-void strand<Executor>::post(std::function<void()> f)
+template<typename Handler>
+void strand<Executor>::post(Handler&& f)
 {
-	executor_.on_work_started();
-	std::lock_guard<std::mutex> lock(queue_guard_);
-	work_queue_.push(f);
-	if (!running_strand)
+	any_handler handler(std::forward<Handler>(f));
+	admit_handler(handler);
+	enqueue(std::move(handler));
+}
+
+template<typename Executor>
+template<typename Handler>
+bool strand<Executor>::try_post(Handler&& f)
+{
+	any_handler handler(std::forward<Handler>(f));
+	if (detail::admission_control* admission = admission_.load(std::memory_order_acquire))
 	{
-		running_strand = true;
-		executor_.post([this]() {
-			execute();
-			});
-		executor_.on_work_finished();
+		if (!admission->try_admit())
+			return false;
+		handler = any_handler(detail::admitted_handler<strand>(std::move(handler), this));
 	}
+
+	enqueue(std::move(handler));
+	return true;
 }
 
 template<typename Executor>
-void strand<Executor>::dispatch(std::function<void()> f)
+template<typename Handler, typename CompletionToken>
+typename async_result<typename std::decay<CompletionToken>::type, void(std::error_code)>::return_type
+strand<Executor>::post_when_ready(Handler&& f, CompletionToken&& token)
 {
-	if (running_in_this_thread())
-		executor_.dispatch(f);
-	else
-		post(f);
+	return async_initiate<void(std::error_code)>(detail::initiate_post_when_ready<strand>{ this, detail::make_admission_waiter(std::forward<Handler>(f)) },
+		std::forward<CompletionToken>(token));
 }
 
 template<typename Executor>
-void post(strand<Executor>& strand_, std::function<void()> f)
+template<typename Handler>
+void strand<Executor>::dispatch(Handler&& f)
 {
-	strand_.post(f);
+	if (running_in_this_thread())
+		executor_.dispatch(std::forward<Handler>(f));
+	else
+		post(std::forward<Handler>(f));
 }
 
 template<typename Executor>
-void dispatch(strand<Executor>& strand_, std::function<void()> f)
+template<typename Handler>
+void strand<Executor>::defer(Handler&& f)
 {
-	strand_.dispatch(f);
+	post(std::forward<Handler>(f));
 }
 
 } // namespace my_asio
@@ -0,0 +1,149 @@
+#ifndef MY_ASIO_STRAND_POOL_HPP
+#define MY_ASIO_STRAND_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "strand.hpp"
+
+namespace my_asio
+{
+
+template<typename Executor>
+class strand_pool;
+
+/*
+A copyable strand handle of a strand_pool, one pointer large. Handles mapped to the same
+implementation share its serialization: their handlers never run concurrently with each other
+either, and running_in_this_thread() is true inside any of them.
+The pool must outlive its handles
+*/
+template<typename Executor>
+class pooled_strand
+{
+public:
+	using executor_type = Executor;
+
+	executor_type get_inner_executor() const { return impl_->get_inner_executor(); }
+
+	bool running_in_this_thread() const { return impl_->running_in_this_thread(); }
+
+	void on_work_started() const { impl_->on_work_started(); }
+
+	void on_work_finished() const { impl_->on_work_finished(); }
+
+	template<typename Handler>
+	void post(Handler&& f) const
+	{
+		impl_->post(std::forward<Handler>(f));
+	}
+
+	template<typename Handler>
+	void dispatch(Handler&& f) const
+	{
+		impl_->dispatch(std::forward<Handler>(f));
+	}
+
+	template<typename Handler>
+	void defer(Handler&& f) const
+	{
+		impl_->defer(std::forward<Handler>(f));
+	}
+
+	friend bool operator==(const pooled_strand& a, const pooled_strand& b)
+	{
+		return a.impl_ == b.impl_;
+	}
+
+	friend bool operator!=(const pooled_strand& a, const pooled_strand& b)
+	{
+		return a.impl_ != b.impl_;
+	}
+
+private:
+	friend class strand_pool<Executor>;
+
+	explicit pooled_strand(strand<Executor>* impl)
+		: impl_(impl)
+	{	}
+
+	strand<Executor>* impl_;
+};
+
+/*
+A fixed number of strand implementations shared by any number of pooled_strand handles, as
+asio's strand_service does. With one strand per connection the memory stays bounded by the
+pool size and the implementations stay hot in the cache, at the price of unrelated handles
+sometimes waiting for each other
+*/
+template<typename Executor>
+class strand_pool
+{
+public:
+	using executor_type = Executor;
+
+	// the number of implementations asio's strand_service uses
+	static constexpr size_t default_size = 193;
+
+	explicit strand_pool(const executor_type& executor, size_t size = default_size)
+		: next_(0)
+	{
+		impls_.reserve(size ? size : 1);
+		for (size_t i = 0; i != impls_.capacity(); ++i)
+			impls_.emplace_back(executor);
+	}
+
+	strand_pool(const strand_pool&) = delete;
+	strand_pool& operator=(const strand_pool&) = delete;
+
+	size_t size() const { return impls_.size(); }
+
+	// consecutive handles go to consecutive implementations
+	pooled_strand<Executor> make_strand()
+	{
+		return pooled_strand<Executor>(&impls_[next_.fetch_add(1, std::memory_order_relaxed) % impls_.size()]);
+	}
+
+	// the same key always gives a handle of the same implementation, e.g. a connection id
+	pooled_strand<Executor> make_strand(uint64_t key)
+	{
+		// splitmix64 finalizer, sequential ids and addresses spread over the pool
+		key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ull;
+		key = (key ^ (key >> 27)) * 0x94D049BB133111EBull;
+		key ^= key >> 31;
+		return pooled_strand<Executor>(&impls_[key % impls_.size()]);
+	}
+
+	// see strand::set_turn_budget(), applies to every implementation
+	void set_turn_budget(size_t max_handlers, std::chrono::microseconds max_time = std::chrono::microseconds(0))
+	{
+		for (auto& impl : impls_)
+			impl.set_turn_budget(max_handlers, max_time);
+	}
+
+	// the counters of all implementations added up, max_handlers_per_turn is the largest
+	strand_stats stats() const
+	{
+		strand_stats result;
+		for (const auto& impl : impls_)
+		{
+			const strand_stats s = impl.stats();
+			result.turns += s.turns;
+			result.handlers += s.handlers;
+			result.max_handlers_per_turn = std::max(result.max_handlers_per_turn, s.max_handlers_per_turn);
+		}
+		return result;
+	}
+
+private:
+	std::vector<strand<Executor>> impls_;
+	std::atomic<size_t> next_;
+};
+
+} // namespace my_asio
+
+#endif // MY_ASIO_STRAND_POOL_HPP
\ No newline at end of file
@@ -0,0 +1,194 @@
+#ifndef MY_ASIO_TCP_HPP
+#define MY_ASIO_TCP_HPP
+
+#include "io_engine.hpp"
+
+#if defined(MY_ASIO_HAS_EPOLL)
+
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <sys/socket.h>
+
+#include "async_result.hpp"
+#include "io_context.hpp"
+#include "buffer.hpp"
+#include "error.hpp"
+#include "reactive_socket.hpp"
+
+namespace my_asio
+{
+namespace ip
+{
+
+class tcp
+{
+public:
+	class endpoint;
+	class socket;
+	class acceptor;
+};
+
+// A numeric IPv4 or IPv6 address and a port
+class tcp::endpoint
+{
+public:
+	// 0.0.0.0:0
+	endpoint();
+
+	// throws std::invalid_argument if address is not a numeric IPv4 or IPv6 address
+	endpoint(const std::string& address, unsigned short port);
+
+	std::string address() const;
+
+	unsigned short port() const;
+
+	int family() const;
+
+	const sockaddr* data() const;
+
+	sockaddr* data();
+
+	socklen_t size() const;
+
+	socklen_t capacity() const;
+
+private:
+	sockaddr_storage storage_;
+};
+
+/*
+A stream socket whose asynchronous operations are driven by the io_context's io_engine.
+Handlers run on a thread running the io_context, use bind_executor to run them on a strand.
+A pending operation counts as work of the io_context, closing the socket completes it with
+std::errc::operation_canceled. The io_context must outlive the socket
+*/
+class tcp::socket
+{
+public:
+	using executor_type = io_context::executor_type;
+
+	explicit socket(io_context& io);
+
+	socket(const socket&) = delete;
+	socket& operator=(const socket&) = delete;
+
+	executor_type get_executor();
+
+	bool is_open() const;
+
+	int native_handle() const;
+
+	// blocks until the connection is established, throws std::system_error
+	void connect(const endpoint& peer);
+
+	void close();
+
+	// completes the pending operations with operation_canceled, returns how many there were
+	size_t cancel();
+
+	// disables Nagle's algorithm
+	void set_no_delay(bool enabled);
+
+	endpoint local_endpoint() const;
+
+	endpoint remote_endpoint() const;
+
+	// handler(const std::error_code&, size_t bytes_transferred), or a completion token such as use_awaitable.
+	// Fails with error::eof once the peer has closed the connection
+	template<typename ReadHandler>
+	typename async_result<typename std::decay<ReadHandler>::type, void(std::error_code, size_t)>::return_type
+	async_read_some(const mutable_buffer& buffer, ReadHandler&& handler);
+
+	// handler(const std::error_code&, size_t bytes_transferred)
+	template<typename WriteHandler>
+	typename async_result<typename std::decay<WriteHandler>::type, void(std::error_code, size_t)>::return_type
+	async_write_some(const const_buffer& buffer, WriteHandler&& handler);
+
+private:
+	friend class acceptor;
+
+	detail::reactive_socket impl_;
+};
+
+class tcp::acceptor
+{
+public:
+	using executor_type = io_context::executor_type;
+
+	explicit acceptor(io_context& io);
+
+	// opens the acceptor and listens on local_endpoint, throws std::system_error
+	acceptor(io_context& io, const endpoint& local_endpoint, bool reuse_address = true);
+
+	acceptor(const acceptor&) = delete;
+	acceptor& operator=(const acceptor&) = delete;
+
+	executor_type get_executor();
+
+	// throws std::system_error
+	void listen(const endpoint& local_endpoint, bool reuse_address = true, int backlog = SOMAXCONN);
+
+	bool is_open() const;
+
+	int native_handle() const;
+
+	void close();
+
+	size_t cancel();
+
+	endpoint local_endpoint() const;
+
+	// handler(const std::error_code&), on success peer holds the new connection. peer must be closed
+	template<typename AcceptHandler>
+	typename async_result<typename std::decay<AcceptHandler>::type, void(std::error_code)>::return_type
+	async_accept(socket& peer, AcceptHandler&& handler);
+
+private:
+	detail::reactive_socket impl_;
+};
+
+template<typename ReadHandler>
+typename async_result<typename std::decay<ReadHandler>::type, void(std::error_code, size_t)>::return_type
+tcp::socket::async_read_some(const mutable_buffer& buffer, ReadHandler&& handler)
+{
+	return async_initiate<void(std::error_code, size_t)>([this, buffer](auto&& h) {
+		using op = detail::reactive_socket_op<typename std::decay<decltype(h)>::type, detail::receive_operation>;
+
+		impl_.start_op(detail::io_engine::read_op,
+			op::create(std::forward<decltype(h)>(h), detail::receive_operation{ impl_.native_handle(), buffer }));
+		}, std::forward<ReadHandler>(handler));
+}
+
+template<typename WriteHandler>
+typename async_result<typename std::decay<WriteHandler>::type, void(std::error_code, size_t)>::return_type
+tcp::socket::async_write_some(const const_buffer& buffer, WriteHandler&& handler)
+{
+	return async_initiate<void(std::error_code, size_t)>([this, buffer](auto&& h) {
+		using op = detail::reactive_socket_op<typename std::decay<decltype(h)>::type, detail::send_operation>;
+
+		impl_.start_op(detail::io_engine::write_op,
+			op::create(std::forward<decltype(h)>(h), detail::send_operation{ impl_.native_handle(), buffer }));
+		}, std::forward<WriteHandler>(handler));
+}
+
+template<typename AcceptHandler>
+typename async_result<typename std::decay<AcceptHandler>::type, void(std::error_code)>::return_type
+tcp::acceptor::async_accept(socket& peer, AcceptHandler&& handler)
+{
+	return async_initiate<void(std::error_code)>([this, &peer](auto&& h) {
+		using op = detail::reactive_socket_op<typename std::decay<decltype(h)>::type, detail::accept_operation>;
+
+		impl_.start_op(detail::io_engine::read_op,
+			op::create(std::forward<decltype(h)>(h), detail::accept_operation{ impl_.native_handle(), &peer.impl_ }));
+		}, std::forward<AcceptHandler>(handler));
+}
+
+} // namespace ip
+} // namespace my_asio
+
+#endif // defined(MY_ASIO_HAS_EPOLL)
+
+#endif // MY_ASIO_TCP_HPP
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef MY_ASIO_THREAD_POOL_HPP
+#define MY_ASIO_THREAD_POOL_HPP
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "io_context.hpp"
+#include "executor_work_guard.hpp"
+
+namespace my_asio
+{
+
+// Where the worker threads of a thread_pool run
+enum class thread_affinity
+{
+	none,		// wherever the OS schedules them
+	core,		// each worker is pinned to one CPU, the CPUs of a NUMA node are used before the next node's
+	numa_node	// each worker may run on the CPUs of one NUMA node, the workers are spread over the nodes
+};
+
+/*
+A fixed number of worker threads running an io_context, which they keep running until the
+pool is joined or stopped.
+Pinned workers run the io_context in scheduler_mode::work_stealing, so the handlers a handler
+posts stay on its worker. Each pinned worker fills its handler memory cache itself before it
+runs anything, so the handler storage it recycles comes from its own NUMA node
+*/
+class thread_pool
+{
+public:
+	using executor_type = io_context::executor_type;
+
+	// threads == 0 uses std::thread::hardware_concurrency()
+	explicit thread_pool(size_t threads = 0, thread_affinity affinity = thread_affinity::none);
+
+	thread_pool(const thread_pool&) = delete;
+	thread_pool& operator=(const thread_pool&) = delete;
+
+	// stops and joins the pool, handlers that have not run yet are destroyed
+	~thread_pool();
+
+	executor_type get_executor();
+
+	size_t size() const;
+
+	// the CPUs the worker has been placed on, empty with thread_affinity::none
+	std::vector<int> worker_cpus(size_t worker) const;
+
+	// the workers leave as soon as their current handler returns
+	void stop();
+
+	// gives up the pool's own work and blocks until the workers have left, which they do once
+	// no work is left, or right away after stop(). The pool can not run handlers afterwards
+	void join();
+
+	// same as join(), the name asio's thread_pool also offers
+	void wait();
+
+private:
+	void run_worker(size_t worker);
+
+	io_context io_;
+	std::unique_ptr<executor_work_guard<executor_type>> work_;
+	std::vector<std::vector<int>> worker_cpus_;
+
+	std::mutex threads_guard_;
+	std::vector<std::thread> threads_;
+};
+
+} // namespace my_asio
+
+#endif // MY_ASIO_THREAD_POOL_HPP
\ No newline at end of file
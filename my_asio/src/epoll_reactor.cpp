@@ -0,0 +1,240 @@
+#include "epoll_reactor.hpp"
+
+#if defined(MY_ASIO_HAS_EPOLL)
+
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace my_asio
+{
+namespace detail
+{
+
+namespace
+{
+
+constexpr int max_events = 128;
+
+// readiness that lets each kind of operation make progress, errors wake both
+constexpr uint32_t op_events[epoll_reactor::max_ops] = {
+	EPOLLIN | EPOLLPRI | EPOLLRDHUP | EPOLLERR | EPOLLHUP,
+	EPOLLOUT | EPOLLERR | EPOLLHUP
+};
+
+std::system_error last_error(const char* what)
+{
+	return std::system_error(errno, std::system_category(), what);
+}
+
+} // namespace
+
+epoll_reactor::epoll_reactor()
+	: epoll_fd_(::epoll_create1(EPOLL_CLOEXEC))
+	, interrupter_fd_(-1)
+	, timer_fd_(-1)
+{
+	if (epoll_fd_ == -1)
+		throw last_error("epoll_create1");
+
+	interrupter_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	timer_fd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (interrupter_fd_ == -1 || timer_fd_ == -1)
+	{
+		const std::system_error error = last_error("eventfd/timerfd_create");
+		if (interrupter_fd_ != -1)
+			::close(interrupter_fd_);
+		if (timer_fd_ != -1)
+			::close(timer_fd_);
+		::close(epoll_fd_);
+		throw error;
+	}
+
+	// level-triggered, so every blocking run sees a pending interrupt until one of them consumes it
+	epoll_event ev = {};
+	ev.events = EPOLLIN;
+	ev.data.ptr = &interrupter_fd_;
+	::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, interrupter_fd_, &ev);
+
+	ev.data.ptr = &timer_fd_;
+	::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &ev);
+}
+
+epoll_reactor::~epoll_reactor()
+{
+	if (timer_fd_ != -1)
+		::close(timer_fd_);
+	if (interrupter_fd_ != -1)
+		::close(interrupter_fd_);
+	if (epoll_fd_ != -1)
+		::close(epoll_fd_);
+}
+
+io_engine::descriptor_state* epoll_reactor::register_descriptor(int descriptor)
+{
+	descriptor_state* state;
+	{
+		std::lock_guard<std::mutex> lock(registry_guard_);
+		if (free_states_.empty())
+		{
+			states_.emplace_back(new descriptor_state());
+			state = states_.back().get();
+		}
+		else
+		{
+			state = free_states_.back();
+			free_states_.pop_back();
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(state->guard_);
+		state->descriptor_ = descriptor;
+	}
+
+	epoll_event ev = {};
+	ev.events = EPOLLIN | EPOLLOUT | EPOLLPRI | EPOLLRDHUP | EPOLLERR | EPOLLHUP | EPOLLET;
+	ev.data.ptr = state;
+	if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, descriptor, &ev) == -1)
+	{
+		const std::system_error error = last_error("epoll_ctl");
+		op_queue none;
+		deregister_descriptor(state, none);
+		throw error;
+	}
+
+	return state;
+}
+
+void epoll_reactor::deregister_descriptor(io_engine::descriptor_state* base, op_queue& completed)
+{
+	descriptor_state* state = static_cast<descriptor_state*>(base);
+	{
+		std::lock_guard<std::mutex> lock(state->guard_);
+		if (state->descriptor_ != -1)
+		{
+			epoll_event ev = {};
+			::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, state->descriptor_, &ev);
+			state->descriptor_ = -1;
+		}
+
+		for (op_queue& ops : state->ops_)
+		{
+			while (!ops.empty())
+			{
+				async_op* op = ops.pop();
+				op->ec = std::make_error_code(std::errc::operation_canceled);
+				completed.push(op);
+			}
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(registry_guard_);
+	free_states_.push_back(state);
+}
+
+size_t epoll_reactor::cancel_ops(io_engine::descriptor_state* base, op_queue& completed)
+{
+	descriptor_state* state = static_cast<descriptor_state*>(base);
+	std::lock_guard<std::mutex> lock(state->guard_);
+
+	size_t count = 0;
+	for (op_queue& ops : state->ops_)
+	{
+		while (!ops.empty())
+		{
+			async_op* op = ops.pop();
+			op->ec = std::make_error_code(std::errc::operation_canceled);
+			completed.push(op);
+			++count;
+		}
+	}
+	return count;
+}
+
+void epoll_reactor::start_op(op_type type, io_engine::descriptor_state* base, reactor_op* op, op_queue& completed)
+{
+	descriptor_state* state = static_cast<descriptor_state*>(base);
+	std::lock_guard<std::mutex> lock(state->guard_);
+
+	if (state->descriptor_ == -1)
+	{
+		op->ec = std::make_error_code(std::errc::bad_file_descriptor);
+		completed.push(op);
+		return;
+	}
+
+	// an edge that came while nothing was queued is gone, so the operation is tried right away
+	if (state->ops_[type].empty() && op->perform())
+	{
+		completed.push(op);
+		return;
+	}
+
+	state->ops_[type].push(op);
+}
+
+void epoll_reactor::run(bool block, std::chrono::steady_clock::time_point deadline, op_queue& completed)
+{
+	if (block && deadline != std::chrono::steady_clock::time_point::max())
+		set_timer(deadline);
+
+	epoll_event events[max_events];
+	int count = ::epoll_wait(epoll_fd_, events, max_events, block ? -1 : 0);
+
+	for (int i = 0; i < count; ++i)
+	{
+		void* ptr = events[i].data.ptr;
+		if (ptr == &interrupter_fd_ || ptr == &timer_fd_)
+		{
+			if (block)
+			{
+				uint64_t value;
+				while (::read(*static_cast<int*>(ptr), &value, sizeof(value)) == -1 && errno == EINTR)
+				{	}
+			}
+			continue;
+		}
+
+		descriptor_state* state = static_cast<descriptor_state*>(ptr);
+		std::lock_guard<std::mutex> lock(state->guard_);
+		for (int type = 0; type != max_ops; ++type)
+		{
+			if (!(events[i].events & op_events[type]))
+				continue;
+
+			op_queue& ops = state->ops_[type];
+			while (!ops.empty() && static_cast<reactor_op*>(ops.front())->perform())
+				completed.push(ops.pop());
+		}
+	}
+}
+
+void epoll_reactor::interrupt()
+{
+	const uint64_t value = 1;
+	while (::write(interrupter_fd_, &value, sizeof(value)) == -1 && errno == EINTR)
+	{	}
+}
+
+void epoll_reactor::set_timer(std::chrono::steady_clock::time_point deadline)
+{
+	// steady_clock counts CLOCK_MONOTONIC, a zero it_value would disarm the timer
+	const std::chrono::nanoseconds since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch());
+	const long long ns = since_epoch.count() > 0 ? since_epoch.count() : 1;
+
+	itimerspec spec = {};
+	spec.it_value.tv_sec = time_t(ns / 1'000'000'000);
+	spec.it_value.tv_nsec = long(ns % 1'000'000'000);
+	::timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // defined(MY_ASIO_HAS_EPOLL)
\ No newline at end of file
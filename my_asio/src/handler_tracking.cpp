@@ -0,0 +1,219 @@
+#include "handler_trace.hpp"
+
+#include "handler_tracking.hpp"
+
+#if defined(MY_ASIO_ENABLE_HANDLER_TRACKING)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "append_printf.hpp"
+
+namespace my_asio
+{
+
+namespace
+{
+
+struct trace_event
+{
+	uint64_t id;
+	uint64_t parent;		// posted events only
+	const void* strand;
+	int64_t begin_ns;
+	int64_t end_ns;
+	bool posted;			// the post of the handler, otherwise its run
+};
+
+// written by its thread and read by the exporter, so guard is only contended while exporting
+struct trace_ring
+{
+	explicit trace_ring(uint32_t thread_number)
+		: thread(thread_number)
+		, events(handler_trace_capacity)
+	{	}
+
+	void push(const trace_event& e)
+	{
+		std::lock_guard<std::mutex> lock(guard);
+		events[next] = e;
+		next = (next + 1) % events.size();
+		if (size != events.size())
+			++size;
+	}
+
+	std::mutex guard;
+	const uint32_t thread;
+	std::vector<trace_event> events;
+	size_t next = 0;
+	size_t size = 0;
+};
+
+// the rings outlive their threads, so the trace of a finished thread can still be exported
+struct trace_registry
+{
+	std::mutex guard;
+	std::vector<std::shared_ptr<trace_ring>> rings;
+};
+
+trace_registry& registry()
+{
+	// never destroyed, threads may record while static objects are being destroyed
+	static trace_registry* r = new trace_registry();
+	return *r;
+}
+
+trace_ring& this_thread_ring()
+{
+	thread_local std::shared_ptr<trace_ring> ring;
+	if (!ring)
+	{
+		trace_registry& r = registry();
+		std::lock_guard<std::mutex> lock(r.guard);
+		ring = std::make_shared<trace_ring>(uint32_t(r.rings.size() + 1));
+		r.rings.push_back(ring);
+	}
+	return *ring;
+}
+
+int64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::atomic<uint64_t> next_handler_id(1);
+
+struct posted_handler
+{
+	uint64_t parent;
+	uint32_t thread;
+	int64_t posted_ns;
+};
+
+} // namespace
+
+void detail::handler_tracking::creation(any_handler& handler, const void* strand)
+{
+	handler.trace_id_ = next_handler_id.fetch_add(1, std::memory_order_relaxed);
+
+	const frame* parent = call_stack<const frame, const frame>::get_top();
+	const int64_t now = now_ns();
+	this_thread_ring().push({ handler.trace_id_, parent ? parent->id : 0, strand, now, now, true });
+}
+
+detail::handler_tracking::invocation::invocation(const any_handler& handler, const void* strand)
+	: frame_{ handler.trace_id_, strand }
+	, started_(now_ns())
+	, context_(&frame_, &frame_)
+{	}
+
+detail::handler_tracking::invocation::~invocation()
+{
+	this_thread_ring().push({ frame_.id, 0, frame_.strand, started_, now_ns(), false });
+}
+
+std::string handler_trace_json()
+{
+	std::vector<std::pair<uint32_t, trace_event>> events;
+	{
+		trace_registry& r = registry();
+		std::lock_guard<std::mutex> lock(r.guard);
+		for (const auto& ring : r.rings)
+		{
+			std::lock_guard<std::mutex> ring_lock(ring->guard);
+			const size_t first = (ring->next + ring->events.size() - ring->size) % ring->events.size();
+			for (size_t i = 0; i != ring->size; ++i)
+				events.emplace_back(ring->thread, ring->events[(first + i) % ring->events.size()]);
+		}
+	}
+
+	std::unordered_map<uint64_t, posted_handler> posts;
+	uint32_t threads = 0;
+	for (const auto& e : events)
+	{
+		if (e.second.posted)
+			posts[e.second.id] = { e.second.parent, e.first, e.second.begin_ns };
+		threads = std::max(threads, e.first);
+	}
+
+	std::string out = "{\"traceEvents\": [";
+	const char* separator = "\n";
+	for (uint32_t thread = 1; thread <= threads; ++thread)
+	{
+		detail::append_printf(out, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %" PRIu32 ", \"args\": {\"name\": \"thread %" PRIu32 "\"}}",
+			separator, thread, thread);
+		separator = ",\n";
+	}
+
+	for (const auto& e : events)
+	{
+		const trace_event& ran = e.second;
+		if (ran.posted)
+			continue;
+
+		detail::append_printf(out, "%s{\"name\": \"%s %" PRIu64 "\", \"cat\": \"handler\", \"ph\": \"X\", \"pid\": 1, \"tid\": %" PRIu32
+			", \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"id\": %" PRIu64,
+			separator, ran.strand ? "strand handler" : "handler", ran.id, e.first,
+			ran.begin_ns / 1e3, (ran.end_ns - ran.begin_ns) / 1e3, ran.id);
+		separator = ",\n";
+		if (ran.strand)
+			detail::append_printf(out, ", \"strand\": \"%p\"", ran.strand);
+
+		const auto post = posts.find(ran.id);
+		if (post != posts.end())
+		{
+			detail::append_printf(out, ", \"parent\": %" PRIu64 ", \"queued_us\": %.3f}}", post->second.parent, (ran.begin_ns - post->second.posted_ns) / 1e3);
+
+			// flow arrow from the post to the run
+			detail::append_printf(out, ",\n{\"name\": \"post\", \"cat\": \"handler\", \"ph\": \"s\", \"id\": %" PRIu64 ", \"pid\": 1, \"tid\": %" PRIu32 ", \"ts\": %.3f}",
+				ran.id, post->second.thread, post->second.posted_ns / 1e3);
+			detail::append_printf(out, ",\n{\"name\": \"post\", \"cat\": \"handler\", \"ph\": \"f\", \"bp\": \"e\", \"id\": %" PRIu64 ", \"pid\": 1, \"tid\": %" PRIu32 ", \"ts\": %.3f}",
+				ran.id, e.first, ran.begin_ns / 1e3);
+		}
+		else
+		{
+			// the post has been overwritten, or happened before the trace was cleared
+			out += "}}";
+		}
+	}
+
+	out += "\n]}\n";
+	return out;
+}
+
+void clear_handler_trace()
+{
+	trace_registry& r = registry();
+	std::lock_guard<std::mutex> lock(r.guard);
+	for (const auto& ring : r.rings)
+	{
+		std::lock_guard<std::mutex> ring_lock(ring->guard);
+		ring->next = 0;
+		ring->size = 0;
+	}
+}
+
+} // namespace my_asio
+
+#else
+
+namespace my_asio
+{
+
+std::string handler_trace_json()
+{
+	return "{\"traceEvents\": []}\n";
+}
+
+void clear_handler_trace()
+{	}
+
+} // namespace my_asio
+
+#endif // defined(MY_ASIO_ENABLE_HANDLER_TRACKING)
\ No newline at end of file
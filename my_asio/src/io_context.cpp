@@ -1,38 +1,285 @@
 #include "io_context.hpp"
 
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+#include "cpu_relax.hpp"
+#include "epoll_reactor.hpp"
+#include "handler_tracking.hpp"
+#include "io_uring_engine.hpp"
+#include "mutex_handler_queue.hpp"
+#include "lockfree_handler_queue.hpp"
+#include "sharded_metrics.hpp"
+#include "single_consumer_handler_queue.hpp"
+
 namespace my_asio
 {
 
-size_t io_context::do_one(bool blocking)
+namespace
 {
-	for (;;)
+
+// bounds of the adaptive spin performed before an idle thread parks
+constexpr size_t min_spin_limit = 16;
+constexpr size_t default_max_spin_limit = 4096;
+
+// a worker with local handlers still checks the shared queue every this many handlers
+constexpr unsigned shared_queue_check_interval = 61;
+
+// a busy thread still polls the reactor every this many handlers, so I/O is not starved
+constexpr unsigned reactor_poll_interval = 64;
+
+// and checks the timers every this many, rather than reading the clock before every handler
+constexpr unsigned timer_check_interval = 16;
+
+// a thread retires its work credits once it has collected this many
+constexpr size_t max_work_credits = 256;
+
+constexpr unsigned default_next_handler_limit = 8;
+
+constexpr unsigned default_priority_weights[] = { 8, 4, 1 };
+
+constexpr size_t priority_index(handler_priority priority)
+{
+	return static_cast<size_t>(priority);
+}
+
+std::unique_ptr<detail::handler_queue> make_handler_queue(queue_backend backend)
+{
+	if (backend == queue_backend::lock_free)
+		return std::unique_ptr<detail::handler_queue>(new detail::lockfree_handler_queue());
+	return std::unique_ptr<detail::handler_queue>(new detail::mutex_handler_queue());
+}
+
+constexpr std::chrono::steady_clock::rep no_timer_event = std::numeric_limits<std::chrono::steady_clock::rep>::max();
+
+// a handler whose time in the queue is sampled
+struct queue_wait_handler
+{
+	any_handler handler;
+	std::chrono::steady_clock::time_point queued;
+	detail::latency_histogram* queue_wait;
+
+	void operator()()
+	{
+		queue_wait->record(std::chrono::steady_clock::now() - queued);
+		handler();
+	}
+};
+
+// counts the handlers when metrics are on, and wraps the sampled ones to measure their wait
+void track_queued_handlers(detail::io_context_metrics_state* metrics, any_handler* handlers, size_t count)
+{
+	if (!metrics)
+		return;
+
+	metrics->handlers_queued.add(count);
+	for (size_t i = 0; i != count; ++i)
+		if (detail::this_thread_takes_sample(metrics->sample_interval))
+			handlers[i] = any_handler(queue_wait_handler{ std::move(handlers[i]), std::chrono::steady_clock::now(), &metrics->queue_wait });
+}
+
+} // namespace
+
+// Makes the io_context visible through call_stack and registers the thread as a worker
+class io_context::thread_context
+{
+public:
+	thread_context(io_context& io)
+		: io_(io)
+		, ctx_(&io, &outer_flush(io, info_))
 	{
+		io_.register_worker(info_);
+	}
+
+	// hands what the thread still holds back to the io_context. Called on every way out of run_handlers(),
+	// also when a handler has thrown, but not from the destructor: queueing may allocate and throw
+	void leave()
+	{
+		io_.flush_private_handlers(info_, 0);
+
+		// a batch interrupted by stop() goes back to the front of the shared queue, it is older than the handlers queued since
+		size_t returned = info_.batch.size() - info_.batch_pos;
+		if (returned)
+			io_.work_queue_->push_front_all(info_.batch.data() + info_.batch_pos, returned);
+
+		// a continuation that has not run goes ahead of it, it would have run next
+		if (info_.next_handler)
+		{
+			io_.work_queue_->push_front_all(&info_.next_handler, 1);
+			++returned;
+		}
 
+		if (returned)
+			io_.wake_idle_threads(returned);
+
+		io_.unregister_worker(info_);
+		io_.retire_work_credits(info_);
+	}
+
+	// batches are only taken by run() and poll(), run_one() and poll_one() take a single handler
+	void enable_batching()
+	{
+		info_.batch_limit = io_.batch_size();
+	}
+
+	detail::thread_info& info() { return info_; }
+
+private:
+	// a nested run() must be able to see the handlers posted so far by the enclosing handler
+	static detail::thread_info& outer_flush(io_context& io, detail::thread_info& info)
+	{
+		if (detail::thread_info* outer = detail::call_stack<io_context, detail::thread_info>::contains(&io))
+			io.flush_private_handlers(*outer, 0);
+		return info;
+	}
+
+	io_context& io_;
+	detail::thread_info info_;
+	detail::call_stack<io_context, detail::thread_info>::context ctx_;
+};
+
+io_context::io_context(queue_backend backend, scheduler_mode mode, io_backend io)
+	: io_context(backend, mode, io, false)
+{	}
+
+io_context::io_context(queue_backend backend, scheduler_mode mode, io_backend io, bool single_threaded)
+	: stopped_(0)
+	, outstanding_work_(0)
+	, admission_(nullptr)
+	, batch_size_(1)
+	, next_handler_limit_(default_next_handler_limit)
+	, prioritized_handlers_(0)
+	, single_threaded_(single_threaded)
+	// there is no other worker to steal from
+	, mode_(single_threaded ? scheduler_mode::shared_queue : mode)
+	, idle_threads_(0)
+	, spin_limit_(0)
+	// spinning only pays off when another core can post while we spin
+	, max_spin_limit_(std::thread::hardware_concurrency() > 1 ? default_max_spin_limit : 0)
+	, next_timer_event_(no_timer_event)
+	, event_waiter_(false)
+	, reactor_waiting_(false)
+	, io_backend_(io)
+	, metrics_(nullptr)
+#if defined(MY_ASIO_HAS_EPOLL)
+	, reactor_(nullptr)
+#endif
+{
+	if (single_threaded_)
+		work_queue_.reset(new detail::single_consumer_handler_queue());
+	else
+		work_queue_ = make_handler_queue(backend);
+	priority_queues_[priority_index(handler_priority::high)] = make_handler_queue(backend);
+	priority_queues_[priority_index(handler_priority::low)] = make_handler_queue(backend);
+	for (size_t i = 0; i != priority_levels; ++i)
+		priority_credits_[i] = priority_weights_[i] = default_priority_weights[i];
+
+	spin_limit_ = max_spin_limit_ / 4;
+
+	// the backend is settled here, so io_backend_in_use() does not change later
+	if (io_backend_ == io_backend::io_uring)
+	{
+#if defined(MY_ASIO_HAS_IO_URING)
+		reactor();
+#else
+		io_backend_ = io_backend::epoll;
+#endif
+	}
+}
+
+io_context::~io_context()
+{
+	// the handlers destroyed with the queues must not admit waiters any more. The producers still
+	// waiting in post_when_ready() are completed with operation_canceled right here, as this
+	// io_context will not run another handler
+	if (admission_owner_)
+		admission_owner_->shutdown([](std::unique_ptr<detail::admission_waiter> w) {
+			w->completion();
+			});
+}
+
+io_context::io_context(scheduler_mode mode)
+	: io_context(queue_backend::mutex, mode)
+{	}
+
+io_context::io_context(io_backend io)
+	: io_context(queue_backend::mutex, scheduler_mode::shared_queue, io)
+{	}
+
+io_context::io_context(int concurrency_hint)
+	: io_context(queue_backend::mutex, scheduler_mode::shared_queue, io_backend::epoll, concurrency_hint == 1)
+{	}
+
+size_t io_context::do_one(detail::thread_info& this_thread, bool blocking)
+{
+	for (;;)
+	{
 		if (stopped())
 			return 0;
 
-		std::unique_lock<std::mutex> lock(queue_guard_);
+		if (++this_thread.timer_ticks == timer_check_interval)
+		{
+			this_thread.timer_ticks = 0;
+			if (timers_due())
+				run_expired_timers();
+		}
 
-		if (stopped())
+#if defined(MY_ASIO_HAS_EPOLL)
+		if (++this_thread.reactor_ticks == reactor_poll_interval)
 		{
-			lock.unlock();
-			return 0;
+			this_thread.reactor_ticks = 0;
+			poll_reactor();
 		}
+#endif
 
-		std::function<void()> handler;
-		if (!work_queue_.empty())
+		any_handler handler;
+		if (try_pop_handler(this_thread, handler))
 		{
-			handler = work_queue_.front();
-			work_queue_.pop();
-			lock.unlock(); // unlock before handler so that handler itself could post(acquires lock)
-			handler();
-			work_finished();
+			detail::io_context_metrics_state* metrics = metrics_.load(std::memory_order_acquire);
+			std::chrono::steady_clock::time_point started;
+			if (metrics && detail::this_thread_takes_sample(metrics->sample_interval))
+				started = std::chrono::steady_clock::now();
+
+			try
+			{
+				MY_ASIO_HANDLER_INVOCATION(handler, nullptr);
+				handler();
+			}
+			catch (...)
+			{
+				// the handler's work is finished even if it throws. Done here rather than in a destructor,
+				// so an exception queueing the deferred handlers replaces the handler's instead of terminating
+				handler_finished(this_thread, metrics, started);
+				throw;
+			}
+
+			handler_finished(this_thread, metrics, started);
 			return 1;
 		}
-		else if (outstanding_work_)
+
+		// out of handlers, expired timers may have queued some
+		if (timers_due())
+		{
+			run_expired_timers();
+			continue;
+		}
+
+		// the work this thread has finished may be the last
+		retire_work_credits(this_thread);
+		if (outstanding_work_)
 		{
 			if (blocking)
+			{
+				if (!spin_for_work())
+					wait_for_work();
 				continue;
+			}
+
+#if defined(MY_ASIO_HAS_EPOLL)
+			if (poll_reactor())
+				continue;
+#endif
 		}
 		else
 		{
@@ -43,45 +290,800 @@ size_t io_context::do_one(bool blocking)
 	}
 }
 
-size_t io_context::run()
+void io_context::handler_finished(detail::thread_info& this_thread, detail::io_context_metrics_state* metrics,
+	std::chrono::steady_clock::time_point started)
 {
-	detail::call_stack<io_context>::context ctx(this);
+	if (metrics)
+	{
+		metrics->handlers_run.add(1);
+		if (started != std::chrono::steady_clock::time_point())
+			metrics->run_time.record(std::chrono::steady_clock::now() - started);
+	}
 
-	size_t cnt = 0;
-	while (do_one(1))
-		++cnt;
+#if defined(MY_ASIO_HAS_EPOLL)
+	// the operations started by the handler go to the kernel together
+	if (this_thread.io_submit_pending)
+	{
+		this_thread.io_submit_pending = false;
+		reactor_.load(std::memory_order_relaxed)->submit();
+	}
+#endif
 
-	return cnt;
+	flush_private_handlers(this_thread, 1);
 }
 
-size_t io_context::run_one()
+bool io_context::spin_for_work()
 {
-	detail::call_stack<io_context>::context ctx(this);
+	const size_t limit = spin_limit_.load(std::memory_order_relaxed);
+	for (size_t i = 0; i != limit; ++i)
+	{
+		// only the shared queues are watched here, local queues are checked before parking
+		if (!work_queue_->empty() || prioritized_handlers_.load(std::memory_order_relaxed) || stopped())
+		{
+			// spinning paid off, allow a longer spin next time
+			spin_limit_.store(std::min(limit * 2, max_spin_limit_), std::memory_order_relaxed);
+			return true;
+		}
+		detail::cpu_relax();
+	}
 
-	return do_one(1);
+	spin_limit_.store(std::max(limit / 2, std::min(min_spin_limit, max_spin_limit_)), std::memory_order_relaxed);
+	return false;
 }
 
-size_t io_context::poll()
+void io_context::wait_for_work()
 {
-	detail::call_stack<io_context>::context ctx(this);
+	detail::op_queue completed;
+	{
+		std::unique_lock<std::mutex> lock(wakeup_guard_);
+		idle_threads_.fetch_add(1);
 
-	size_t cnt = 0;
-	while (do_one(0))
-		++cnt;
+		// pairs with the fence in wake_one_idle_thread(): either the poster sees us idle,
+		// or we see its handler in the queue
+		std::atomic_thread_fence(std::memory_order_seq_cst);
 
-	return cnt;
+		if (!stopped() && all_queues_empty() && outstanding_work_)
+		{
+			const std::chrono::steady_clock::rep next_timer_event = next_timer_event_.load();
+			const std::chrono::steady_clock::time_point deadline = next_timer_event == no_timer_event
+				? std::chrono::steady_clock::time_point::max()
+				: std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(next_timer_event));
+
+#if defined(MY_ASIO_HAS_EPOLL)
+			detail::io_engine* reactor = reactor_.load(std::memory_order_acquire);
+#else
+			void* reactor = nullptr;
+#endif
+
+			if (event_waiter_ || (!reactor && next_timer_event == no_timer_event))
+			{
+				wakeup_event_.wait(lock);
+			}
+			else if (!reactor)
+			{
+				event_waiter_ = true;
+				wakeup_event_.wait_until(lock, deadline);
+				event_waiter_ = false;
+			}
+#if defined(MY_ASIO_HAS_EPOLL)
+			else
+			{
+				event_waiter_ = true;
+				reactor_waiting_ = true;
+				lock.unlock();
+
+				reactor->run(true, deadline, completed);
+
+				lock.lock();
+				reactor_waiting_ = false;
+				event_waiter_ = false;
+			}
+#endif
+		}
+
+		idle_threads_.fetch_sub(1);
+	}
+
+	post_completed_ops(completed.release());
+}
+
+void io_context::wake_one_idle_thread()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (idle_threads_.load(std::memory_order_relaxed))
+	{
+		std::lock_guard<std::mutex> lock(wakeup_guard_);
+		notify_idle_threads(1);
+	}
+}
+
+void io_context::wake_idle_threads(size_t count)
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (idle_threads_.load(std::memory_order_relaxed))
+	{
+		std::lock_guard<std::mutex> lock(wakeup_guard_);
+		notify_idle_threads(count);
+	}
+}
+
+void io_context::notify_idle_threads(size_t count)
+{
+	const size_t waiting = idle_threads_.load(std::memory_order_relaxed) - (reactor_waiting_ ? 1 : 0);
+	if (count >= waiting)
+		wakeup_event_.notify_all();
+	else
+		for (size_t i = 0; i != count; ++i)
+			wakeup_event_.notify_one();
+
+#if defined(MY_ASIO_HAS_EPOLL)
+	if (count > waiting && reactor_waiting_)
+		reactor_.load(std::memory_order_relaxed)->interrupt();
+#endif
+}
+
+void io_context::notify_all_idle_threads()
+{
+	std::lock_guard<std::mutex> lock(wakeup_guard_);
+	wakeup_event_.notify_all();
+
+#if defined(MY_ASIO_HAS_EPOLL)
+	if (reactor_waiting_)
+		reactor_.load(std::memory_order_relaxed)->interrupt();
+#endif
+}
+
+void io_context::post_handler(any_handler&& handler)
+{
+	admit_handler(handler);
+	enqueue_handler(std::move(handler));
+}
+
+void io_context::defer_handler(any_handler&& handler)
+{
+	admit_handler(handler);
+	enqueue_handler(std::move(handler), true);
+}
+
+void io_context::yield_handler(any_handler&& handler)
+{
+	if (detail::thread_info* this_thread = detail::call_stack<io_context, detail::thread_info>::contains(this))
+		this_thread->yielded = true;
+
+	post_handler(std::move(handler));
+}
+
+bool io_context::try_post_handler(any_handler&& handler)
+{
+	detail::admission_control* admission = admission_.load(std::memory_order_acquire);
+	if (admission)
+	{
+		if (!admission->try_admit())
+			return false;
+		handler = any_handler(detail::admitted_handler<io_context>(std::move(handler), this));
+	}
+
+	enqueue_handler(std::move(handler));
+	return true;
+}
+
+void io_context::post_when_ready_handler(std::unique_ptr<detail::admission_waiter> waiter)
+{
+	detail::admission_control* admission = admission_.load(std::memory_order_acquire);
+	if (!admission)
+	{
+		enqueue_handler(std::move(waiter->handler));
+		enqueue_handler(std::move(waiter->completion));
+		return;
+	}
+
+	admission->wait(std::move(waiter), [this](std::unique_ptr<detail::admission_waiter> w) {
+		admit_waiter(std::move(w));
+		});
+}
+
+void io_context::admit_handler(any_handler& handler)
+{
+	if (detail::admission_control* admission = admission_.load(std::memory_order_acquire))
+	{
+		admission->admit();
+		handler = any_handler(detail::admitted_handler<io_context>(std::move(handler), this));
+	}
+}
+
+void io_context::release_admission()
+{
+	admission_.load(std::memory_order_relaxed)->release([this](std::unique_ptr<detail::admission_waiter> w) {
+		admit_waiter(std::move(w));
+		});
+}
+
+void io_context::admit_waiter(std::unique_ptr<detail::admission_waiter> waiter)
+{
+	// the handler's slot has been reserved, the completion is not counted
+	enqueue_handler(any_handler(detail::admitted_handler<io_context>(std::move(waiter->handler), this)));
+	enqueue_handler(std::move(waiter->completion));
+}
+
+void io_context::enqueue_handler(any_handler&& handler, bool continuation)
+{
+	track_queued_handlers(metrics_.load(std::memory_order_acquire), &handler, 1);
+	MY_ASIO_HANDLER_CREATION(handler, nullptr);
+
+	detail::thread_info* this_thread = detail::call_stack<io_context, detail::thread_info>::contains(this);
+	if (this_thread)
+	{
+		// handlers posted from inside a handler stay on the posting worker
+		if (this_thread->local_queue)
+		{
+			work_started(*this_thread, 1);
+			this_thread->local_queue->push(std::move(handler));
+			wake_one_idle_thread();
+			return;
+		}
+
+		if (continuation)
+		{
+			this_thread->private_queue.push_back(std::move(handler));
+			++this_thread->private_outstanding_work;
+			return;
+		}
+
+		// the work is settled with the thread's credits, a post can still run on another thread right away
+		work_started(*this_thread, 1);
+		if (single_threaded_)
+		{
+			work_queue_->push_all_from_consumer(&handler, 1);
+			return;
+		}
+
+		work_queue_->push(std::move(handler));
+		wake_one_idle_thread();
+		return;
+	}
+
+	outstanding_work_.fetch_add(1);
+	work_queue_->push(std::move(handler));
+	wake_one_idle_thread();
+}
+
+void io_context::post_handler(any_handler&& handler, handler_priority priority)
+{
+	if (priority == handler_priority::normal)
+	{
+		post_handler(std::move(handler));
+		return;
+	}
+
+	admit_handler(handler);
+	track_queued_handlers(metrics_.load(std::memory_order_acquire), &handler, 1);
+	MY_ASIO_HANDLER_CREATION(handler, nullptr);
+
+	// counted before it is queued, so a popper never sees more handlers than the count
+	work_started();
+	prioritized_handlers_.fetch_add(1);
+	priority_queues_[priority_index(priority)]->push(std::move(handler));
+	wake_one_idle_thread();
+}
+
+void io_context::post_handlers(any_handler* handlers, size_t count)
+{
+	if (count == 0)
+		return;
+
+	for (size_t i = 0; i != count; ++i)
+		admit_handler(handlers[i]);
+
+	track_queued_handlers(metrics_.load(std::memory_order_acquire), handlers, count);
+	for (size_t i = 0; i != count; ++i)
+		MY_ASIO_HANDLER_CREATION(handlers[i], nullptr);
+
+	detail::thread_info* this_thread = detail::call_stack<io_context, detail::thread_info>::contains(this);
+	if (this_thread)
+	{
+		if (this_thread->local_queue)
+		{
+			work_started(*this_thread, count);
+			for (size_t i = 0; i != count; ++i)
+				this_thread->local_queue->push(std::move(handlers[i]));
+			wake_idle_threads(count);
+			return;
+		}
+
+		work_started(*this_thread, count);
+		if (single_threaded_)
+		{
+			work_queue_->push_all_from_consumer(handlers, count);
+			return;
+		}
+
+		work_queue_->push_all(handlers, count);
+		wake_idle_threads(count);
+		return;
+	}
+
+	outstanding_work_.fetch_add(count);
+	work_queue_->push_all(handlers, count);
+	wake_idle_threads(count);
+}
+
+void io_context::flush_private_handlers(detail::thread_info& this_thread, size_t finished_handlers)
+{
+	const size_t count = this_thread.private_outstanding_work;
+	const bool yielded = this_thread.yielded;
+	this_thread.yielded = false;
+	if (count == 0)
+	{
+		if (finished_handlers)
+			work_finished(this_thread, finished_handlers);
+		return;
+	}
+
+	// a single continuation of a finished handler keeps its work and runs next, unless the slot is
+	// still taken because prioritized handlers ran ahead of it
+	if (count == 1 && finished_handlers == 1 && !yielded && !this_thread.next_handler)
+	{
+		const unsigned limit = next_handler_limit_.load(std::memory_order_relaxed);
+		if (this_thread.next_handler_streak < limit)
+		{
+			this_thread.private_outstanding_work = 0;
+			this_thread.next_handler = std::move(this_thread.private_queue.front());
+			this_thread.private_queue.clear();
+			return;
+		}
+
+		if (limit)
+			if (detail::io_context_metrics_state* metrics = metrics_.load(std::memory_order_acquire))
+				metrics->next_handler_spills.add(1);
+	}
+
+	// the work is counted before the handlers become visible to other threads,
+	// so the count can not drop to zero while they are queued
+	this_thread.private_outstanding_work = 0;
+	this_thread.work_credits += finished_handlers;
+	work_started(this_thread, count);
+
+	work_queue_->push_all_from_consumer(this_thread.private_queue.data(), count);
+	this_thread.private_queue.clear();
+
+	// with a single thread running the io_context, that is the thread they were posted from
+	if (!single_threaded_)
+		wake_idle_threads(count);
+}
+
+void io_context::schedule_timer(detail::timer_data& timer, std::chrono::steady_clock::time_point expiry, detail::async_op* op)
+{
+	work_started();
+
+	std::chrono::steady_clock::rep previous_event;
+	{
+		std::lock_guard<std::mutex> lock(timers_guard_);
+		if (!detail::timer_wheel::scheduled(timer))
+			timers_.schedule(timer, expiry);
+
+		if (timer.last_waiter)
+			timer.last_waiter->next = op;
+		else
+			timer.first_waiter = op;
+		timer.last_waiter = op;
+
+		previous_event = next_timer_event_.load(std::memory_order_relaxed);
+		update_next_timer_event();
+	}
+
+	// the event waiter sleeps until the previous event, every idle thread
+	// is woken so one of them picks up the earlier deadline
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (next_timer_event_.load(std::memory_order_relaxed) < previous_event && idle_threads_.load(std::memory_order_relaxed))
+		notify_all_idle_threads();
+}
+
+size_t io_context::cancel_timer(detail::timer_data& timer)
+{
+	detail::async_op* ops;
+	{
+		std::lock_guard<std::mutex> lock(timers_guard_);
+		timers_.cancel(timer);
+
+		ops = timer.first_waiter;
+		timer.first_waiter = timer.last_waiter = nullptr;
+
+		update_next_timer_event();
+	}
+
+	size_t count = 0;
+	for (detail::async_op* op = ops; op; op = op->next)
+	{
+		op->ec = std::make_error_code(std::errc::operation_canceled);
+		++count;
+	}
+
+	post_completed_ops(ops);
+	return count;
+}
+
+bool io_context::timers_due() const
+{
+	const std::chrono::steady_clock::rep next_timer_event = next_timer_event_.load(std::memory_order_relaxed);
+	return next_timer_event != no_timer_event
+		&& std::chrono::steady_clock::now().time_since_epoch().count() >= next_timer_event;
+}
+
+void io_context::run_expired_timers()
+{
+	detail::async_op* first = nullptr;
+	detail::async_op* last = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(timers_guard_);
+		timers_.advance(std::chrono::steady_clock::now(), [&first, &last](detail::timer_wheel::entry& e) {
+			detail::timer_data& timer = static_cast<detail::timer_data&>(e);
+			if (last)
+				last->next = timer.first_waiter;
+			else
+				first = timer.first_waiter;
+			last = timer.last_waiter;
+			timer.first_waiter = timer.last_waiter = nullptr;
+			});
+
+		update_next_timer_event();
+	}
+
+	post_completed_ops(first);
+}
+
+void io_context::post_completed_ops(detail::async_op* ops)
+{
+	if (!ops)
+		return;
+
+	detail::io_context_metrics_state* metrics = metrics_.load(std::memory_order_acquire);
+	if (!ops->next)
+	{
+		if (metrics)
+			metrics->handlers_queued.add(1);
+		any_handler handler{ detail::op_completion(ops) };
+		MY_ASIO_HANDLER_CREATION(handler, nullptr);
+		work_queue_->push(std::move(handler));
+		wake_one_idle_thread();
+		return;
+	}
+
+	detail::handler_vector handlers;
+	while (ops)
+	{
+		detail::async_op* op = ops;
+		ops = op->next;
+		op->next = nullptr;
+		handlers.emplace_back(detail::op_completion(op));
+		MY_ASIO_HANDLER_CREATION(handlers.back(), nullptr);
+	}
+
+	if (metrics)
+		metrics->handlers_queued.add(handlers.size());
+
+	work_queue_->push_all(handlers.data(), handlers.size());
+	wake_idle_threads(handlers.size());
+}
+
+void io_context::update_next_timer_event()
+{
+	const std::chrono::steady_clock::time_point next_event = timers_.next_event();
+	next_timer_event_.store(next_event == std::chrono::steady_clock::time_point::max()
+		? no_timer_event : next_event.time_since_epoch().count());
+}
+
+#if defined(MY_ASIO_HAS_EPOLL)
+detail::io_engine& io_context::reactor()
+{
+	std::call_once(reactor_once_, [this]() {
+#if defined(MY_ASIO_HAS_IO_URING)
+		if (io_backend_ == io_backend::io_uring)
+		{
+			try
+			{
+				reactor_owner_.reset(new detail::io_uring_engine());
+			}
+			catch (const std::system_error&)
+			{
+				// an older kernel, or io_uring disabled by a sandbox
+				io_backend_ = io_backend::epoll;
+			}
+		}
+#endif
+		if (!reactor_owner_)
+			reactor_owner_.reset(new detail::epoll_reactor());
+		reactor_.store(reactor_owner_.get(), std::memory_order_release);
+		});
+
+	return *reactor_owner_;
+}
+
+void io_context::start_reactor_op(detail::io_engine::descriptor_state* state, detail::io_engine::op_type type, detail::reactor_op* op)
+{
+	work_started();
+
+	detail::op_queue completed;
+	if (state)
+	{
+		detail::io_engine& engine = reactor();
+		engine.start_op(type, state, op, completed);
+
+		// submitted when the running handler returns, outside a handler right away
+		if (detail::thread_info* this_thread = detail::call_stack<io_context, detail::thread_info>::contains(this))
+			this_thread->io_submit_pending = true;
+		else
+			engine.submit();
+	}
+	else
+	{
+		op->ec = std::make_error_code(std::errc::bad_file_descriptor);
+		completed.push(op);
+	}
+
+	post_completed_ops(completed.release());
+}
+
+bool io_context::poll_reactor()
+{
+	detail::io_engine* reactor = reactor_.load(std::memory_order_acquire);
+	if (!reactor)
+		return false;
+
+	detail::op_queue completed;
+	reactor->run(false, std::chrono::steady_clock::time_point::max(), completed);
+	if (completed.empty())
+		return false;
+
+	post_completed_ops(completed.release());
+	return true;
+}
+#endif
+
+bool io_context::try_pop_handler(detail::thread_info& this_thread, any_handler& handler)
+{
+	// the next handler slot is a normal handler, it does not run ahead of the weighted round
+	if (prioritized_handlers_.load(std::memory_order_relaxed))
+		return try_pop_prioritized_handler(this_thread, handler);
+
+	return try_pop_normal_handler(this_thread, handler);
+}
+
+bool io_context::try_pop_prioritized_handler(detail::thread_info& this_thread, any_handler& handler)
+{
+	// a round hands out each priority's weight in credits, a priority with nothing queued
+	// does not use them up, so the round starts over once every waiting priority is out of credits
+	size_t picked = priority_levels;
+	{
+		std::lock_guard<std::mutex> lock(priority_guard_);
+		for (int round = 0; round != 2 && picked == priority_levels; ++round)
+		{
+			for (size_t i = 0; i != priority_levels; ++i)
+			{
+				const bool queued = i == priority_index(handler_priority::normal)
+					? normal_handlers_queued(this_thread)
+					: !priority_queues_[i]->empty();
+				if (queued && priority_credits_[i])
+				{
+					picked = i;
+					--priority_credits_[i];
+					break;
+				}
+			}
+
+			if (picked == priority_levels)
+				for (size_t i = 0; i != priority_levels; ++i)
+					priority_credits_[i] = priority_weights_[i];
+		}
+	}
+
+	// the picked priority first, then the others from high to low
+	for (size_t n = 0; n != priority_levels + 1; ++n)
+	{
+		const size_t i = n == 0 ? picked : n - 1;
+		if (i == priority_levels || (n != 0 && i == picked))
+			continue;
+
+		if (i == priority_index(handler_priority::normal))
+		{
+			if (try_pop_normal_handler(this_thread, handler))
+				return true;
+		}
+		else if (priority_queues_[i]->try_pop(handler))
+		{
+			prioritized_handlers_.fetch_sub(1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool io_context::normal_handlers_queued(detail::thread_info& this_thread)
+{
+	return this_thread.next_handler
+		|| this_thread.batch_pos != this_thread.batch.size()
+		|| !work_queue_->empty()
+		|| (this_thread.local_queue && !this_thread.local_queue->empty());
+}
+
+bool io_context::try_pop_normal_handler(detail::thread_info& this_thread, any_handler& handler)
+{
+	if (this_thread.next_handler)
+	{
+		handler = std::move(this_thread.next_handler);
+		++this_thread.next_handler_streak;
+		if (detail::io_context_metrics_state* metrics = metrics_.load(std::memory_order_acquire))
+			metrics->next_handler_hits.add(1);
+		return true;
+	}
+
+	this_thread.next_handler_streak = 0;
+	if (this_thread.batch_pos != this_thread.batch.size())
+	{
+		handler = std::move(this_thread.batch[this_thread.batch_pos]);
+		if (++this_thread.batch_pos == this_thread.batch.size())
+		{
+			this_thread.batch.clear();
+			this_thread.batch_pos = 0;
+		}
+		return true;
+	}
+
+	if (!this_thread.local_queue)
+		return try_pop_shared_handler(this_thread, handler);
+
+	// the shared queue is checked first every now and then, so a busy worker can not starve it
+	if (++this_thread.local_ticks == shared_queue_check_interval)
+	{
+		this_thread.local_ticks = 0;
+		if (try_pop_shared_handler(this_thread, handler))
+			return true;
+	}
+
+	return this_thread.local_queue->try_pop(handler)
+		|| try_pop_shared_handler(this_thread, handler)
+		|| try_steal_handler(this_thread, handler);
+}
+
+bool io_context::try_pop_shared_handler(detail::thread_info& this_thread, any_handler& handler)
+{
+	if (this_thread.batch_limit <= 1)
+		return work_queue_->try_pop(handler);
+
+	if (!work_queue_->try_pop_batch(this_thread.batch, this_thread.batch_limit))
+		return false;
+
+	handler = std::move(this_thread.batch.front());
+	this_thread.batch_pos = 1;
+	if (this_thread.batch.size() == 1)
+	{
+		this_thread.batch.clear();
+		this_thread.batch_pos = 0;
+	}
+	return true;
+}
+
+bool io_context::try_steal_handler(detail::thread_info& this_thread, any_handler& handler)
+{
+	std::lock_guard<std::mutex> lock(workers_guard_);
+
+	const size_t count = workers_.size();
+	for (size_t i = 0; i != count; ++i)
+	{
+		detail::work_stealing_queue* victim = workers_[(this_thread.next_victim + i) % count];
+		if (victim != this_thread.local_queue.get() && this_thread.local_queue->steal_from(*victim, handler))
+		{
+			this_thread.next_victim = (this_thread.next_victim + i) % count;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool io_context::all_queues_empty()
+{
+	if (!work_queue_->empty() || prioritized_handlers_.load())
+		return false;
+
+	if (mode_ == scheduler_mode::work_stealing)
+	{
+		std::lock_guard<std::mutex> lock(workers_guard_);
+		for (const detail::work_stealing_queue* worker : workers_)
+			if (!worker->empty())
+				return false;
+	}
+
+	return true;
+}
+
+void io_context::register_worker(detail::thread_info& this_thread)
+{
+	if (mode_ != scheduler_mode::work_stealing)
+		return;
+
+	this_thread.local_queue.reset(new detail::work_stealing_queue());
+
+	std::lock_guard<std::mutex> lock(workers_guard_);
+	workers_.push_back(this_thread.local_queue.get());
+}
+
+void io_context::unregister_worker(detail::thread_info& this_thread)
+{
+	if (!this_thread.local_queue)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(workers_guard_);
+		for (size_t i = 0; i != workers_.size(); ++i)
+		{
+			if (workers_[i] == this_thread.local_queue.get())
+			{
+				workers_[i] = workers_.back();
+				workers_.pop_back();
+				break;
+			}
+		}
+	}
+
+	// handlers left behind (after stop() or run_one()) go back to the shared queue
+	any_handler handler;
+	while (this_thread.local_queue->try_pop(handler))
+	{
+		work_queue_->push(std::move(handler));
+		wake_one_idle_thread();
+	}
+}
+
+size_t io_context::run()
+{
+	return run_handlers(true, std::numeric_limits<size_t>::max());
+}
+
+size_t io_context::run_one()
+{
+	return run_handlers(true, 1);
+}
+
+size_t io_context::poll()
+{
+	return run_handlers(false, std::numeric_limits<size_t>::max());
 }
 
 size_t io_context::poll_one()
 {
-	detail::call_stack<io_context>::context ctx(this);
+	return run_handlers(false, 1);
+}
+
+size_t io_context::run_handlers(bool blocking, size_t max_handlers)
+{
+	thread_context ctx(*this);
+	if (max_handlers != 1)
+		ctx.enable_batching();
 
-	return do_one(0);
+	size_t cnt = 0;
+	try
+	{
+		while (cnt != max_handlers && do_one(ctx.info(), blocking))
+			++cnt;
+	}
+	catch (...)
+	{
+		ctx.leave();
+		throw;
+	}
+
+	ctx.leave();
+	return cnt;
 }
 
 void io_context::stop()
 {
 	stopped_ = true;
+
+	notify_all_idle_threads();
 }
 
 bool io_context::stopped() const
@@ -94,25 +1096,124 @@ void io_context::restart()
 	stopped_ = false;
 }
 
+void io_context::set_batch_size(size_t batch_size)
+{
+	batch_size_.store(batch_size ? batch_size : 1, std::memory_order_relaxed);
+}
+
+size_t io_context::batch_size() const
+{
+	return batch_size_.load(std::memory_order_relaxed);
+}
+
+void io_context::set_next_handler_limit(unsigned limit)
+{
+	next_handler_limit_.store(limit, std::memory_order_relaxed);
+}
+
+void io_context::set_priority_weights(unsigned high, unsigned normal, unsigned low)
+{
+	std::lock_guard<std::mutex> lock(priority_guard_);
+	const unsigned weights[] = { high, normal, low };
+	for (size_t i = 0; i != priority_levels; ++i)
+		priority_credits_[i] = priority_weights_[i] = weights[i] ? weights[i] : 1;
+}
+
+void io_context::set_queue_limits(const queue_limits& limits)
+{
+	std::call_once(admission_once_, [this, &limits]() {
+		admission_owner_.reset(new detail::admission_control(limits));
+		admission_.store(admission_owner_.get(), std::memory_order_release);
+		});
+
+	// a raised capacity makes room for the producers waiting
+	admission_owner_->set_limits(limits);
+	admission_owner_->drain([this](std::unique_ptr<detail::admission_waiter> w) {
+		admit_waiter(std::move(w));
+		});
+}
+
+size_t io_context::queued_handlers() const
+{
+	const detail::admission_control* admission = admission_.load(std::memory_order_acquire);
+	return admission ? admission->queued() : 0;
+}
+
+io_backend io_context::io_backend_in_use() const
+{
+	return io_backend_;
+}
+
+void io_context::enable_metrics(unsigned sample_interval)
+{
+	std::call_once(metrics_once_, [this, sample_interval]() {
+		metrics_owner_.reset(new detail::io_context_metrics_state(sample_interval ? sample_interval : 1));
+		metrics_.store(metrics_owner_.get(), std::memory_order_release);
+		});
+}
+
+io_context_metrics io_context::metrics() const
+{
+	io_context_metrics result;
+	result.outstanding_work = outstanding_work_.load(std::memory_order_relaxed);
+
+	const detail::io_context_metrics_state* metrics = metrics_.load(std::memory_order_acquire);
+	if (!metrics)
+		return result;
+
+	result.enabled = true;
+	// read before handlers_queued, so a handler queued and run in between is not counted as run only
+	result.handlers_run = metrics->handlers_run.load();
+	result.handlers_queued = metrics->handlers_queued.load();
+	// handlers queued before metrics were enabled are run without having been counted
+	result.ready_handlers = result.handlers_queued > result.handlers_run ? result.handlers_queued - result.handlers_run : 0;
+	result.next_handler_hits = metrics->next_handler_hits.load();
+	result.next_handler_spills = metrics->next_handler_spills.load();
+	result.queue_wait = metrics->queue_wait.snapshot();
+	result.run_time = metrics->run_time.snapshot();
+	return result;
+}
+
 void io_context::work_started()
 {
-	outstanding_work_++;
+	if (detail::thread_info* this_thread = detail::call_stack<io_context, detail::thread_info>::contains(this))
+		work_started(*this_thread, 1);
+	else
+		outstanding_work_++;
 }
 
 void io_context::work_finished()
 {
-	if (--outstanding_work_ == 0)
+	if (detail::thread_info* this_thread = detail::call_stack<io_context, detail::thread_info>::contains(this))
+		work_finished(*this_thread, 1);
+	else if (--outstanding_work_ == 0)
 		stop();
 }
 
-void post(io_context& io, std::function<void()> f)
+void io_context::work_started(detail::thread_info& this_thread, size_t count)
+{
+	const size_t used = std::min(count, this_thread.work_credits);
+	this_thread.work_credits -= used;
+	if (count != used)
+		outstanding_work_.fetch_add(count - used);
+}
+
+void io_context::work_finished(detail::thread_info& this_thread, size_t count)
 {
-	io.get_executor().post(f);
+	this_thread.work_credits += count;
+	if (this_thread.work_credits >= max_work_credits)
+		retire_work_credits(this_thread);
 }
 
-void dispatch(io_context& io, std::function<void()> f)
+void io_context::retire_work_credits(detail::thread_info& this_thread)
 {
-	io.get_executor().dispatch(f);
+	const size_t count = this_thread.work_credits;
+	if (count == 0)
+		return;
+
+	this_thread.work_credits = 0;
+	if (outstanding_work_.fetch_sub(count) == count)
+		stop();
 }
 
 io_context::executor_type io_context::get_executor()
@@ -135,12 +1236,7 @@ io_context::executor_type& io_context::executor_type::operator=(io_context::exec
 
 bool io_context::executor_type::running_in_this_thread() const
 {
-	return detail::call_stack<io_context>::contains(io_ptr) != nullptr;
-}
-
-void io_context::executor_type::execute(std::function<void()> f) const
-{
-	f();
+	return detail::call_stack<io_context, detail::thread_info>::contains(io_ptr) != nullptr;
 }
 
 io_context& io_context::executor_type::context() const
@@ -166,19 +1262,4 @@ bool io_context::executor_type::can_dispatch() const
 	return false;
 }
 
-void io_context::executor_type::dispatch(std::function<void()> f) const
-{
-	if (can_dispatch())
-		execute(f);
-	else
-		post(f);
-}
-
-void io_context::executor_type::post(std::function<void()> f) const
-{
-	on_work_started();
-	std::lock_guard<std::mutex> lock(io_ptr->queue_guard_);
-	io_ptr->work_queue_.push(f);
-}
-
 } // namespace my_asio
\ No newline at end of file
@@ -0,0 +1,473 @@
+#include "io_uring_engine.hpp"
+
+#if defined(MY_ASIO_HAS_IO_URING)
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace my_asio
+{
+namespace detail
+{
+
+namespace
+{
+
+// features the engine relies on, all of them are there since Linux 5.11
+constexpr unsigned required_features = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+
+// user_data of the completions of polls re-arming an operation, operations are at least 8-byte aligned
+constexpr uintptr_t poll_tag = 1;
+
+std::system_error last_error(const char* what)
+{
+	return std::system_error(errno, std::system_category(), what);
+}
+
+int io_uring_setup(unsigned entries, io_uring_params& params)
+{
+	return int(::syscall(__NR_io_uring_setup, entries, &params));
+}
+
+int io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags, void* arg = nullptr, size_t arg_size = 0)
+{
+	return int(::syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg, arg_size));
+}
+
+template<typename T>
+T* ring_field(void* ring, unsigned offset)
+{
+	return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+}
+
+io_uring_sqe make_sqe(unsigned char opcode, int descriptor, uint64_t user_data)
+{
+	io_uring_sqe sqe;
+	std::memset(&sqe, 0, sizeof(sqe));
+	sqe.opcode = opcode;
+	sqe.fd = descriptor;
+	sqe.user_data = user_data;
+	return sqe;
+}
+
+} // namespace
+
+io_uring_engine::io_uring_engine(unsigned entries)
+	: ring_fd_(-1)
+	, ring_(MAP_FAILED)
+	, ring_size_(0)
+	, sqes_(nullptr)
+	, sqes_size_(0)
+	, interrupted_(false)
+{
+	io_uring_params params;
+	std::memset(&params, 0, sizeof(params));
+
+	ring_fd_ = io_uring_setup(entries, params);
+	if (ring_fd_ == -1)
+		throw last_error("io_uring_setup");
+
+	if ((params.features & required_features) != required_features)
+	{
+		::close(ring_fd_);
+		throw std::system_error(std::make_error_code(std::errc::function_not_supported), "io_uring features");
+	}
+
+	// with IORING_FEAT_SINGLE_MMAP both rings share one mapping
+	const size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	const size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	ring_size_ = sq_size > cq_size ? sq_size : cq_size;
+	sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+
+	ring_ = ::mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+	void* sqes = ring_ == MAP_FAILED ? MAP_FAILED
+		: ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+	if (sqes == MAP_FAILED)
+	{
+		const std::system_error error = last_error("mmap");
+		if (ring_ != MAP_FAILED)
+			::munmap(ring_, ring_size_);
+		::close(ring_fd_);
+		throw error;
+	}
+	sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+	sq_head_ = ring_field<unsigned>(ring_, params.sq_off.head);
+	sq_tail_ = ring_field<unsigned>(ring_, params.sq_off.tail);
+	sq_array_ = ring_field<unsigned>(ring_, params.sq_off.array);
+	sq_mask_ = *ring_field<unsigned>(ring_, params.sq_off.ring_mask);
+	sq_entries_ = *ring_field<unsigned>(ring_, params.sq_off.ring_entries);
+
+	cq_head_ = ring_field<unsigned>(ring_, params.cq_off.head);
+	cq_tail_ = ring_field<unsigned>(ring_, params.cq_off.tail);
+	cqes_ = ring_field<io_uring_cqe>(ring_, params.cq_off.cqes);
+	cq_mask_ = *ring_field<unsigned>(ring_, params.cq_off.ring_mask);
+}
+
+io_uring_engine::~io_uring_engine()
+{
+	::munmap(sqes_, sqes_size_);
+	::munmap(ring_, ring_size_);
+	::close(ring_fd_);
+}
+
+io_engine::descriptor_state* io_uring_engine::register_descriptor(int)
+{
+	descriptor_state* state;
+	{
+		std::lock_guard<std::mutex> lock(registry_guard_);
+		if (free_states_.empty())
+		{
+			states_.emplace_back(new descriptor_state());
+			state = states_.back().get();
+		}
+		else
+		{
+			state = free_states_.back();
+			free_states_.pop_back();
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(state->guard_);
+	state->registered_ = true;
+	return state;
+}
+
+void io_uring_engine::deregister_descriptor(io_engine::descriptor_state* base, op_queue& completed)
+{
+	descriptor_state* state = static_cast<descriptor_state*>(base);
+	bool idle;
+	{
+		std::lock_guard<std::mutex> lock(state->guard_);
+		state->registered_ = false;
+
+		for (int type = 0; type != max_ops; ++type)
+		{
+			while (!state->ops_[type].empty())
+			{
+				async_op* op = state->ops_[type].pop();
+				op->ec = std::make_error_code(std::errc::operation_canceled);
+				completed.push(op);
+			}
+			cancel_request(state, op_type(type));
+		}
+
+		idle = !state->in_flight_[read_op] && !state->in_flight_[write_op];
+	}
+
+	// the kernel must have taken its reference to the file before the descriptor is closed
+	submit();
+
+	if (idle)
+		release_state(state);
+}
+
+size_t io_uring_engine::cancel_ops(io_engine::descriptor_state* base, op_queue& completed)
+{
+	descriptor_state* state = static_cast<descriptor_state*>(base);
+	size_t count = 0;
+	{
+		std::lock_guard<std::mutex> lock(state->guard_);
+		for (int type = 0; type != max_ops; ++type)
+		{
+			while (!state->ops_[type].empty())
+			{
+				async_op* op = state->ops_[type].pop();
+				op->ec = std::make_error_code(std::errc::operation_canceled);
+				completed.push(op);
+				++count;
+			}
+
+			// the operation in the kernel completes with operation_canceled once the kernel has let go of it
+			if (state->in_flight_[type] && !state->canceled_[type])
+			{
+				cancel_request(state, op_type(type));
+				++count;
+			}
+		}
+	}
+
+	submit();
+	return count;
+}
+
+void io_uring_engine::start_op(op_type type, io_engine::descriptor_state* base, reactor_op* op, op_queue& completed)
+{
+	descriptor_state* state = static_cast<descriptor_state*>(base);
+	std::lock_guard<std::mutex> lock(state->guard_);
+
+	if (!state->registered_)
+	{
+		op->ec = std::make_error_code(std::errc::bad_file_descriptor);
+		completed.push(op);
+		return;
+	}
+
+	// the kernel orders this store with the load in complete(), the atomics keep ThreadSanitizer informed
+	__atomic_store_n(&op->engine_state, static_cast<void*>(state), __ATOMIC_RELEASE);
+	if (state->in_flight_[type])
+	{
+		state->ops_[type].push(op);
+		return;
+	}
+
+	state->in_flight_[type] = op;
+	state->canceled_[type] = false;
+	start_request(state, type, op);
+}
+
+void io_uring_engine::submit()
+{
+	unsigned pending;
+	{
+		std::lock_guard<std::mutex> lock(sq_guard_);
+		flush_backlog();
+		pending = *sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+	}
+
+	// a submission the kernel refuses for now is retried by the next submit or run
+	if (pending)
+		io_uring_enter(ring_fd_, pending, 0, 0);
+}
+
+void io_uring_engine::run(bool block, std::chrono::steady_clock::time_point deadline, op_queue& completed)
+{
+	submit();
+
+	if (!block)
+	{
+		// a thread blocked in run() reaps everything, polling would only contend with it
+		std::unique_lock<std::mutex> lock(cq_guard_, std::try_to_lock);
+		if (lock.owns_lock())
+			reap(completed);
+	}
+	else
+	{
+		wait(deadline, completed);
+	}
+
+	// operations re-armed or started behind the finished ones
+	submit();
+}
+
+void io_uring_engine::wait(std::chrono::steady_clock::time_point deadline, op_queue& completed)
+{
+	std::lock_guard<std::mutex> lock(cq_guard_);
+	reap(completed);
+
+	if (completed.empty() && !interrupted_.exchange(false))
+	{
+		io_uring_getevents_arg arg;
+		std::memset(&arg, 0, sizeof(arg));
+		__kernel_timespec timeout = {};
+
+		bool block = true;
+		if (deadline != std::chrono::steady_clock::time_point::max())
+		{
+			const std::chrono::nanoseconds ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now());
+			block = ns.count() > 0;
+			timeout.tv_sec = ns.count() / 1'000'000'000;
+			timeout.tv_nsec = ns.count() % 1'000'000'000;
+			arg.ts = reinterpret_cast<uintptr_t>(&timeout);
+		}
+
+		// fails with ETIME once the deadline has passed, or EINTR
+		if (block)
+			io_uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+
+		reap(completed);
+	}
+
+	interrupted_.store(false);
+}
+
+void io_uring_engine::interrupt()
+{
+	// the flag covers a blocking run that has not reached the kernel yet, the NOP one that is waiting there
+	interrupted_.store(true);
+	push_sqe(make_sqe(IORING_OP_NOP, -1, 0));
+	submit();
+}
+
+void io_uring_engine::start_request(descriptor_state* state, op_type type, reactor_op* op)
+{
+	const io_request request = op->request();
+	io_uring_sqe sqe = make_sqe(IORING_OP_NOP, request.descriptor, reinterpret_cast<uintptr_t>(op));
+
+	switch (request.kind)
+	{
+	case io_request::receive:
+		sqe.opcode = IORING_OP_RECV;
+		sqe.addr = reinterpret_cast<uintptr_t>(request.data);
+		sqe.len = unsigned(request.size);
+		break;
+	case io_request::send:
+		sqe.opcode = IORING_OP_SEND;
+		sqe.addr = reinterpret_cast<uintptr_t>(request.data);
+		sqe.len = unsigned(request.size);
+		sqe.msg_flags = MSG_NOSIGNAL;
+		break;
+	case io_request::accept:
+		sqe.opcode = IORING_OP_ACCEPT;
+		sqe.accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+		break;
+	}
+
+	state->polling_[type] = false;
+	push_sqe(sqe);
+}
+
+void io_uring_engine::cancel_request(descriptor_state* state, op_type type)
+{
+	reactor_op* op = state->in_flight_[type];
+	if (!op || state->canceled_[type])
+		return;
+
+	state->canceled_[type] = true;
+
+	io_uring_sqe sqe = make_sqe(IORING_OP_ASYNC_CANCEL, -1, 0);
+	sqe.addr = reinterpret_cast<uintptr_t>(op) | (state->polling_[type] ? poll_tag : 0);
+	push_sqe(sqe);
+}
+
+void io_uring_engine::push_sqe(const io_uring_sqe& sqe)
+{
+	std::lock_guard<std::mutex> lock(sq_guard_);
+	backlog_.push_back(sqe);
+	flush_backlog();
+}
+
+void io_uring_engine::flush_backlog()
+{
+	size_t flushed = 0;
+	while (flushed != backlog_.size())
+	{
+		const unsigned tail = *sq_tail_;
+		if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) == sq_entries_)
+		{
+			// the ring is full, the kernel takes what is queued and makes room
+			if (io_uring_enter(ring_fd_, sq_entries_, 0, 0) <= 0)
+				break;
+			continue;
+		}
+
+		const unsigned index = tail & sq_mask_;
+		sqes_[index] = backlog_[flushed++];
+		sq_array_[index] = index;
+		__atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+	}
+
+	backlog_.erase(backlog_.begin(), backlog_.begin() + flushed);
+}
+
+void io_uring_engine::reap(op_queue& completed)
+{
+	unsigned head = *cq_head_;
+	for (;;)
+	{
+		const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+		if (head == tail)
+			return;
+
+		for (; head != tail; ++head)
+		{
+			const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+			const uint64_t user_data = cqe.user_data;
+			const int result = cqe.res;
+
+			// the slot is handed back before the operation is looked at, completing it may queue new SQEs
+			__atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+
+			// interrupts and cancel requests
+			if (user_data == 0)
+				continue;
+
+			reactor_op* op = reinterpret_cast<reactor_op*>(uintptr_t(user_data) & ~poll_tag);
+			complete(op, (user_data & poll_tag) != 0, result, completed);
+		}
+	}
+}
+
+void io_uring_engine::complete(reactor_op* op, bool poll, int result, op_queue& completed)
+{
+	descriptor_state* state = static_cast<descriptor_state*>(__atomic_load_n(&op->engine_state, __ATOMIC_ACQUIRE));
+	bool idle;
+	{
+		std::lock_guard<std::mutex> lock(state->guard_);
+		const op_type type = state->in_flight_[read_op] == op ? read_op : write_op;
+		const bool canceled = state->canceled_[type];
+
+		if (!canceled)
+		{
+			// a ready descriptor, or a poll error the operation will report itself
+			if (poll)
+			{
+				start_request(state, type, op);
+				return;
+			}
+
+			// older kernels fail a non-blocking socket instead of waiting, the operation waits for readiness
+			if (result == -EAGAIN)
+			{
+				const io_request request = op->request();
+				io_uring_sqe sqe = make_sqe(IORING_OP_POLL_ADD, request.descriptor, reinterpret_cast<uintptr_t>(op) | poll_tag);
+				uint32_t events = type == read_op ? POLLIN | POLLPRI | POLLRDHUP : POLLOUT;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+				events = (events << 16) | (events >> 16);
+#endif
+				sqe.poll32_events = events;
+				state->polling_[type] = true;
+				push_sqe(sqe);
+				return;
+			}
+
+			// a connection reset while queued is skipped, like the epoll_reactor does
+			if (result == -EINTR || (result == -ECONNABORTED && op->request().kind == io_request::accept))
+			{
+				start_request(state, type, op);
+				return;
+			}
+		}
+
+		if (poll || result == -ECANCELED || (canceled && (result == -EAGAIN || result == -EINTR)))
+			op->ec = std::make_error_code(std::errc::operation_canceled);
+		else
+			op->set_result(result);
+
+		op->engine_state = nullptr;
+		completed.push(op);
+
+		state->in_flight_[type] = nullptr;
+		state->polling_[type] = false;
+		if (!state->ops_[type].empty())
+		{
+			reactor_op* next = static_cast<reactor_op*>(state->ops_[type].pop());
+			state->in_flight_[type] = next;
+			state->canceled_[type] = false;
+			start_request(state, type, next);
+		}
+
+		idle = !state->registered_ && !state->in_flight_[read_op] && !state->in_flight_[write_op];
+	}
+
+	if (idle)
+		release_state(state);
+}
+
+void io_uring_engine::release_state(descriptor_state* state)
+{
+	std::lock_guard<std::mutex> lock(registry_guard_);
+	free_states_.push_back(state);
+}
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // defined(MY_ASIO_HAS_IO_URING)
\ No newline at end of file
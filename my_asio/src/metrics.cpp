@@ -0,0 +1,162 @@
+#include "metrics.hpp"
+
+#include <cinttypes>
+#include <cmath>
+
+#include "append_printf.hpp"
+#include "sharded_metrics.hpp"
+
+namespace my_asio
+{
+
+namespace
+{
+
+// the exported buckets end at 2^max_exported_exponent ns, about 69 seconds
+constexpr unsigned max_exported_exponent = 36;
+
+void append_counter(std::string& out, const std::string& prefix, const char* name, const char* help, uint64_t value)
+{
+	detail::append_printf(out, "# HELP %s_%s %s\n# TYPE %s_%s counter\n%s_%s %" PRIu64 "\n",
+		prefix.c_str(), name, help, prefix.c_str(), name, prefix.c_str(), name, value);
+}
+
+void append_gauge(std::string& out, const std::string& prefix, const char* name, const char* help, uint64_t value)
+{
+	detail::append_printf(out, "# HELP %s_%s %s\n# TYPE %s_%s gauge\n%s_%s %" PRIu64 "\n",
+		prefix.c_str(), name, help, prefix.c_str(), name, prefix.c_str(), name, value);
+}
+
+// a bucket le="2^k ns" counts the values up to 2^k ns, the log-linear buckets split exactly there
+// and 2^k is the first value of its bucket
+void append_histogram(std::string& out, const std::string& prefix, const char* name, const char* help, const histogram_snapshot& h)
+{
+	detail::append_printf(out, "# HELP %s_%s %s\n# TYPE %s_%s histogram\n", prefix.c_str(), name, help, prefix.c_str(), name);
+
+	uint64_t cumulative = 0;
+	size_t index = 0;
+	for (unsigned exponent = 0; exponent <= max_exported_exponent; ++exponent)
+	{
+		const size_t end = histogram_snapshot::bucket_index(uint64_t(1) << exponent) + 1;
+		for (; index < end; ++index)
+			cumulative += h.buckets()[index];
+		detail::append_printf(out, "%s_%s_bucket{le=\"%.9g\"} %" PRIu64 "\n", prefix.c_str(), name, std::ldexp(1e-9, int(exponent)), cumulative);
+	}
+
+	detail::append_printf(out, "%s_%s_bucket{le=\"+Inf\"} %" PRIu64 "\n", prefix.c_str(), name, h.count());
+	detail::append_printf(out, "%s_%s_sum %.9g\n", prefix.c_str(), name, h.sum() * 1e-9);
+	detail::append_printf(out, "%s_%s_count %" PRIu64 "\n", prefix.c_str(), name, h.count());
+}
+
+void append_json_histogram(std::string& out, const char* name, const histogram_snapshot& h)
+{
+	detail::append_printf(out, "\"%s\": {\"count\": %" PRIu64 ", \"sum_ns\": %" PRIu64 ", \"mean_ns\": %.3f, \"p50_ns\": %" PRIu64
+		", \"p90_ns\": %" PRIu64 ", \"p99_ns\": %" PRIu64 ", \"max_ns\": %" PRIu64 "}",
+		name, h.count(), h.sum(), h.mean(), h.percentile(0.5), h.percentile(0.9), h.percentile(0.99), h.max());
+}
+
+} // namespace
+
+uint64_t histogram_snapshot::bucket_upper_bound(size_t index)
+{
+	if (index < sub_buckets)
+		return index;
+
+	const unsigned exponent = unsigned(index / sub_buckets) + 1;
+	const uint64_t step = uint64_t(1) << (exponent - 2);
+	return (sub_buckets + index % sub_buckets) * step + (step - 1);
+}
+
+uint64_t histogram_snapshot::percentile(double q) const
+{
+	if (count_ == 0)
+		return 0;
+
+	const double clamped = q < 0.0 ? 0.0 : (q > 1.0 ? 1.0 : q);
+	const uint64_t rank = std::max<uint64_t>(1, uint64_t(std::ceil(clamped * count_)));
+
+	uint64_t cumulative = 0;
+	for (size_t i = 0; i != buckets_.size(); ++i)
+	{
+		cumulative += buckets_[i];
+		if (cumulative >= rank)
+			return bucket_upper_bound(i);
+	}
+
+	// concurrent recording can leave the total count ahead of the buckets
+	for (size_t i = buckets_.size(); i != 0; --i)
+		if (buckets_[i - 1])
+			return bucket_upper_bound(i - 1);
+	return 0;
+}
+
+histogram_snapshot detail::latency_histogram::snapshot() const
+{
+	histogram_snapshot result;
+	for (const shard& s : shards_)
+	{
+		result.count_ += s.count.load(std::memory_order_relaxed);
+		result.sum_ += s.sum.load(std::memory_order_relaxed);
+		for (size_t i = 0; i != histogram_snapshot::bucket_count; ++i)
+			result.buckets_[i] += s.buckets[i].load(std::memory_order_relaxed);
+	}
+	return result;
+}
+
+std::string to_prometheus(const io_context_metrics& metrics, const std::string& prefix)
+{
+	std::string out;
+	append_counter(out, prefix, "handlers_queued_total", "Handlers handed to the io_context.", metrics.handlers_queued);
+	append_counter(out, prefix, "handlers_run_total", "Handlers run by the io_context.", metrics.handlers_run);
+	append_gauge(out, prefix, "ready_handlers", "Handlers queued but not run yet.", metrics.ready_handlers);
+	append_gauge(out, prefix, "outstanding_work", "Outstanding work count.", metrics.outstanding_work);
+	append_counter(out, prefix, "next_handler_hits_total", "Continuations run right after the handler that posted them.", metrics.next_handler_hits);
+	append_counter(out, prefix, "next_handler_spills_total", "Continuations queued because of the limit on a row of them.", metrics.next_handler_spills);
+	append_histogram(out, prefix, "queue_wait_seconds", "Sampled time handlers wait in the queue.", metrics.queue_wait);
+	append_histogram(out, prefix, "run_time_seconds", "Sampled handler run time.", metrics.run_time);
+	return out;
+}
+
+std::string to_prometheus(const strand_metrics& metrics, const std::string& prefix)
+{
+	std::string out;
+	append_counter(out, prefix, "handlers_posted_total", "Handlers posted to the strand.", metrics.handlers_posted);
+	append_counter(out, prefix, "handlers_run_total", "Handlers run by the strand.", metrics.handlers_run);
+	append_counter(out, prefix, "turns_total", "Times the strand was scheduled.", metrics.turns);
+	append_gauge(out, prefix, "backlog", "Handlers queued or running on the strand.", metrics.backlog);
+	append_gauge(out, prefix, "max_handlers_per_turn", "Most handlers run in one turn.", metrics.max_handlers_per_turn);
+	append_histogram(out, prefix, "queue_wait_seconds", "Sampled time handlers wait in the strand.", metrics.queue_wait);
+	append_histogram(out, prefix, "run_time_seconds", "Sampled handler run time.", metrics.run_time);
+	return out;
+}
+
+std::string to_json(const io_context_metrics& metrics)
+{
+	std::string out;
+	detail::append_printf(out, "{\"enabled\": %s, \"handlers_queued\": %" PRIu64 ", \"handlers_run\": %" PRIu64
+		", \"ready_handlers\": %" PRIu64 ", \"outstanding_work\": %zu"
+		", \"next_handler_hits\": %" PRIu64 ", \"next_handler_spills\": %" PRIu64 ", ",
+		metrics.enabled ? "true" : "false", metrics.handlers_queued, metrics.handlers_run,
+		metrics.ready_handlers, metrics.outstanding_work, metrics.next_handler_hits, metrics.next_handler_spills);
+	append_json_histogram(out, "queue_wait", metrics.queue_wait);
+	out += ", ";
+	append_json_histogram(out, "run_time", metrics.run_time);
+	out += "}";
+	return out;
+}
+
+std::string to_json(const strand_metrics& metrics)
+{
+	std::string out;
+	detail::append_printf(out, "{\"enabled\": %s, \"handlers_posted\": %" PRIu64 ", \"handlers_run\": %" PRIu64
+		", \"backlog\": %zu, \"turns\": %zu, \"max_handlers_per_turn\": %zu, ",
+		metrics.enabled ? "true" : "false", metrics.handlers_posted, metrics.handlers_run,
+		metrics.backlog, metrics.turns, metrics.max_handlers_per_turn);
+	append_json_histogram(out, "queue_wait", metrics.queue_wait);
+	out += ", ";
+	append_json_histogram(out, "run_time", metrics.run_time);
+	out += "}";
+	return out;
+}
+
+} // namespace my_asio
\ No newline at end of file
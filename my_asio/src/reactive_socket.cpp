@@ -0,0 +1,214 @@
+#include "reactive_socket.hpp"
+
+#if defined(MY_ASIO_HAS_EPOLL)
+
+#include <cerrno>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "error.hpp"
+
+namespace my_asio
+{
+namespace detail
+{
+
+namespace
+{
+
+std::error_code last_error()
+{
+	return std::error_code(errno, std::system_category());
+}
+
+bool would_block()
+{
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+} // namespace
+
+reactive_socket::reactive_socket(io_context& io)
+	: io_(io)
+	, descriptor_(-1)
+	, state_(nullptr)
+{	}
+
+reactive_socket::~reactive_socket()
+{
+	close();
+}
+
+io_context& reactive_socket::context() const
+{
+	return io_;
+}
+
+bool reactive_socket::is_open() const
+{
+	return descriptor_ != -1;
+}
+
+int reactive_socket::native_handle() const
+{
+	return descriptor_;
+}
+
+void reactive_socket::open(int family, int type, int protocol)
+{
+	if (is_open())
+		throw std::system_error(std::make_error_code(std::errc::already_connected), "open");
+
+	const int descriptor = ::socket(family, type | SOCK_NONBLOCK | SOCK_CLOEXEC, protocol);
+	if (descriptor == -1)
+		throw std::system_error(last_error(), "socket");
+
+	const std::error_code ec = assign(descriptor);
+	if (ec)
+		throw std::system_error(ec, "assign");
+}
+
+std::error_code reactive_socket::assign(int descriptor)
+{
+	if (is_open())
+	{
+		::close(descriptor);
+		return std::make_error_code(std::errc::already_connected);
+	}
+
+	try
+	{
+		state_ = io_.reactor().register_descriptor(descriptor);
+	}
+	catch (const std::system_error& e)
+	{
+		::close(descriptor);
+		return e.code();
+	}
+
+	descriptor_ = descriptor;
+	return std::error_code();
+}
+
+void reactive_socket::close()
+{
+	if (!is_open())
+		return;
+
+	op_queue completed;
+	io_.reactor().deregister_descriptor(state_, completed);
+	::close(descriptor_);
+
+	descriptor_ = -1;
+	state_ = nullptr;
+
+	io_.post_completed_ops(completed.release());
+}
+
+size_t reactive_socket::cancel()
+{
+	if (!is_open())
+		return 0;
+
+	op_queue completed;
+	const size_t count = io_.reactor().cancel_ops(state_, completed);
+	io_.post_completed_ops(completed.release());
+	return count;
+}
+
+void reactive_socket::start_op(io_engine::op_type type, reactor_op* op)
+{
+	io_.start_reactor_op(state_, type, op);
+}
+
+bool receive_operation::perform(reactor_op& op)
+{
+	for (;;)
+	{
+		const ssize_t bytes = ::recv(descriptor, buffer.data(), buffer.size(), 0);
+		if (bytes == -1 && errno == EINTR)
+			continue;
+		if (bytes == -1 && would_block())
+			return false;
+
+		set_result(op, bytes == -1 ? -errno : long(bytes));
+		return true;
+	}
+}
+
+void receive_operation::set_result(reactor_op& op, long result)
+{
+	if (result < 0)
+		op.ec = std::error_code(int(-result), std::system_category());
+	else if (result == 0 && buffer.size() != 0)
+		op.ec = error::eof;
+	else
+		op.bytes_transferred = size_t(result);
+}
+
+bool send_operation::perform(reactor_op& op)
+{
+	for (;;)
+	{
+		const ssize_t bytes = ::send(descriptor, buffer.data(), buffer.size(), MSG_NOSIGNAL);
+		if (bytes == -1 && errno == EINTR)
+			continue;
+		if (bytes == -1 && would_block())
+			return false;
+
+		set_result(op, bytes == -1 ? -errno : long(bytes));
+		return true;
+	}
+}
+
+void send_operation::set_result(reactor_op& op, long result)
+{
+	if (result < 0)
+		op.ec = std::error_code(int(-result), std::system_category());
+	else
+		op.bytes_transferred = size_t(result);
+}
+
+bool accept_operation::perform(reactor_op& op)
+{
+	for (;;)
+	{
+		const int result = ::accept4(descriptor, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+		// a connection reset while queued is skipped, like asio does
+		if (result == -1 && (errno == EINTR || errno == ECONNABORTED))
+			continue;
+		if (result == -1 && would_block())
+			return false;
+
+		set_result(op, result == -1 ? -errno : long(result));
+		return true;
+	}
+}
+
+void accept_operation::set_result(reactor_op& op, long result)
+{
+	if (result < 0)
+		op.ec = std::error_code(int(-result), std::system_category());
+	else
+		new_descriptor = int(result);
+}
+
+void accept_operation::abandon()
+{
+	if (new_descriptor != -1)
+		::close(new_descriptor);
+}
+
+std::error_code accept_operation::take_new_descriptor()
+{
+	const int descriptor = new_descriptor;
+	new_descriptor = -1;
+	return peer->assign(descriptor);
+}
+
+} // namespace detail
+} // namespace my_asio
+
+#endif // defined(MY_ASIO_HAS_EPOLL)
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "recycling_allocator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+namespace my_asio
+{
+
+namespace
+{
+
+struct cache_config
+{
+	std::vector<size_t> size_classes{ 64, 128, 256, 512, 1024 };
+	size_t blocks_per_class = 16;
+};
+
+std::mutex config_guard;
+cache_config config;
+std::atomic<bool> config_in_use(false);
+
+class thread_cache
+{
+public:
+	struct size_class
+	{
+		size_t size;
+		std::vector<void*> free_blocks;
+	};
+
+	thread_cache()
+	{
+		std::lock_guard<std::mutex> lock(config_guard);
+		config_in_use = true;
+
+		blocks_per_class_ = config.blocks_per_class;
+		for (size_t size : config.size_classes)
+		{
+			size_classes_.push_back({ size, {} });
+			size_classes_.back().free_blocks.reserve(blocks_per_class_);
+		}
+	}
+
+	~thread_cache()
+	{
+		for (auto& c : size_classes_)
+			for (void* p : c.free_blocks)
+				::operator delete(p);
+
+		destroyed = true;
+	}
+
+	// nullptr if size is larger than the largest size class
+	size_class* find(size_t size)
+	{
+		for (auto& c : size_classes_)
+			if (size <= c.size)
+				return &c;
+		return nullptr;
+	}
+
+	size_t blocks_per_class() const { return blocks_per_class_; }
+
+	std::vector<size_t> block_sizes() const
+	{
+		std::vector<size_t> sizes;
+		for (const auto& c : size_classes_)
+			sizes.push_back(c.size);
+		return sizes;
+	}
+
+	recycling_allocator_stats stats;
+
+	// handlers destroyed by other thread_local destructors may outlive the cache
+	static thread_local bool destroyed;
+
+private:
+	std::vector<size_class> size_classes_;
+	size_t blocks_per_class_;
+};
+
+thread_local bool thread_cache::destroyed = false;
+
+// size of the block handed out for size bytes, so a cache can later recycle it
+size_t block_size(size_t size)
+{
+	std::lock_guard<std::mutex> lock(config_guard);
+	for (size_t class_size : config.size_classes)
+		if (size <= class_size)
+			return class_size;
+	return size;
+}
+
+thread_cache* this_thread_cache()
+{
+	if (thread_cache::destroyed)
+		return nullptr;
+
+	thread_local thread_cache cache;
+	return &cache;
+}
+
+} // namespace
+
+namespace detail
+{
+
+void* thread_memory_cache::allocate(size_t size)
+{
+	thread_cache* cache = this_thread_cache();
+	if (!cache)
+		return ::operator new(block_size(size));
+
+	thread_cache::size_class* c = cache->find(size);
+	if (!c)
+	{
+		++cache->stats.oversized;
+		return ::operator new(size);
+	}
+
+	if (c->free_blocks.empty())
+	{
+		++cache->stats.misses;
+		return ::operator new(c->size);
+	}
+
+	++cache->stats.hits;
+	void* p = c->free_blocks.back();
+	c->free_blocks.pop_back();
+	return p;
+}
+
+void thread_memory_cache::deallocate(void* p, size_t size) noexcept
+{
+	thread_cache* cache = this_thread_cache();
+	if (cache)
+	{
+		thread_cache::size_class* c = cache->find(size);
+		if (c && c->free_blocks.size() < cache->blocks_per_class())
+		{
+			++cache->stats.recycled;
+			c->free_blocks.push_back(p);
+			return;
+		}
+
+		++cache->stats.released;
+	}
+
+	::operator delete(p);
+}
+
+void thread_memory_cache::fill()
+{
+	thread_cache* cache = this_thread_cache();
+	if (!cache)
+		return;
+
+	for (size_t size : cache->block_sizes())
+	{
+		thread_cache::size_class* c = cache->find(size);
+		while (c->free_blocks.size() < cache->blocks_per_class())
+		{
+			void* p = ::operator new(c->size);
+			std::memset(p, 0, c->size);
+			c->free_blocks.push_back(p);
+		}
+	}
+}
+
+} // namespace detail
+
+bool configure_recycling_allocator(std::vector<size_t> size_classes, size_t blocks_per_class)
+{
+	std::lock_guard<std::mutex> lock(config_guard);
+	if (config_in_use)
+		return false;
+
+	// every block must stay suitably aligned for any type
+	constexpr size_t alignment = alignof(std::max_align_t);
+	for (size_t& size : size_classes)
+		size = (std::max<size_t>(size, 1) + alignment - 1) / alignment * alignment;
+
+	std::sort(size_classes.begin(), size_classes.end());
+	size_classes.erase(std::unique(size_classes.begin(), size_classes.end()), size_classes.end());
+
+	config.size_classes = std::move(size_classes);
+	config.blocks_per_class = blocks_per_class;
+	return true;
+}
+
+recycling_allocator_stats this_thread_recycling_stats()
+{
+	thread_cache* cache = this_thread_cache();
+	return cache ? cache->stats : recycling_allocator_stats();
+}
+
+} // namespace my_asio
\ No newline at end of file
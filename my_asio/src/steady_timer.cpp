@@ -0,0 +1,53 @@
+#include "steady_timer.hpp"
+
+namespace my_asio
+{
+
+steady_timer::steady_timer(io_context& io)
+	: io_(io)
+	, expiry_()
+{	}
+
+steady_timer::steady_timer(io_context& io, duration expiry_time)
+	: io_(io)
+	, expiry_(clock_type::now() + expiry_time)
+{	}
+
+steady_timer::steady_timer(io_context& io, time_point expiry_time)
+	: io_(io)
+	, expiry_(expiry_time)
+{	}
+
+steady_timer::~steady_timer()
+{
+	cancel();
+}
+
+steady_timer::executor_type steady_timer::get_executor()
+{
+	return io_.get_executor();
+}
+
+steady_timer::time_point steady_timer::expiry() const
+{
+	return expiry_;
+}
+
+size_t steady_timer::expires_at(time_point expiry_time)
+{
+	const size_t cancelled = cancel();
+	expiry_ = expiry_time;
+	return cancelled;
+}
+
+size_t steady_timer::expires_after(duration expiry_time)
+{
+	return expires_at(clock_type::now() + expiry_time);
+}
+
+size_t steady_timer::cancel()
+{
+	return io_.cancel_timer(data_);
+}
+
+} // namespace my_asio
\ No newline at end of file
@@ -0,0 +1,242 @@
+#include "tcp.hpp"
+
+#if defined(MY_ASIO_HAS_EPOLL)
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+
+namespace my_asio
+{
+namespace ip
+{
+
+namespace
+{
+
+std::system_error last_error(const char* what)
+{
+	return std::system_error(errno, std::system_category(), what);
+}
+
+} // namespace
+
+tcp::endpoint::endpoint()
+	: storage_()
+{
+	sockaddr_in* v4 = reinterpret_cast<sockaddr_in*>(&storage_);
+	v4->sin_family = AF_INET;
+}
+
+tcp::endpoint::endpoint(const std::string& address, unsigned short port)
+	: storage_()
+{
+	sockaddr_in* v4 = reinterpret_cast<sockaddr_in*>(&storage_);
+	sockaddr_in6* v6 = reinterpret_cast<sockaddr_in6*>(&storage_);
+
+	if (::inet_pton(AF_INET, address.c_str(), &v4->sin_addr) == 1)
+	{
+		v4->sin_family = AF_INET;
+		v4->sin_port = htons(port);
+	}
+	else if (::inet_pton(AF_INET6, address.c_str(), &v6->sin6_addr) == 1)
+	{
+		v6->sin6_family = AF_INET6;
+		v6->sin6_port = htons(port);
+	}
+	else
+	{
+		throw std::invalid_argument("not a numeric IP address: " + address);
+	}
+}
+
+std::string tcp::endpoint::address() const
+{
+	char text[INET6_ADDRSTRLEN] = {};
+	if (family() == AF_INET6)
+		::inet_ntop(AF_INET6, &reinterpret_cast<const sockaddr_in6*>(&storage_)->sin6_addr, text, sizeof(text));
+	else
+		::inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in*>(&storage_)->sin_addr, text, sizeof(text));
+	return text;
+}
+
+unsigned short tcp::endpoint::port() const
+{
+	if (family() == AF_INET6)
+		return ntohs(reinterpret_cast<const sockaddr_in6*>(&storage_)->sin6_port);
+	return ntohs(reinterpret_cast<const sockaddr_in*>(&storage_)->sin_port);
+}
+
+int tcp::endpoint::family() const
+{
+	return storage_.ss_family;
+}
+
+const sockaddr* tcp::endpoint::data() const
+{
+	return reinterpret_cast<const sockaddr*>(&storage_);
+}
+
+sockaddr* tcp::endpoint::data()
+{
+	return reinterpret_cast<sockaddr*>(&storage_);
+}
+
+socklen_t tcp::endpoint::size() const
+{
+	return family() == AF_INET6 ? sizeof(sockaddr_in6) : sizeof(sockaddr_in);
+}
+
+socklen_t tcp::endpoint::capacity() const
+{
+	return sizeof(storage_);
+}
+
+tcp::socket::socket(io_context& io)
+	: impl_(io)
+{	}
+
+tcp::socket::executor_type tcp::socket::get_executor()
+{
+	return impl_.context().get_executor();
+}
+
+bool tcp::socket::is_open() const
+{
+	return impl_.is_open();
+}
+
+int tcp::socket::native_handle() const
+{
+	return impl_.native_handle();
+}
+
+void tcp::socket::connect(const endpoint& peer)
+{
+	if (!is_open())
+		impl_.open(peer.family(), SOCK_STREAM, IPPROTO_TCP);
+
+	if (::connect(native_handle(), peer.data(), peer.size()) == 0)
+		return;
+	if (errno != EINPROGRESS)
+		throw last_error("connect");
+
+	// the descriptor is non-blocking, wait for the connection to be established
+	pollfd fds = {};
+	fds.fd = native_handle();
+	fds.events = POLLOUT;
+	while (::poll(&fds, 1, -1) == -1)
+		if (errno != EINTR)
+			throw last_error("poll");
+
+	int error = 0;
+	socklen_t length = sizeof(error);
+	if (::getsockopt(native_handle(), SOL_SOCKET, SO_ERROR, &error, &length) == -1)
+		throw last_error("getsockopt");
+	if (error)
+		throw std::system_error(error, std::system_category(), "connect");
+}
+
+void tcp::socket::close()
+{
+	impl_.close();
+}
+
+size_t tcp::socket::cancel()
+{
+	return impl_.cancel();
+}
+
+void tcp::socket::set_no_delay(bool enabled)
+{
+	const int value = enabled ? 1 : 0;
+	if (::setsockopt(native_handle(), IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value)) == -1)
+		throw last_error("setsockopt");
+}
+
+tcp::endpoint tcp::socket::local_endpoint() const
+{
+	endpoint result;
+	socklen_t length = result.capacity();
+	if (::getsockname(native_handle(), result.data(), &length) == -1)
+		throw last_error("getsockname");
+	return result;
+}
+
+tcp::endpoint tcp::socket::remote_endpoint() const
+{
+	endpoint result;
+	socklen_t length = result.capacity();
+	if (::getpeername(native_handle(), result.data(), &length) == -1)
+		throw last_error("getpeername");
+	return result;
+}
+
+tcp::acceptor::acceptor(io_context& io)
+	: impl_(io)
+{	}
+
+tcp::acceptor::acceptor(io_context& io, const endpoint& local_endpoint, bool reuse_address)
+	: impl_(io)
+{
+	listen(local_endpoint, reuse_address);
+}
+
+tcp::acceptor::executor_type tcp::acceptor::get_executor()
+{
+	return impl_.context().get_executor();
+}
+
+void tcp::acceptor::listen(const endpoint& local_endpoint, bool reuse_address, int backlog)
+{
+	impl_.open(local_endpoint.family(), SOCK_STREAM, IPPROTO_TCP);
+
+	const int value = 1;
+	if (reuse_address && ::setsockopt(native_handle(), SOL_SOCKET, SO_REUSEADDR, &value, sizeof(value)) == -1)
+		throw last_error("setsockopt");
+
+	if (::bind(native_handle(), local_endpoint.data(), local_endpoint.size()) == -1)
+		throw last_error("bind");
+
+	if (::listen(native_handle(), backlog) == -1)
+		throw last_error("listen");
+}
+
+bool tcp::acceptor::is_open() const
+{
+	return impl_.is_open();
+}
+
+int tcp::acceptor::native_handle() const
+{
+	return impl_.native_handle();
+}
+
+void tcp::acceptor::close()
+{
+	impl_.close();
+}
+
+size_t tcp::acceptor::cancel()
+{
+	return impl_.cancel();
+}
+
+tcp::endpoint tcp::acceptor::local_endpoint() const
+{
+	endpoint result;
+	socklen_t length = result.capacity();
+	if (::getsockname(native_handle(), result.data(), &length) == -1)
+		throw last_error("getsockname");
+	return result;
+}
+
+} // namespace ip
+} // namespace my_asio
+
+#endif // defined(MY_ASIO_HAS_EPOLL)
\ No newline at end of file
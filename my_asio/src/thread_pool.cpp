@@ -0,0 +1,206 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace my_asio
+{
+
+namespace
+{
+
+#if defined(__linux__)
+// the CPUs the process may run on
+std::vector<int> allowed_cpus()
+{
+	std::vector<int> cpus;
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (sched_getaffinity(0, sizeof(set), &set) == 0)
+		for (int cpu = 0; cpu != CPU_SETSIZE; ++cpu)
+			if (CPU_ISSET(cpu, &set))
+				cpus.push_back(cpu);
+	return cpus;
+}
+
+// parses a sysfs CPU list such as "0-3,8-11"
+std::vector<int> parse_cpu_list(const std::string& list)
+{
+	std::vector<int> cpus;
+	std::stringstream ranges(list);
+	std::string range;
+	while (std::getline(ranges, range, ','))
+	{
+		int first = 0;
+		int last = 0;
+		const size_t dash = range.find('-');
+		try
+		{
+			first = std::stoi(range.substr(0, dash));
+			last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+		}
+		catch (const std::exception&)
+		{
+			continue;
+		}
+
+		for (int cpu = first; cpu <= last; ++cpu)
+			cpus.push_back(cpu);
+	}
+	return cpus;
+}
+
+// the allowed CPUs of each NUMA node that has any, a single node if the topology is unknown
+std::vector<std::vector<int>> numa_nodes()
+{
+	const std::vector<int> allowed = allowed_cpus();
+
+	std::vector<std::vector<int>> nodes;
+	for (int node = 0;; ++node)
+	{
+		std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+		if (!file)
+			break;
+
+		std::string list;
+		std::getline(file, list);
+
+		std::vector<int> cpus;
+		for (int cpu : parse_cpu_list(list))
+			if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end())
+				cpus.push_back(cpu);
+		if (!cpus.empty())
+			nodes.push_back(std::move(cpus));
+	}
+
+	if (nodes.empty() && !allowed.empty())
+		nodes.push_back(allowed);
+	return nodes;
+}
+
+bool pin_this_thread(const std::vector<int>& cpus)
+{
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (int cpu : cpus)
+		CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+#else
+std::vector<std::vector<int>> numa_nodes()
+{
+	return {};
+}
+
+bool pin_this_thread(const std::vector<int>&)
+{
+	return false;
+}
+#endif
+
+// the CPUs of each worker, empty sets where the workers are not pinned
+std::vector<std::vector<int>> place_workers(size_t threads, thread_affinity affinity)
+{
+	std::vector<std::vector<int>> placement(threads);
+	if (affinity == thread_affinity::none)
+		return placement;
+
+	const std::vector<std::vector<int>> nodes = numa_nodes();
+	if (nodes.empty())
+		return placement;
+
+	if (affinity == thread_affinity::numa_node)
+	{
+		for (size_t i = 0; i != threads; ++i)
+			placement[i] = nodes[i % nodes.size()];
+		return placement;
+	}
+
+	// neighbouring workers share a node, which is where they are most likely to share data
+	std::vector<int> cpus;
+	for (const auto& node : nodes)
+		cpus.insert(cpus.end(), node.begin(), node.end());
+	for (size_t i = 0; i != threads; ++i)
+		placement[i] = { cpus[i % cpus.size()] };
+	return placement;
+}
+
+size_t thread_count(size_t threads)
+{
+	if (threads)
+		return threads;
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+} // namespace
+
+thread_pool::thread_pool(size_t threads, thread_affinity affinity)
+	: io_(queue_backend::mutex, affinity == thread_affinity::none ? scheduler_mode::shared_queue : scheduler_mode::work_stealing)
+	, work_(new executor_work_guard<executor_type>(io_.get_executor()))
+	, worker_cpus_(place_workers(thread_count(threads), affinity))
+{
+	threads_.reserve(worker_cpus_.size());
+	for (size_t i = 0; i != worker_cpus_.size(); ++i)
+		threads_.emplace_back([this, i]() { run_worker(i); });
+}
+
+thread_pool::~thread_pool()
+{
+	stop();
+	join();
+}
+
+thread_pool::executor_type thread_pool::get_executor()
+{
+	return io_.get_executor();
+}
+
+size_t thread_pool::size() const
+{
+	return worker_cpus_.size();
+}
+
+std::vector<int> thread_pool::worker_cpus(size_t worker) const
+{
+	return worker < worker_cpus_.size() ? worker_cpus_[worker] : std::vector<int>();
+}
+
+void thread_pool::stop()
+{
+	io_.stop();
+}
+
+void thread_pool::join()
+{
+	std::lock_guard<std::mutex> lock(threads_guard_);
+
+	if (work_)
+		work_->reset();
+
+	for (auto& t : threads_)
+		if (t.joinable())
+			t.join();
+}
+
+void thread_pool::wait()
+{
+	join();
+}
+
+void thread_pool::run_worker(size_t worker)
+{
+	const std::vector<int>& cpus = worker_cpus_[worker];
+	if (!cpus.empty() && pin_this_thread(cpus))
+		detail::thread_memory_cache::fill();
+
+	io_.run();
+}
+
+} // namespace my_asio
\ No newline at end of file
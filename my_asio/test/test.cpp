@@ -4,12 +4,30 @@
 #include <mutex>
 #include <chrono>
 #include <condition_variable>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <stdexcept>
+#include <random>
+#include <system_error>
 #include <catch2/catch_test_macros.hpp>
 // #include <boost/asio.hpp> // uncomment if there is a need to check functions on boost library, and replace my_asio:: to boost::asio::
 
 #include "io_context.hpp"
 #include "executor_work_guard.hpp"
 #include "strand.hpp"
+#include "steady_timer.hpp"
+#include "timer_wheel.hpp"
+#include "call_stack.hpp"
+#include "append_printf.hpp"
+#include "sharded_metrics.hpp"
+#include "tcp.hpp"
+#include "bind_executor.hpp"
+#include "awaitable.hpp"
+#include "handler_trace.hpp"
+#include "thread_pool.hpp"
+#include "priority_executor.hpp"
+#include "strand_pool.hpp"
 
 TEST_CASE()
 {
@@ -689,4 +707,2498 @@ TEST_CASE("dispatch from strand", "")
 	io.run_one();
 
 	REQUIRE(dispatched == true);
-}
\ No newline at end of file
+}
+
+TEST_CASE("stop wakes idle threads", "[io_context][io_context::run][io_context::stop]")
+{
+	/*
+	threads parked in run() waiting for outstanding work must return once the context is stopped
+	*/
+	constexpr int NUMBER_OF_WORKERS = 4;
+
+	my_asio::io_context io;
+	my_asio::executor_work_guard<my_asio::io_context::executor_type> work(io.get_executor());
+	std::atomic<int> finished(0);
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != NUMBER_OF_WORKERS; ++i)
+		workers.emplace_back([&io, &finished]() {
+			io.run();
+			finished++;
+			});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	REQUIRE(finished == 0);
+
+	io.stop();
+	for (auto& t : workers)
+		t.join();
+
+	REQUIRE(finished == NUMBER_OF_WORKERS);
+}
+
+TEST_CASE("post wakes idle thread", "[io_context][io_context::run_one][post]")
+{
+	/*
+	a thread parked in run_one() must be woken by a post from another thread
+	*/
+	my_asio::io_context io;
+	my_asio::executor_work_guard<my_asio::io_context::executor_type> work(io.get_executor());
+	std::atomic<bool> executed(false);
+
+	std::thread t([&io]() { io.run_one(); });
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	my_asio::post(io, [&executed]() { executed = true; });
+
+	t.join();
+	REQUIRE(executed == true);
+}
+
+TEST_CASE("every run returns when a handler resets the last work guard", "[io_context][io_context::run][executor_work_guard]")
+{
+	/*
+	the guard's work goes to the credits of the thread running the handler, all the parked threads
+	must still return once those credits are retired
+	*/
+	constexpr int NUMBER_OF_WORKERS = 4;
+	constexpr int NUMBER_OF_WORKS = 100;
+
+	my_asio::io_context io;
+	auto work = std::make_unique<my_asio::executor_work_guard<my_asio::io_context::executor_type>>(io.get_executor());
+	std::atomic<int> finished(0);
+	std::atomic<int> counter(0);
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != NUMBER_OF_WORKERS; ++i)
+		workers.emplace_back([&io, &finished]() {
+			io.run();
+			finished++;
+			});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+		my_asio::post(io, [&counter]() { counter++; });
+	my_asio::post(io, [&work]() { work.reset(); });
+
+	for (auto& t : workers)
+		t.join();
+
+	REQUIRE(finished == NUMBER_OF_WORKERS);
+	REQUIRE(counter == NUMBER_OF_WORKS);
+	REQUIRE(io.stopped());
+}
+
+TEST_CASE("run_one and poll return 0 exactly when the work is gone", "[io_context][io_context::run_one][io_context::poll][executor_work_guard]")
+{
+	/*
+	work finished on the calling thread is kept as credits until its queues run dry, it must neither
+	hide that the work is gone nor make the context look idle while a handler still runs
+	*/
+	my_asio::io_context io;
+	my_asio::executor_work_guard<my_asio::io_context::executor_type> work(io.get_executor());
+	int counter(0);
+
+	SECTION("run_one")
+	{
+		my_asio::post(io, [&counter]() { counter++; });
+		my_asio::post(io, [&work]() { work.reset(); });
+
+		REQUIRE(io.run_one() == 1);
+		REQUIRE_FALSE(io.stopped());
+		REQUIRE(io.run_one() == 1);
+		REQUIRE(io.stopped());
+		REQUIRE(counter == 1);
+
+		// nothing is left, a blocking run_one must not wait
+		io.restart();
+		REQUIRE(io.run_one() == 0);
+		REQUIRE(io.stopped());
+	}
+
+	SECTION("poll with the guard held")
+	{
+		my_asio::post(io, [&counter]() { counter++; });
+
+		REQUIRE(io.poll() == 1);
+		REQUIRE_FALSE(io.stopped());
+		REQUIRE(io.poll() == 0);
+		REQUIRE_FALSE(io.stopped());
+
+		work.reset();
+		REQUIRE(io.poll() == 0);
+		REQUIRE(io.stopped());
+	}
+
+	SECTION("poll after the guard is reset in a handler")
+	{
+		for (int i = 0; i != 10; ++i)
+			my_asio::post(io, [&counter]() { counter++; });
+		my_asio::post(io, [&work]() { work.reset(); });
+
+		REQUIRE(io.poll() == 11);
+		REQUIRE(io.stopped());
+		REQUIRE(counter == 10);
+
+		io.restart();
+		REQUIRE(io.poll() == 0);
+		REQUIRE(io.stopped());
+	}
+
+	SECTION("nested poll while the outer handler runs")
+	{
+		size_t nested = 1;
+		bool stopped_inside = true;
+		my_asio::post(io, [&io, &work, &nested, &stopped_inside]() {
+			work.reset();
+			// the outer handler is still work of the context
+			nested = io.poll();
+			stopped_inside = io.stopped();
+			});
+
+		REQUIRE(io.run() == 1);
+		REQUIRE(nested == 0);
+		REQUIRE_FALSE(stopped_inside);
+		REQUIRE(io.stopped());
+	}
+}
+
+TEST_CASE("a parked thread waits for a blocked handler holding credits", "[io_context][io_context::run][executor_work_guard]")
+{
+	/*
+	a handler resets the last guard and then blocks, the other thread must stay parked instead of
+	stopping the context, and return once the handler does
+	*/
+	my_asio::io_context io;
+	auto work = std::make_unique<my_asio::executor_work_guard<my_asio::io_context::executor_type>>(io.get_executor());
+	std::atomic<bool> entered(false);
+	std::atomic<bool> release(false);
+	std::atomic<int> finished(0);
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != 2; ++i)
+		workers.emplace_back([&io, &finished]() {
+			io.run();
+			finished++;
+			});
+
+	my_asio::post(io, [&work, &entered, &release]() {
+		work.reset();
+		entered = true;
+		while (!release)
+			std::this_thread::yield();
+		});
+
+	while (!entered)
+		std::this_thread::yield();
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	REQUIRE_FALSE(io.stopped());
+	REQUIRE(finished == 0);
+
+	release = true;
+	for (auto& t : workers)
+		t.join();
+
+	REQUIRE(finished == 2);
+	REQUIRE(io.stopped());
+}
+
+TEST_CASE("lock_free backend post several works in order", "[post][io_context][io_context::run][queue_backend]")
+{
+	/*
+	handlers posted from one thread are executed in FIFO order, also when the ring overflows
+	*/
+	constexpr int NUMBER_OF_WORKS = 100'000;
+
+	my_asio::io_context io(my_asio::queue_backend::lock_free);
+	std::vector<int> order;
+
+	for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+		my_asio::post(io, [&order, i]() {
+			order.push_back(i);
+			});
+
+	REQUIRE(io.run() == NUMBER_OF_WORKS);
+
+	REQUIRE(order.size() == NUMBER_OF_WORKS);
+	bool in_order = true;
+	for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+		in_order = in_order && order[i] == i;
+	REQUIRE(in_order);
+}
+
+TEST_CASE("lock_free backend many producers many consumers", "[post][io_context][io_context::run][queue_backend]")
+{
+	constexpr int NUMBER_OF_PRODUCERS = 4;
+	constexpr int NUMBER_OF_CONSUMERS = 4;
+	constexpr int NUMBER_OF_WORKS = 50'000;
+
+	my_asio::io_context io(my_asio::queue_backend::lock_free);
+	auto work = std::make_unique<my_asio::executor_work_guard<my_asio::io_context::executor_type>>(io.get_executor());
+	std::atomic<int> counter(0);
+
+	std::vector<std::thread> consumers;
+	for (int i = 0; i != NUMBER_OF_CONSUMERS; ++i)
+		consumers.emplace_back([&io]() { io.run(); });
+
+	std::vector<std::thread> producers;
+	for (int i = 0; i != NUMBER_OF_PRODUCERS; ++i)
+		producers.emplace_back([&io, &counter]() {
+			for (int j = 0; j != NUMBER_OF_WORKS; ++j)
+				my_asio::post(io, [&counter]() { counter++; });
+			});
+
+	for (auto& t : producers)
+		t.join();
+	work.reset();
+	for (auto& t : consumers)
+		t.join();
+
+	REQUIRE(counter == NUMBER_OF_PRODUCERS * NUMBER_OF_WORKS);
+}
+
+TEST_CASE("lock_free backend strand run", "[io_context][io_context::run][strand][post][queue_backend]")
+{
+	my_asio::io_context io(my_asio::queue_backend::lock_free);
+	my_asio::strand<my_asio::io_context::executor_type> strand_(io.get_executor());
+	int s_counter(0);
+
+	constexpr int NUMBER_OF_WORKS = 1000;
+	constexpr int NUMBER_OF_WORKERS = 4;
+
+	for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+		my_asio::post(strand_, [&s_counter]() { s_counter++; });
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != NUMBER_OF_WORKERS; ++i)
+		workers.emplace_back([&io]() { io.run(); });
+	for (auto& t : workers)
+		t.join();
+
+	REQUIRE(s_counter == NUMBER_OF_WORKS);
+}
+
+TEST_CASE("work_stealing fan-out", "[io_context][io_context::run][post][scheduler_mode]")
+{
+	/*
+	handlers posted from inside a handler land on the worker's local queue and are shared with idle workers by stealing
+	*/
+	constexpr int NUMBER_OF_ROOTS = 10;
+	constexpr int NUMBER_OF_CHILDREN = 1000;
+	constexpr int NUMBER_OF_WORKERS = 4;
+
+	my_asio::io_context io(my_asio::scheduler_mode::work_stealing);
+	std::atomic<int> counter(0);
+
+	for (int i = 0; i != NUMBER_OF_ROOTS; ++i)
+		my_asio::post(io, [&io, &counter]() {
+			for (int j = 0; j != NUMBER_OF_CHILDREN; ++j)
+				my_asio::post(io, [&counter]() { counter++; });
+			});
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != NUMBER_OF_WORKERS; ++i)
+		workers.emplace_back([&io]() { io.run(); });
+	for (auto& t : workers)
+		t.join();
+
+	REQUIRE(counter == NUMBER_OF_ROOTS * NUMBER_OF_CHILDREN);
+}
+
+TEST_CASE("work_stealing run_one hands local handlers back", "[io_context][io_context::run_one][post][scheduler_mode]")
+{
+	/*
+	handlers left in the local queue when run_one returns are moved to the shared queue, so another run picks them up
+	*/
+	constexpr int NUMBER_OF_CHILDREN = 10;
+
+	my_asio::io_context io(my_asio::scheduler_mode::work_stealing);
+	std::atomic<int> counter(0);
+
+	my_asio::post(io, [&io, &counter]() {
+		for (int j = 0; j != NUMBER_OF_CHILDREN; ++j)
+			my_asio::post(io, [&counter]() { counter++; });
+		});
+
+	REQUIRE(io.run_one() == 1);
+	REQUIRE(counter == 0);
+
+	std::thread([&io]() { io.run(); }).join();
+
+	REQUIRE(counter == NUMBER_OF_CHILDREN);
+}
+
+TEST_CASE("work_stealing stop/restart", "[io_context][io_context::run][io_context::stop][io_context::restart][scheduler_mode]")
+{
+	my_asio::io_context io(my_asio::scheduler_mode::work_stealing);
+	std::atomic<int> counter(0);
+
+	my_asio::post(io, [&io, &counter]() {
+		for (int j = 0; j != 10; ++j)
+			my_asio::post(io, [&counter]() { counter++; });
+		io.stop();
+		});
+
+	io.run();
+	REQUIRE(io.stopped() == true);
+	REQUIRE(counter == 0);
+
+	io.restart();
+	io.run();
+	REQUIRE(counter == 10);
+}
+
+TEST_CASE("post move-only handler", "[post][dispatch][strand][io_context][io_context::run][any_handler]")
+{
+	/*
+	handlers capturing move-only objects can be posted and dispatched through io_context and strand
+	*/
+	my_asio::io_context io;
+	my_asio::strand<my_asio::io_context::executor_type> strand_(io.get_executor());
+	int sum(0);
+
+	auto a = std::make_unique<int>(1);
+	my_asio::post(io, [&sum, a = std::move(a)]() { sum += *a; });
+
+	auto b = std::make_unique<int>(10);
+	my_asio::post(strand_, [&sum, b = std::move(b)]() { sum += *b; });
+
+	auto c = std::make_unique<int>(100);
+	my_asio::post(io, [&io, &sum, c = std::move(c)]() mutable {
+		my_asio::dispatch(io, [&sum, c = std::move(c)]() { sum += *c; });
+		});
+
+	io.run();
+
+	REQUIRE(sum == 111);
+}
+
+TEST_CASE("any_handler stores large callables", "[any_handler]")
+{
+	/*
+	callables that do not fit the inline buffer are heap allocated, moved handlers keep working and are destroyed once
+	*/
+	struct large
+	{
+		std::shared_ptr<int> calls;
+		char payload[my_asio::any_handler::inline_size];
+		void operator()() { ++*calls; }
+	};
+
+	auto calls = std::make_shared<int>(0);
+	my_asio::any_handler h1(large{ calls, {} });
+	my_asio::any_handler h2(std::move(h1));
+
+	REQUIRE(static_cast<bool>(h1) == false);
+	REQUIRE(static_cast<bool>(h2) == true);
+
+	h2();
+	REQUIRE(*calls == 1);
+
+	h2 = nullptr;
+	REQUIRE(calls.use_count() == 1);
+}
+
+TEST_CASE("recycling allocator reuses handler storage", "[post][io_context][io_context::run][recycling_allocator]")
+{
+	/*
+	a large handler posted and run on the same thread reuses the block freed by the previous one
+	*/
+	constexpr int NUMBER_OF_WORKS = 100;
+
+	my_asio::io_context io;
+	int counter(0);
+	char payload[2 * my_asio::any_handler::inline_size] = {};
+
+	const my_asio::recycling_allocator_stats before = my_asio::this_thread_recycling_stats();
+
+	for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+	{
+		my_asio::post(io, [&counter, payload]() { counter += 1 + payload[0]; });
+		io.restart();
+		io.run();
+	}
+
+	const my_asio::recycling_allocator_stats after = my_asio::this_thread_recycling_stats();
+
+	REQUIRE(counter == NUMBER_OF_WORKS);
+	REQUIRE(after.hits - before.hits >= NUMBER_OF_WORKS - 1);
+	REQUIRE(after.hit_rate() > 0.0);
+}
+
+TEST_CASE("dispatch invokes inline without copying the handler", "[dispatch][defer][io_context][strand][is_executor]")
+{
+	/*
+	when dispatch can run the handler in place it is neither copied nor moved, posted rvalue handlers are never copied
+	*/
+	static_assert(my_asio::is_executor<my_asio::io_context::executor_type>::value, "");
+	static_assert(my_asio::is_executor<my_asio::strand<my_asio::io_context::executor_type>>::value, "");
+	static_assert(!my_asio::is_executor<my_asio::io_context>::value, "");
+
+	struct counting_handler
+	{
+		int* copies;
+		int* moves;
+		int* calls;
+
+		counting_handler(int* c, int* m, int* n) : copies(c), moves(m), calls(n) {}
+		counting_handler(const counting_handler& other) : copies(other.copies), moves(other.moves), calls(other.calls) { ++*copies; }
+		counting_handler(counting_handler&& other) noexcept : copies(other.copies), moves(other.moves), calls(other.calls) { ++*moves; }
+		void operator()() { ++*calls; }
+	};
+
+	my_asio::io_context io;
+	my_asio::strand<my_asio::io_context::executor_type> strand_(io.get_executor());
+	int copies(0), moves(0), calls(0);
+
+	my_asio::post(strand_, [&]() {
+		counting_handler h(&copies, &moves, &calls);
+		my_asio::dispatch(io.get_executor(), h);
+		my_asio::dispatch(strand_, h);
+		});
+	io.run();
+
+	REQUIRE(calls == 2);
+	REQUIRE(copies == 0);
+	REQUIRE(moves == 0);
+
+	io.restart();
+	my_asio::defer(io, counting_handler(&copies, &moves, &calls));
+	io.run();
+
+	REQUIRE(calls == 3);
+	REQUIRE(copies == 0);
+}
+
+TEST_CASE("make_work_guard", "[executor_work_guard][io_context][io_context::run]")
+{
+	my_asio::io_context io;
+	auto work = my_asio::make_work_guard(io);
+	auto moved = std::move(work);
+
+	REQUIRE(work.owns_work() == false);
+	REQUIRE(moved.owns_work() == true);
+
+	std::atomic<bool> finished_run(false);
+	std::thread t([&io, &finished_run]() {
+		io.run();
+		finished_run = true;
+		});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	REQUIRE(finished_run == false);
+
+	moved.reset();
+	t.join();
+	REQUIRE(finished_run == true);
+}
+
+TEST_CASE("deferred handlers are queued when the handler returns", "[post][defer][io_context][io_context::run_one][io_context::poll]")
+{
+	/*
+	handlers posted by a handler are queued right away, the deferred ones once the handler
+	returns, both in order
+	*/
+	constexpr int NUMBER_OF_CHILDREN = 10;
+
+	my_asio::io_context io;
+	std::vector<int> order;
+
+	my_asio::post(io, [&io, &order]() {
+		for (int i = 0; i != NUMBER_OF_CHILDREN; ++i)
+		{
+			if (i % 2)
+				my_asio::post(io, [&order, i]() { order.push_back(i); });
+			else
+				my_asio::defer(io, [&order, i]() { order.push_back(i); });
+		}
+		});
+
+	REQUIRE(io.run_one() == 1);
+	REQUIRE(order.empty());
+	REQUIRE(io.stopped() == false);
+
+	REQUIRE(io.poll() == NUMBER_OF_CHILDREN);
+	REQUIRE(order.size() == NUMBER_OF_CHILDREN);
+	for (int i = 0; i != NUMBER_OF_CHILDREN / 2; ++i)
+	{
+		REQUIRE(order[i] == 2 * i + 1);
+		REQUIRE(order[NUMBER_OF_CHILDREN / 2 + i] == 2 * i);
+	}
+}
+
+TEST_CASE("another thread runs a post before the posting handler returns", "[post][defer][io_context][io_context::run]")
+{
+	/*
+	a handler can wait for a handler it has posted, not for one it has deferred
+	*/
+	my_asio::io_context io;
+	auto work = std::make_unique<my_asio::executor_work_guard<my_asio::io_context::executor_type>>(io.get_executor());
+
+	std::mutex m;
+	std::condition_variable cv;
+	bool posted_ran(false);
+	bool waited(false);
+	std::atomic<bool> deferring_returned(false);
+	std::atomic<bool> deferred_ran_early(false);
+
+	my_asio::post(io, [&]() {
+		my_asio::post(io, [&]() {
+			std::lock_guard<std::mutex> lock(m);
+			posted_ran = true;
+			cv.notify_one();
+			});
+
+		std::unique_lock<std::mutex> lock(m);
+		waited = cv.wait_for(lock, std::chrono::seconds(10), [&posted_ran]() { return posted_ran; });
+		});
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != 2; ++i)
+		workers.emplace_back([&io]() { io.run(); });
+
+	SECTION("post")
+	{
+		std::unique_lock<std::mutex> lock(m);
+		cv.wait_for(lock, std::chrono::seconds(10), [&posted_ran]() { return posted_ran; });
+	}
+
+	SECTION("defer")
+	{
+		my_asio::post(io, [&]() {
+			my_asio::defer(io, [&]() {
+				if (!deferring_returned)
+					deferred_ran_early = true;
+				});
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			deferring_returned = true;
+			});
+	}
+
+	work.reset();
+	for (auto& t : workers)
+		t.join();
+
+	REQUIRE(waited == true);
+	REQUIRE(deferred_ran_early == false);
+}
+
+TEST_CASE("nested run sees continuations of the enclosing handler", "[post][io_context][io_context::run]")
+{
+	my_asio::io_context io;
+	bool inner_ran(false);
+
+	my_asio::post(io, [&io, &inner_ran]() {
+		my_asio::defer(io, [&inner_ran]() { inner_ran = true; });
+		io.run_one();
+		});
+
+	io.run();
+
+	REQUIRE(inner_ran == true);
+}
+
+TEST_CASE("chained continuations on several threads", "[post][io_context][io_context::run]")
+{
+	constexpr int NUMBER_OF_CHAINS = 8;
+	constexpr int CHAIN_LENGTH = 10'000;
+	constexpr int NUMBER_OF_WORKERS = 4;
+
+	my_asio::io_context io;
+	std::atomic<int> counter(0);
+
+	std::function<void(int)> step = [&io, &counter, &step](int remaining) {
+		counter++;
+		if (remaining)
+			my_asio::post(io, [&step, remaining]() { step(remaining - 1); });
+		};
+
+	for (int i = 0; i != NUMBER_OF_CHAINS; ++i)
+		my_asio::post(io, [&step]() { step(CHAIN_LENGTH - 1); });
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != NUMBER_OF_WORKERS; ++i)
+		workers.emplace_back([&io]() { io.run(); });
+	for (auto& t : workers)
+		t.join();
+
+	REQUIRE(counter == NUMBER_OF_CHAINS * CHAIN_LENGTH);
+}
+
+TEST_CASE("post_bulk", "[post_bulk][io_context][io_context::run]")
+{
+	constexpr int NUMBER_OF_WORKS = 100;
+
+	my_asio::io_context io;
+	std::vector<int> order;
+
+	std::vector<std::function<void()>> handlers;
+	for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+		handlers.push_back([&order, i]() { order.push_back(i); });
+
+	my_asio::post_bulk(io, handlers);
+	REQUIRE(handlers.size() == NUMBER_OF_WORKS);
+
+	std::vector<my_asio::any_handler> move_only;
+	auto value = std::make_unique<int>(NUMBER_OF_WORKS);
+	move_only.emplace_back([&order, value = std::move(value)]() { order.push_back(*value); });
+	my_asio::post_bulk(io.get_executor(), std::move(move_only));
+
+	REQUIRE(io.run() == NUMBER_OF_WORKS + 1);
+
+	REQUIRE(order.size() == NUMBER_OF_WORKS + 1);
+	for (int i = 0; i != NUMBER_OF_WORKS + 1; ++i)
+		REQUIRE(order[i] == i);
+}
+
+TEST_CASE("batched run honours stop between handlers", "[io_context][io_context::run][io_context::stop][io_context::set_batch_size]")
+{
+	/*
+	a batch taken by run() is interrupted by stop(), the handlers that did not run are executed after restart,
+	in order and ahead of the handlers queued since
+	*/
+	constexpr int NUMBER_OF_WORKS = 100;
+
+	std::unique_ptr<my_asio::io_context> io_owner;
+	SECTION("mutex queue")
+	{
+		io_owner.reset(new my_asio::io_context(my_asio::queue_backend::mutex));
+	}
+	SECTION("lock-free queue")
+	{
+		io_owner.reset(new my_asio::io_context(my_asio::queue_backend::lock_free));
+	}
+	SECTION("single consumer queue")
+	{
+		io_owner.reset(new my_asio::io_context(1));
+	}
+
+	my_asio::io_context& io = *io_owner;
+	io.set_batch_size(16);
+	REQUIRE(io.batch_size() == 16);
+
+	std::vector<int> order;
+	for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+		my_asio::post(io, [&io, &order, i]() {
+			order.push_back(i);
+			if (i == 5)
+			{
+				io.stop();
+				my_asio::post(io, [&order, late = NUMBER_OF_WORKS]() { order.push_back(late); });
+			}
+			});
+
+	REQUIRE(io.run() == 6);
+	REQUIRE(order.size() == 6);
+
+	io.restart();
+	REQUIRE(io.run() == NUMBER_OF_WORKS - 5);
+	REQUIRE(order.size() == NUMBER_OF_WORKS + 1);
+	for (int i = 0; i != NUMBER_OF_WORKS + 1; ++i)
+		REQUIRE(order[i] == i);
+}
+
+TEST_CASE("strand handler posts to its own strand", "[strand][post][io_context][io_context::run]")
+{
+	/*
+	the strand runs handlers with no lock held, so a handler can post to its own strand without deadlocking
+	*/
+	constexpr int CHAIN_LENGTH = 1000;
+
+	my_asio::io_context io;
+	my_asio::strand<my_asio::io_context::executor_type> strand_(io.get_executor());
+	int counter(0);
+
+	std::function<void()> step = [&strand_, &counter, &step]() {
+		if (++counter != CHAIN_LENGTH)
+			my_asio::post(strand_, step);
+		};
+	my_asio::post(strand_, step);
+
+	io.run();
+
+	REQUIRE(counter == CHAIN_LENGTH);
+}
+
+TEST_CASE("strand keeps FIFO order and exclusivity under contention", "[strand][post][io_context][io_context::run]")
+{
+	constexpr int NUMBER_OF_PRODUCERS = 4;
+	constexpr int NUMBER_OF_WORKS = 10'000;
+	constexpr int NUMBER_OF_WORKERS = 4;
+
+	my_asio::io_context io;
+	my_asio::strand<my_asio::io_context::executor_type> strand_(io.get_executor());
+	auto work = std::make_unique<my_asio::executor_work_guard<my_asio::io_context::executor_type>>(io.get_executor());
+
+	std::atomic<int> in_flight(0);
+	std::atomic<bool> overlapped(false);
+	std::vector<int> last_seen(NUMBER_OF_PRODUCERS, -1);
+	bool in_order(true);
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != NUMBER_OF_WORKERS; ++i)
+		workers.emplace_back([&io]() { io.run(); });
+
+	std::vector<std::thread> producers;
+	for (int p = 0; p != NUMBER_OF_PRODUCERS; ++p)
+		producers.emplace_back([&, p]() {
+			for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+				my_asio::post(strand_, [&, p, i]() {
+					if (in_flight++ != 0)
+						overlapped = true;
+					in_order = in_order && last_seen[p] == i - 1;
+					last_seen[p] = i;
+					in_flight--;
+					});
+			});
+
+	for (auto& t : producers)
+		t.join();
+	work.reset();
+	for (auto& t : workers)
+		t.join();
+
+	REQUIRE(overlapped == false);
+	REQUIRE(in_order == true);
+	for (int p = 0; p != NUMBER_OF_PRODUCERS; ++p)
+		REQUIRE(last_seen[p] == NUMBER_OF_WORKS - 1);
+}
+
+
+TEST_CASE("strand runs up to its turn budget per scheduling turn", "[strand][post][io_context][io_context::run]")
+{
+	/*
+	handlers already queued on the strand run back to back until the budget is used up,
+	then the strand is re-posted behind the other work of the io_context
+	*/
+	constexpr int NUMBER_OF_WORKS = 100;
+
+	my_asio::io_context io;
+	my_asio::strand<my_asio::io_context::executor_type> strand_(io.get_executor());
+	std::vector<int> order;
+
+	SECTION("handler budget")
+	{
+		strand_.set_turn_budget(10);
+
+		for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+			my_asio::post(strand_, [&order]() { order.push_back(0); });
+		my_asio::post(io, [&order]() { order.push_back(1); });
+
+		io.run();
+
+		REQUIRE(order.size() == NUMBER_OF_WORKS + 1);
+		REQUIRE(order[10] == 1);
+
+		const my_asio::strand_stats stats = strand_.stats();
+		REQUIRE(stats.turns == NUMBER_OF_WORKS / 10);
+		REQUIRE(stats.handlers == NUMBER_OF_WORKS);
+		REQUIRE(stats.max_handlers_per_turn == 10);
+		REQUIRE(stats.handlers_per_turn() == 10.0);
+	}
+
+	SECTION("time budget")
+	{
+		strand_.set_turn_budget(NUMBER_OF_WORKS, std::chrono::microseconds(1));
+
+		for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+			my_asio::post(strand_, [&order]() {
+				std::this_thread::sleep_for(std::chrono::microseconds(10));
+				order.push_back(0);
+				});
+		my_asio::post(io, [&order]() { order.push_back(1); });
+
+		io.run();
+
+		REQUIRE(order.size() == NUMBER_OF_WORKS + 1);
+		REQUIRE(order[1] == 1);
+		REQUIRE(strand_.stats().turns == NUMBER_OF_WORKS);
+		REQUIRE(strand_.stats().max_handlers_per_turn == 1);
+	}
+}
+
+TEST_CASE("throwing strand handler passes the strand on", "[strand][post][io_context][io_context::run]")
+{
+	my_asio::io_context io;
+	my_asio::strand<my_asio::io_context::executor_type> strand_(io.get_executor());
+	int counter(0);
+
+	my_asio::post(strand_, []() { throw std::runtime_error("handler failed"); });
+	my_asio::post(strand_, [&counter]() { counter++; });
+
+	REQUIRE_THROWS(io.run());
+
+	io.restart();
+	io.run();
+
+	REQUIRE(counter == 1);
+}
+
+TEST_CASE("throwing handler still hands over what it deferred", "[io_context][defer][io_context::run][io_context::set_batch_size]")
+{
+	/*
+	the handlers deferred by a throwing handler, and the rest of its batch, are queued before the
+	exception leaves run(). They run in order, and run() returns once they are done
+	*/
+	my_asio::io_context io;
+	io.set_batch_size(4);
+	std::string order;
+
+	my_asio::post(io, [&io, &order]() {
+		order += 'a';
+		my_asio::defer(io, [&order]() { order += 'd'; });
+		my_asio::defer(io, [&order]() { order += 'e'; });
+		throw std::runtime_error("handler failed");
+		});
+	my_asio::post(io, [&order]() { order += 'b'; });
+	my_asio::post(io, [&order]() { order += 'c'; });
+
+	REQUIRE_THROWS_AS(io.run(), std::runtime_error);
+	REQUIRE(order == "a");
+	REQUIRE(io.stopped() == false);
+
+	REQUIRE(io.run() == 4);
+	REQUIRE(order == "abcde");
+	REQUIRE(io.stopped() == true);
+}
+
+TEST_CASE("histogram buckets are log-linear", "[metrics]")
+{
+	for (uint64_t value : { 0ull, 1ull, 3ull, 4ull, 5ull, 7ull, 8ull, 100ull, 1000ull, 123456789ull, 1ull << 40, ~0ull })
+	{
+		const size_t index = my_asio::histogram_snapshot::bucket_index(value);
+		REQUIRE(index < my_asio::histogram_snapshot::bucket_count);
+		REQUIRE(my_asio::histogram_snapshot::bucket_upper_bound(index) >= value);
+		if (index != 0)
+			REQUIRE(my_asio::histogram_snapshot::bucket_upper_bound(index - 1) < value);
+
+		// a bucket spans at most a quarter of its lower bound
+		REQUIRE(my_asio::histogram_snapshot::bucket_upper_bound(index) - value <= value / 4);
+	}
+}
+
+TEST_CASE("prometheus buckets include their upper bound", "[metrics]")
+{
+	/*
+	le means less than or equal, a sample of exactly 2^k ns is counted in the bucket le="2^k ns"
+	*/
+	auto histogram = std::make_unique<my_asio::detail::latency_histogram>();
+	for (long long ns : { 0, 1, 3, 4, 5, 8 })
+		histogram->record(std::chrono::nanoseconds(ns));
+
+	my_asio::io_context_metrics metrics;
+	metrics.queue_wait = histogram->snapshot();
+
+	const std::string prometheus = my_asio::to_prometheus(metrics, "h");
+	REQUIRE(prometheus.find("h_queue_wait_seconds_bucket{le=\"1e-09\"} 2\n") != std::string::npos);
+	REQUIRE(prometheus.find("h_queue_wait_seconds_bucket{le=\"2e-09\"} 2\n") != std::string::npos);
+	REQUIRE(prometheus.find("h_queue_wait_seconds_bucket{le=\"4e-09\"} 4\n") != std::string::npos);
+	REQUIRE(prometheus.find("h_queue_wait_seconds_bucket{le=\"8e-09\"} 6\n") != std::string::npos);
+	REQUIRE(prometheus.find("h_queue_wait_seconds_bucket{le=\"+Inf\"} 6\n") != std::string::npos);
+}
+
+TEST_CASE("append_printf does not truncate", "[metrics][handler_tracking]")
+{
+	const std::string long_name(1000, 'x');
+	std::string out("a");
+	my_asio::detail::append_printf(out, "%s_%d", long_name.c_str(), 42);
+	REQUIRE(out == "a" + long_name + "_42");
+
+	my_asio::detail::append_printf(out, "%s", "");
+	REQUIRE(out.size() == long_name.size() + 4);
+}
+
+TEST_CASE("io_context metrics", "[metrics][io_context][io_context::run]")
+{
+	constexpr int NUMBER_OF_WORKS = 1000;
+	constexpr int NUMBER_OF_THREADS = 4;
+
+	my_asio::io_context io;
+	REQUIRE_FALSE(io.metrics().enabled);
+
+	io.enable_metrics(1);
+	std::atomic<int> counter(0);
+
+	for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+		my_asio::post(io, [&counter]() { counter++; });
+	my_asio::post(io, []() { std::this_thread::sleep_for(std::chrono::milliseconds(2)); });
+
+	my_asio::io_context_metrics metrics = io.metrics();
+	REQUIRE(metrics.enabled);
+	REQUIRE(metrics.handlers_queued == NUMBER_OF_WORKS + 1);
+	REQUIRE(metrics.ready_handlers == NUMBER_OF_WORKS + 1);
+	REQUIRE(metrics.outstanding_work == NUMBER_OF_WORKS + 1);
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i != NUMBER_OF_THREADS; ++i)
+		threads.emplace_back([&io]() { io.run(); });
+	for (auto& t : threads)
+		t.join();
+
+	metrics = io.metrics();
+	REQUIRE(counter == NUMBER_OF_WORKS);
+	REQUIRE(metrics.handlers_run == NUMBER_OF_WORKS + 1);
+	REQUIRE(metrics.ready_handlers == 0);
+	REQUIRE(metrics.outstanding_work == 0);
+	REQUIRE(metrics.queue_wait.count() == NUMBER_OF_WORKS + 1);
+	REQUIRE(metrics.run_time.count() == NUMBER_OF_WORKS + 1);
+	REQUIRE(metrics.run_time.max() >= 2'000'000);
+	REQUIRE(metrics.run_time.percentile(0.5) < 2'000'000);
+
+	const std::string prometheus = my_asio::to_prometheus(metrics);
+	REQUIRE(prometheus.find("my_asio_io_context_handlers_run_total 1001\n") != std::string::npos);
+	REQUIRE(prometheus.find("my_asio_io_context_run_time_seconds_count 1001\n") != std::string::npos);
+	REQUIRE(prometheus.find("my_asio_io_context_run_time_seconds_bucket{le=\"+Inf\"} 1001\n") != std::string::npos);
+
+	const std::string json = my_asio::to_json(metrics);
+	REQUIRE(json.find("\"handlers_run\": 1001") != std::string::npos);
+	REQUIRE(json.front() == '{');
+	REQUIRE(json.back() == '}');
+}
+
+TEST_CASE("strand metrics", "[metrics][strand][io_context::run]")
+{
+	constexpr int NUMBER_OF_WORKS = 50;
+
+	my_asio::io_context io;
+	my_asio::strand<my_asio::io_context::executor_type> strand_(io.get_executor());
+	REQUIRE_FALSE(strand_.metrics().enabled);
+
+	strand_.enable_metrics(1);
+	for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+		my_asio::post(strand_, []() {});
+
+	my_asio::strand_metrics metrics = strand_.metrics();
+	REQUIRE(metrics.enabled);
+	REQUIRE(metrics.handlers_posted == NUMBER_OF_WORKS);
+	REQUIRE(metrics.backlog == NUMBER_OF_WORKS);
+
+	io.run();
+
+	metrics = strand_.metrics();
+	REQUIRE(metrics.handlers_run == NUMBER_OF_WORKS);
+	REQUIRE(metrics.backlog == 0);
+	REQUIRE(metrics.queue_wait.count() == NUMBER_OF_WORKS);
+	REQUIRE(metrics.run_time.count() == NUMBER_OF_WORKS);
+	REQUIRE(my_asio::to_prometheus(metrics).find("my_asio_strand_handlers_posted_total 50\n") != std::string::npos);
+	REQUIRE(my_asio::to_json(metrics).find("\"backlog\": 0") != std::string::npos);
+}
+
+TEST_CASE("handler trace", "[handler_tracking][strand][io_context::run]")
+{
+	/*
+	with handler tracking compiled in, every run handler is a slice of the Chrome trace with
+	the handler that posted it as its parent. Without it the trace is empty
+	*/
+	my_asio::io_context io;
+	my_asio::strand<my_asio::io_context::executor_type> strand_(io.get_executor());
+	my_asio::clear_handler_trace();
+
+	my_asio::post(io, [&io, &strand_]() {
+		my_asio::post(io, []() {});
+		my_asio::post(strand_, []() {});
+		});
+	io.run();
+
+	const std::string trace = my_asio::handler_trace_json();
+	REQUIRE(trace.find("{\"traceEvents\": [") == 0);
+
+	if (my_asio::handler_tracking_enabled)
+	{
+		// the outer handler, the two it posted and the strand's turn
+		size_t slices = 0;
+		for (size_t pos = trace.find("\"ph\": \"X\""); pos != std::string::npos; pos = trace.find("\"ph\": \"X\"", pos + 1))
+			++slices;
+		REQUIRE(slices == 4);
+
+		REQUIRE(trace.find("\"name\": \"strand handler ") != std::string::npos);
+		REQUIRE(trace.find("\"ph\": \"s\"") != std::string::npos);
+		REQUIRE(trace.find("\"ph\": \"f\"") != std::string::npos);
+
+		// the outer handler was posted from outside any handler, the others name it as their parent
+		const std::string id_prefix = "\"args\": {\"id\": ";
+		const size_t outer_id_pos = trace.find(id_prefix);
+		REQUIRE(outer_id_pos != std::string::npos);
+		const size_t outer_id_begin = outer_id_pos + id_prefix.size();
+		const std::string outer_id = trace.substr(outer_id_begin, trace.find_first_of(",}", outer_id_begin) - outer_id_begin);
+		size_t children = 0;
+		for (size_t pos = trace.find("\"parent\": " + outer_id + ","); pos != std::string::npos; pos = trace.find("\"parent\": " + outer_id + ",", pos + 1))
+			++children;
+		REQUIRE(children == 3);
+
+		my_asio::clear_handler_trace();
+		REQUIRE(my_asio::handler_trace_json().find("\"ph\": \"X\"") == std::string::npos);
+	}
+	else
+	{
+		REQUIRE(trace.find("\"ph\"") == std::string::npos);
+	}
+}
+
+TEST_CASE("thread_pool runs the posted handlers before join returns", "[thread_pool][post]")
+{
+	constexpr int NUMBER_OF_WORKS = 10000;
+
+	for (my_asio::thread_affinity affinity : { my_asio::thread_affinity::none, my_asio::thread_affinity::core, my_asio::thread_affinity::numa_node })
+	{
+		my_asio::thread_pool pool(4, affinity);
+		REQUIRE(pool.size() == 4);
+		std::atomic<int> counter(0);
+
+		// handlers posting more handlers, which stay on the posting worker when pinned
+		for (int i = 0; i != NUMBER_OF_WORKS / 2; ++i)
+			my_asio::post(pool.get_executor(), [&pool, &counter]() {
+				counter++;
+				my_asio::post(pool.get_executor(), [&counter]() { counter++; });
+				});
+
+		pool.join();
+		REQUIRE(counter == NUMBER_OF_WORKS);
+	}
+}
+
+TEST_CASE("thread_pool stop", "[thread_pool][post]")
+{
+	my_asio::thread_pool pool(1);
+	std::atomic<int> counter(0);
+
+	// handlers posted after stop() are never run
+	my_asio::post(pool.get_executor(), [&pool, &counter]() {
+		pool.stop();
+		for (int i = 0; i != 10; ++i)
+			my_asio::post(pool.get_executor(), [&counter]() { counter++; });
+		});
+
+	pool.wait();
+	REQUIRE(counter == 0);
+}
+
+TEST_CASE("thread_pool executor with strand and executor_work_guard", "[thread_pool][strand][executor_work_guard]")
+{
+	constexpr int NUMBER_OF_WORKS = 10000;
+
+	my_asio::thread_pool pool(4);
+	my_asio::strand<my_asio::thread_pool::executor_type> strand_(pool.get_executor());
+	auto work = my_asio::make_work_guard(pool.get_executor());
+	int counter(0);
+	std::atomic<bool> overlapped(false);
+	std::atomic<bool> inside(false);
+
+	for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+		my_asio::post(strand_, [&]() {
+			if (inside.exchange(true))
+				overlapped = true;
+			counter++;
+			inside = false;
+			});
+
+	// the pool's workers keep running for the guard after the strand has drained, until its last handler drops it
+	my_asio::post(strand_, [&work]() { work.reset(); });
+
+	pool.join();
+	REQUIRE(counter == NUMBER_OF_WORKS);
+	REQUIRE_FALSE(overlapped);
+	REQUIRE_FALSE(work.owns_work());
+}
+
+#if defined(__linux__)
+TEST_CASE("thread_pool pins its workers", "[thread_pool]")
+{
+	my_asio::thread_pool pool(2, my_asio::thread_affinity::core);
+	std::atomic<int> pinned(0);
+
+	for (size_t i = 0; i != pool.size(); ++i)
+		REQUIRE(pool.worker_cpus(i).size() == 1);
+
+	// each worker runs one handler, which waits until the other has started
+	std::atomic<int> started(0);
+	for (size_t i = 0; i != pool.size(); ++i)
+		my_asio::post(pool.get_executor(), [&]() {
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+			if (CPU_COUNT(&set) == 1)
+				pinned++;
+
+			started++;
+			while (started != 2)
+				std::this_thread::yield();
+			});
+
+	pool.join();
+	REQUIRE(pinned == 2);
+}
+#endif
+
+TEST_CASE("priority_executor orders queued handlers by weighted priority", "[priority_executor][post][io_context::run]")
+{
+	/*
+	with the default weights 8, 4 and 1, a round runs up to 8 high, 4 normal and 1 low handlers,
+	a priority with nothing queued gives its turn to the others
+	*/
+	constexpr int NUMBER_OF_WORKS = 20;
+
+	my_asio::io_context io;
+	const my_asio::priority_executor high = my_asio::make_priority_executor(io, my_asio::handler_priority::high);
+	const my_asio::priority_executor low = my_asio::make_priority_executor(io, my_asio::handler_priority::low);
+	std::vector<char> order;
+
+	for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+	{
+		my_asio::post(low, [&order]() { order.push_back('l'); });
+		my_asio::post(io, [&order]() { order.push_back('n'); });
+		my_asio::post(high, [&order]() { order.push_back('h'); });
+	}
+
+	io.run();
+
+	REQUIRE(order.size() == 3 * NUMBER_OF_WORKS);
+	REQUIRE(std::string(order.begin(), order.begin() + 13) == "hhhhhhhhnnnnl");
+	REQUIRE(std::string(order.begin() + 13, order.begin() + 26) == "hhhhhhhhnnnnl");
+
+	// once the high handlers are gone, normal and low share the rounds 4 to 1
+	REQUIRE(std::string(order.begin() + 26, order.begin() + 36) == "hhhhnnnnln");
+
+	SECTION("weights")
+	{
+		order.clear();
+		io.restart();
+		io.set_priority_weights(1, 1, 1);
+
+		for (int i = 0; i != 3; ++i)
+		{
+			my_asio::post(low, [&order]() { order.push_back('l'); });
+			my_asio::post(io, [&order]() { order.push_back('n'); });
+			my_asio::post(high, [&order]() { order.push_back('h'); });
+		}
+
+		io.run();
+		REQUIRE(std::string(order.begin(), order.end()) == "hnlhnlhnl");
+	}
+}
+
+TEST_CASE("priority_executor with strand and dispatch", "[priority_executor][strand][dispatch][io_context::run]")
+{
+	my_asio::io_context io;
+	my_asio::strand<my_asio::priority_executor> control(my_asio::make_priority_executor(io, my_asio::handler_priority::high));
+	std::vector<int> order;
+
+	for (int i = 0; i != 100; ++i)
+		my_asio::post(io, [&order]() { order.push_back(0); });
+
+	// the strand's turn is queued with high priority, dispatch from inside the strand runs inline
+	my_asio::post(control, [&order, &control]() {
+		order.push_back(1);
+		my_asio::dispatch(control, [&order]() { order.push_back(2); });
+		order.push_back(3);
+		});
+
+	io.run();
+
+	REQUIRE(order.size() == 103);
+	REQUIRE(order[0] == 1);
+	REQUIRE(order[1] == 2);
+	REQUIRE(order[2] == 3);
+}
+
+TEST_CASE("io_context queue limits", "[io_context][try_post][post_when_ready][io_context::run]")
+{
+	constexpr size_t CAPACITY = 10;
+
+	my_asio::io_context io;
+	std::vector<std::string> events;
+
+	my_asio::queue_limits limits;
+	limits.capacity = CAPACITY;
+	limits.high_watermark = 8;
+	limits.low_watermark = 2;
+	limits.on_high_watermark = [&events](size_t queued) { events.push_back("high " + std::to_string(queued)); };
+	limits.on_low_watermark = [&events](size_t queued) { events.push_back("low " + std::to_string(queued)); };
+	io.set_queue_limits(limits);
+
+	int counter = 0;
+	size_t accepted = 0;
+	for (int i = 0; i != 15; ++i)
+		if (my_asio::try_post(io, [&counter]() { ++counter; }))
+			++accepted;
+
+	REQUIRE(accepted == CAPACITY);
+	REQUIRE(io.queued_handlers() == CAPACITY);
+	REQUIRE(events == std::vector<std::string>{ "high 8" });
+
+	// post() is never refused, but counts
+	my_asio::post(io, [&counter]() { ++counter; });
+	REQUIRE(io.queued_handlers() == CAPACITY + 1);
+
+	// the waiting producer is admitted once a handler has started, try_post() does not overtake it
+	bool admitted = false;
+	my_asio::post_when_ready(io, [&counter]() { counter += 100; }, [&admitted](std::error_code ec) {
+		REQUIRE_FALSE(ec);
+		admitted = true;
+		});
+	REQUIRE_FALSE(my_asio::try_post(io, []() {}));
+
+	io.run();
+
+	REQUIRE(admitted);
+	REQUIRE(counter == int(CAPACITY) + 1 + 100);
+	REQUIRE(io.queued_handlers() == 0);
+	REQUIRE(events == std::vector<std::string>{ "high 8", "low 2" });
+
+	SECTION("raised capacity admits the waiting producers")
+	{
+		io.restart();
+		for (size_t i = 0; i != CAPACITY; ++i)
+			REQUIRE(my_asio::try_post(io, []() {}));
+
+		int waiters_admitted = 0;
+		for (int i = 0; i != 3; ++i)
+			my_asio::post_when_ready(io.get_executor(), []() {}, [&waiters_admitted](std::error_code) { ++waiters_admitted; });
+		REQUIRE(io.queued_handlers() == CAPACITY);
+
+		limits.capacity = CAPACITY + 3;
+		io.set_queue_limits(limits);
+		REQUIRE(io.queued_handlers() == CAPACITY + 3);
+
+		io.run();
+		REQUIRE(waiters_admitted == 3);
+		REQUIRE(io.queued_handlers() == 0);
+	}
+
+	SECTION("destroyed handlers release their slots")
+	{
+		// the queued handlers are destroyed after the waiter has been canceled, so it is not admitted
+		std::error_code result;
+		{
+			my_asio::io_context io2;
+			io2.set_queue_limits(limits);
+			for (size_t i = 0; i != CAPACITY; ++i)
+				REQUIRE(my_asio::try_post(io2, []() {}));
+			my_asio::post_when_ready(io2, []() {}, [&result](std::error_code ec) { result = ec; });
+		}
+		REQUIRE(result == std::errc::operation_canceled);
+	}
+}
+
+TEST_CASE("strand queue limits", "[strand][try_post][post_when_ready][io_context::run]")
+{
+	constexpr int NUMBER_OF_THREADS = 4;
+	constexpr int NUMBER_OF_PRODUCERS = 4;
+	constexpr int NUMBER_OF_WORKS = 1000;
+	constexpr size_t CAPACITY = 16;
+
+	my_asio::io_context io;
+	my_asio::strand<my_asio::io_context::executor_type> strand_(io.get_executor());
+
+	std::atomic<size_t> max_queued(0);
+	my_asio::queue_limits limits;
+	limits.capacity = CAPACITY;
+	strand_.set_queue_limits(limits);
+
+	// each producer posts its next handler when the previous one has been admitted
+	std::atomic<int> counter(0);
+	std::function<void(int)> produce = [&](int remaining) {
+		if (remaining == 0)
+			return;
+		strand_.post_when_ready([&]() {
+			++counter;
+			max_queued = std::max(max_queued.load(), strand_.queued_handlers());
+			}, [&produce, remaining](std::error_code) { produce(remaining - 1); });
+	};
+
+	for (int i = 0; i != NUMBER_OF_PRODUCERS; ++i)
+		my_asio::post(io, [&produce]() { produce(NUMBER_OF_WORKS); });
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i != NUMBER_OF_THREADS; ++i)
+		threads.emplace_back([&io]() { io.run(); });
+	for (auto& t : threads)
+		t.join();
+
+	REQUIRE(counter == NUMBER_OF_PRODUCERS * NUMBER_OF_WORKS);
+	REQUIRE(max_queued <= CAPACITY);
+	REQUIRE(strand_.queued_handlers() == 0);
+
+	io.restart();
+	size_t accepted = 0;
+	for (size_t i = 0; i != 2 * CAPACITY; ++i)
+		if (my_asio::try_post(strand_, []() {}))
+			++accepted;
+	REQUIRE(accepted == CAPACITY);
+	io.run();
+	REQUIRE(strand_.queued_handlers() == 0);
+}
+
+// keeps the handlers posted to it until the test runs or drops them
+struct recording_executor
+{
+	std::vector<my_asio::any_handler>* handlers;
+
+	template<typename Handler>
+	void post(Handler&& f) const
+	{
+		handlers->emplace_back(std::forward<Handler>(f));
+	}
+
+	template<typename Handler>
+	void dispatch(Handler&& f) const
+	{
+		post(std::forward<Handler>(f));
+	}
+
+	template<typename Handler>
+	void defer(Handler&& f) const
+	{
+		post(std::forward<Handler>(f));
+	}
+
+	void on_work_started() const {}
+
+	void on_work_finished() const {}
+
+	bool running_in_this_thread() const { return false; }
+};
+
+TEST_CASE("post_when_ready completes with operation_canceled when the owner is destroyed", "[io_context][strand][post_when_ready]")
+{
+	/*
+	a producer still waiting for room is completed with operation_canceled, its handler never runs
+	*/
+	my_asio::queue_limits limits;
+	limits.capacity = 1;
+
+	bool ran(false);
+	int completions(0);
+	std::error_code result;
+	auto completion = [&completions, &result](std::error_code ec) {
+		++completions;
+		result = ec;
+		};
+
+	SECTION("io_context")
+	{
+		auto io = std::make_unique<my_asio::io_context>();
+		io->set_queue_limits(limits);
+		my_asio::post(*io, []() {});
+		my_asio::post_when_ready(*io, [&ran]() { ran = true; }, completion);
+		REQUIRE(completions == 0);
+
+		// called by the destructor
+		io.reset();
+		REQUIRE(completions == 1);
+	}
+
+	SECTION("strand")
+	{
+		std::vector<my_asio::any_handler> posted;
+		auto strand_ = std::make_unique<my_asio::strand<recording_executor>>(recording_executor{ &posted });
+		strand_->set_queue_limits(limits);
+		my_asio::post(*strand_, []() {});
+		my_asio::post_when_ready(*strand_, [&ran]() { ran = true; }, completion);
+		REQUIRE(posted.size() == 1);
+
+		// posted to the inner executor, behind the turn of the strand, which is dropped
+		strand_.reset();
+		REQUIRE(posted.size() == 2);
+		REQUIRE(completions == 0);
+		posted[1]();
+		REQUIRE(completions == 1);
+	}
+
+	REQUIRE(ran == false);
+	REQUIRE(result == std::errc::operation_canceled);
+}
+
+TEST_CASE("call_stack finds every nested key", "[call_stack]")
+{
+	// more keys than the table has slots, so some of them share a slot
+	constexpr int NUMBER_OF_KEYS = 40;
+	using stack_type = my_asio::detail::call_stack<int, int>;
+
+	int keys[NUMBER_OF_KEYS];
+	int values[NUMBER_OF_KEYS];
+	std::vector<std::unique_ptr<stack_type::context>> contexts;
+
+	for (int i = 0; i != NUMBER_OF_KEYS; ++i)
+	{
+		contexts.emplace_back(new stack_type::context(&keys[i], &values[i]));
+		REQUIRE(stack_type::get_top() == &values[i]);
+		for (int j = 0; j != NUMBER_OF_KEYS; ++j)
+			REQUIRE(stack_type::contains(&keys[j]) == (j <= i ? &values[j] : nullptr));
+	}
+
+	// a key entered again is found at its innermost context until that is left
+	int inner_value = 0;
+	{
+		stack_type::context again(&keys[0], &inner_value);
+		REQUIRE(stack_type::contains(&keys[0]) == &inner_value);
+	}
+	REQUIRE(stack_type::contains(&keys[0]) == &values[0]);
+
+	while (!contexts.empty())
+	{
+		contexts.pop_back();
+		const int left = int(contexts.size());
+		REQUIRE(stack_type::get_top() == (left ? &values[left - 1] : nullptr));
+		for (int j = 0; j != NUMBER_OF_KEYS; ++j)
+			REQUIRE(stack_type::contains(&keys[j]) == (j < left ? &values[j] : nullptr));
+	}
+}
+
+TEST_CASE("io_context with concurrency hint 1", "[io_context][concurrency_hint][post][io_context::run]")
+{
+	constexpr int NUMBER_OF_PRODUCERS = 4;
+	constexpr int NUMBER_OF_WORKS = 10000;
+
+	my_asio::io_context io(1);
+	auto work = my_asio::make_work_guard(io.get_executor());
+
+	// each producer's handlers run in the order it posted them
+	std::vector<int> last_seen(NUMBER_OF_PRODUCERS, -1);
+	bool in_order = true;
+	int counter = 0;
+
+	std::vector<std::thread> producers;
+	for (int p = 0; p != NUMBER_OF_PRODUCERS; ++p)
+		producers.emplace_back([&, p]() {
+			for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+				my_asio::post(io, [&, p, i]() {
+					in_order = in_order && last_seen[p] == i - 1;
+					last_seen[p] = i;
+					++counter;
+					});
+			});
+
+	// handlers posted from inside handlers take the unlocked path
+	int chain = 0;
+	std::function<void()> next = [&]() {
+		if (++chain != NUMBER_OF_WORKS)
+			my_asio::post(io, next);
+	};
+	my_asio::post(io, next);
+
+	my_asio::steady_timer timer(io, std::chrono::milliseconds(5));
+	bool timer_expired = false;
+	timer.async_wait([&timer_expired](const std::error_code& ec) { timer_expired = !ec; });
+
+	std::thread releaser([&]() {
+		for (auto& t : producers)
+			t.join();
+		my_asio::post(io, [&work]() { work.reset(); });
+		});
+
+	io.run();
+	releaser.join();
+
+	REQUIRE(in_order);
+	REQUIRE(counter == NUMBER_OF_PRODUCERS * NUMBER_OF_WORKS);
+	REQUIRE(chain == NUMBER_OF_WORKS);
+	REQUIRE(timer_expired);
+	REQUIRE(io.stopped());
+
+	SECTION("strand and batches")
+	{
+		io.restart();
+		io.set_batch_size(16);
+		my_asio::strand<my_asio::io_context::executor_type> strand_(io.get_executor());
+		int strand_counter = 0;
+		for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+			my_asio::post(strand_, [&strand_counter]() { ++strand_counter; });
+
+		REQUIRE(io.poll() > 0);
+		REQUIRE(strand_counter == NUMBER_OF_WORKS);
+	}
+}
+
+TEST_CASE("continuation runs next on the deferring thread", "[io_context][defer][next_handler][io_context::run]")
+{
+	/*
+	a chain of single deferred continuations runs ahead of the queued handlers, up to the limit
+	in a row, then the next continuation is queued behind them
+	*/
+	constexpr int CHAIN_LENGTH = 20;
+
+	my_asio::io_context io;
+	io.enable_metrics();
+	std::string order;
+
+	std::function<void(int)> chain = [&](int remaining) {
+		order += 'c';
+		if (remaining)
+			my_asio::defer(io, [&chain, remaining]() { chain(remaining - 1); });
+	};
+
+	SECTION("default limit")
+	{
+		my_asio::post(io, [&chain]() { chain(CHAIN_LENGTH); });
+		for (int i = 0; i != 3; ++i)
+			my_asio::post(io, [&order]() { order += 'q'; });
+
+		io.run();
+
+		// the first link is queued like the others, then 8 continuations run in a row before the next one is queued
+		REQUIRE(order == "ccccccccc" "qqq" "cccccccccccc");
+
+		const my_asio::io_context_metrics metrics = io.metrics();
+		// every ninth continuation is queued, it runs right away once the queue is empty
+		REQUIRE(metrics.next_handler_hits == CHAIN_LENGTH - 2);
+		REQUIRE(metrics.next_handler_spills == 2);
+	}
+
+	SECTION("turned off")
+	{
+		io.set_next_handler_limit(0);
+		my_asio::post(io, [&chain]() { chain(3); });
+		for (int i = 0; i != 3; ++i)
+			my_asio::post(io, [&order]() { order += 'q'; });
+
+		io.run();
+
+		REQUIRE(order == "cqqqccc");
+		REQUIRE(io.metrics().next_handler_hits == 0);
+	}
+
+	SECTION("stop leaves the continuation queued")
+	{
+		my_asio::post(io, [&io, &order]() {
+			order += 'a';
+			my_asio::defer(io, [&order]() { order += 'b'; });
+			io.stop();
+			});
+
+		io.run();
+		REQUIRE(order == "a");
+
+		io.restart();
+		io.run();
+		REQUIRE(order == "ab");
+	}
+
+	SECTION("prioritized handlers run ahead of the continuation")
+	{
+		const my_asio::priority_executor high = my_asio::make_priority_executor(io, my_asio::handler_priority::high);
+		my_asio::post(io, [&io, &high, &order]() {
+			order += 'a';
+			my_asio::post(high, [&order]() { order += 'h'; });
+			my_asio::defer(io, [&order]() { order += 'b'; });
+			});
+
+		io.run();
+		REQUIRE(order == "ahb");
+		REQUIRE(io.metrics().next_handler_hits == 1);
+	}
+}
+
+TEST_CASE("continuations on several threads spill and requeue", "[io_context][defer][next_handler][io_context::run]")
+{
+	/*
+	the next handler slot belongs to the thread that ran the deferring handler. Every chain spills
+	once per limit continuations whichever thread picks the spilled one up, and a continuation
+	interrupted by stop() goes back ahead of the thread's interrupted batch
+	*/
+	constexpr int NUMBER_OF_WORKERS = 4;
+
+	my_asio::io_context io;
+	io.enable_metrics();
+
+	SECTION("spill")
+	{
+		constexpr int NUMBER_OF_CHAINS = 8;
+		constexpr int CHAIN_LENGTH = 100;
+		constexpr unsigned LIMIT = 3;
+
+		io.set_next_handler_limit(LIMIT);
+		std::atomic<int> counter(0);
+		std::function<void(int)> chain = [&](int remaining) {
+			counter++;
+			if (remaining)
+				my_asio::defer(io, [&chain, remaining]() { chain(remaining - 1); });
+		};
+
+		for (int i = 0; i != NUMBER_OF_CHAINS; ++i)
+			my_asio::post(io, [&chain]() { chain(CHAIN_LENGTH); });
+
+		std::vector<std::thread> workers;
+		for (int i = 0; i != NUMBER_OF_WORKERS; ++i)
+			workers.emplace_back([&io]() { io.run(); });
+		for (auto& t : workers)
+			t.join();
+
+		REQUIRE(counter == NUMBER_OF_CHAINS * (CHAIN_LENGTH + 1));
+
+		// of each limit + 1 continuations in a row, the last one is queued
+		const my_asio::io_context_metrics metrics = io.metrics();
+		REQUIRE(metrics.next_handler_hits + metrics.next_handler_spills == NUMBER_OF_CHAINS * CHAIN_LENGTH);
+		REQUIRE(metrics.next_handler_spills == NUMBER_OF_CHAINS * CHAIN_LENGTH / (LIMIT + 1));
+	}
+
+	SECTION("requeue")
+	{
+		io.set_batch_size(16);
+		std::atomic<bool> entered(false);
+		std::atomic<bool> release(false);
+		std::string order;
+
+		my_asio::post(io, [&entered, &release]() {
+			entered = true;
+			while (!release)
+				std::this_thread::yield();
+			});
+
+		std::vector<std::thread> workers;
+		for (int i = 0; i != 2; ++i)
+			workers.emplace_back([&io]() { io.run(); });
+		while (!entered)
+			std::this_thread::yield();
+
+		// the other thread takes both in one batch, q is still in it when h stops the context
+		std::vector<std::function<void()>> handlers;
+		handlers.push_back([&io, &order, &release]() {
+			order += 'h';
+			my_asio::defer(io, [&order]() { order += 'c'; });
+			io.stop();
+			release = true;
+			});
+		handlers.push_back([&order]() { order += 'q'; });
+		my_asio::post_bulk(io, std::move(handlers));
+
+		for (auto& t : workers)
+			t.join();
+		REQUIRE(order == "h");
+
+		io.restart();
+		io.run();
+		REQUIRE(order == "hcq");
+	}
+}
+
+TEST_CASE("strand_pool hands out copyable handles sharing its strands", "[strand][strand_pool][post][io_context::run]")
+{
+	/*
+	handles are copies of a pointer to one of the pool's strands. Handles of the same strand,
+	copies or not, serialize with each other, and a key always maps to the same strand
+	*/
+	constexpr int NUMBER_OF_HANDLES = 1'000;
+	constexpr int NUMBER_OF_WORKS = 20;
+	constexpr int NUMBER_OF_WORKERS = 4;
+
+	my_asio::io_context io;
+	my_asio::strand_pool<my_asio::io_context::executor_type> pool(io.get_executor(), 7);
+	REQUIRE(pool.size() == 7);
+	REQUIRE(sizeof(my_asio::pooled_strand<my_asio::io_context::executor_type>) == sizeof(void*));
+
+	SECTION("mapping")
+	{
+		auto a = pool.make_strand();
+		auto b = a;
+		REQUIRE(a == b);
+		for (int i = 0; i != 6; ++i)
+			REQUIRE(pool.make_strand() != a);
+		REQUIRE(pool.make_strand() == a);
+
+		REQUIRE(pool.make_strand(42) == pool.make_strand(42));
+		REQUIRE(&a.get_inner_executor().context() == &io);
+	}
+
+	SECTION("serialization")
+	{
+		std::vector<my_asio::pooled_strand<my_asio::io_context::executor_type>> handles;
+		for (int i = 0; i != NUMBER_OF_HANDLES; ++i)
+			handles.push_back(pool.make_strand(i));
+
+		std::vector<std::atomic<int>> in_flight(pool.size());
+		std::atomic<bool> overlapped(false);
+		std::atomic<bool> outside(false);
+		std::atomic<bool> in_order(true);
+		std::vector<int> last_seen(NUMBER_OF_HANDLES, -1);
+
+		// the handles of one strand share its in_flight counter
+		std::vector<size_t> strand_of(NUMBER_OF_HANDLES);
+		std::vector<my_asio::pooled_strand<my_asio::io_context::executor_type>> distinct;
+		for (int h = 0; h != NUMBER_OF_HANDLES; ++h)
+		{
+			size_t s = 0;
+			while (s != distinct.size() && distinct[s] != handles[h])
+				++s;
+			if (s == distinct.size())
+				distinct.push_back(handles[h]);
+			strand_of[h] = s;
+		}
+		REQUIRE(distinct.size() == pool.size());
+
+		for (int i = 0; i != NUMBER_OF_WORKS; ++i)
+			for (int h = 0; h != NUMBER_OF_HANDLES; ++h)
+			{
+				const auto handle = handles[h];
+				my_asio::post(handle, [&, handle, h, i]() {
+					if (in_flight[strand_of[h]]++ != 0)
+						overlapped = true;
+					if (!handle.running_in_this_thread() || !distinct[strand_of[h]].running_in_this_thread())
+						outside = true;
+					if (last_seen[h] != i - 1)
+						in_order = false;
+					last_seen[h] = i;
+					in_flight[strand_of[h]]--;
+					});
+			}
+
+		std::vector<std::thread> workers;
+		for (int i = 0; i != NUMBER_OF_WORKERS; ++i)
+			workers.emplace_back([&io]() { io.run(); });
+		for (auto& t : workers)
+			t.join();
+
+		REQUIRE(overlapped == false);
+		REQUIRE(outside == false);
+		REQUIRE(in_order == true);
+		for (int h = 0; h != NUMBER_OF_HANDLES; ++h)
+			REQUIRE(last_seen[h] == NUMBER_OF_WORKS - 1);
+		REQUIRE(pool.stats().handlers == size_t(NUMBER_OF_HANDLES) * NUMBER_OF_WORKS);
+	}
+
+	SECTION("dispatch and bind_executor")
+	{
+		auto a = pool.make_strand();
+		auto b = a;
+		std::string order;
+		my_asio::post(a, [&]() {
+			// inside a's strand a copy dispatches inline
+			my_asio::dispatch(b, [&order]() { order += 'd'; });
+			order += 'p';
+			});
+		my_asio::post(io, my_asio::bind_executor(b, [&order, b]() {
+			REQUIRE(b.running_in_this_thread());
+			order += 'b';
+			}));
+
+		io.run();
+		REQUIRE(order == "dpb");
+	}
+}
+
+
+TEST_CASE("timer wheel expires entries on time across all levels", "[steady_timer][timer_wheel]")
+{
+	/*
+	entries spread from microseconds to days are checked after every advance: none expires early,
+	none is left behind once its expiry has passed, and they come out in expiry order
+	*/
+	constexpr int NUMBER_OF_ENTRIES = 2000;
+
+	using clock = std::chrono::steady_clock;
+
+	struct test_entry : my_asio::detail::timer_wheel::entry
+	{
+		clock::time_point expiry;
+		bool expired = false;
+	};
+
+	my_asio::detail::timer_wheel wheel;
+	std::vector<test_entry> entries(NUMBER_OF_ENTRIES);
+	std::mt19937_64 random(42);
+
+	const clock::time_point start = clock::now();
+	for (test_entry& e : entries)
+	{
+		const int magnitude = int(random() % 38);
+		e.expiry = start + std::chrono::microseconds(random() % (1ull << magnitude) + 1);
+		wheel.schedule(e, e.expiry);
+	}
+
+	// every fourth entry is cancelled
+	for (int i = 0; i < NUMBER_OF_ENTRIES; i += 4)
+		wheel.cancel(entries[i]);
+	REQUIRE(wheel.size() == NUMBER_OF_ENTRIES - NUMBER_OF_ENTRIES / 4);
+
+	bool on_time = true;
+	bool in_order = true;
+	clock::time_point now = start;
+	clock::time_point last_expired = start;
+	while (!wheel.empty())
+	{
+		now += std::chrono::microseconds(1ull << (random() % 36));
+		wheel.advance(now, [&](my_asio::detail::timer_wheel::entry& base) {
+			test_entry& e = static_cast<test_entry&>(base);
+			on_time = on_time && e.expiry <= now;
+			in_order = in_order && e.expiry >= last_expired;
+			last_expired = e.expiry;
+			e.expired = true;
+			});
+
+		// nothing to do until the next event
+		on_time = on_time && wheel.next_event() > now;
+		for (int i = 1; i < NUMBER_OF_ENTRIES; ++i)
+			if (i % 4 != 0 && !entries[i].expired)
+				on_time = on_time && entries[i].expiry > now;
+	}
+
+	REQUIRE(on_time == true);
+	REQUIRE(in_order == true);
+	for (int i = 0; i < NUMBER_OF_ENTRIES; ++i)
+		REQUIRE(entries[i].expired == (i % 4 != 0));
+}
+
+TEST_CASE("steady_timer async_wait", "[steady_timer][io_context][io_context::run]")
+{
+	my_asio::io_context io;
+	my_asio::steady_timer timer(io, std::chrono::milliseconds(20));
+	std::error_code result = std::make_error_code(std::errc::interrupted);
+	std::chrono::steady_clock::time_point fired;
+
+	timer.async_wait([&result, &fired](const std::error_code& ec) {
+		result = ec;
+		fired = std::chrono::steady_clock::now();
+		});
+
+	// the pending wait keeps run() going until the timer expires
+	REQUIRE(io.run() == 1);
+	REQUIRE(!result);
+	REQUIRE(fired >= timer.expiry());
+}
+
+TEST_CASE("steady_timer fires while handlers keep the queue busy", "[steady_timer][io_context][io_context::run]")
+{
+	/*
+	the timers are checked every few handlers, not only when the queue runs dry
+	*/
+	my_asio::io_context io;
+	my_asio::steady_timer timer(io, std::chrono::milliseconds(5));
+	bool fired(false);
+	size_t handlers_after_expiry(0);
+
+	timer.async_wait([&fired](const std::error_code&) { fired = true; });
+
+	std::function<void()> busy = [&]() {
+		if (fired)
+			return;
+		if (std::chrono::steady_clock::now() >= timer.expiry())
+			++handlers_after_expiry;
+		my_asio::post(io, busy);
+		};
+	my_asio::post(io, busy);
+
+	io.run();
+
+	REQUIRE(fired == true);
+	REQUIRE(handlers_after_expiry <= 32);
+}
+
+TEST_CASE("steady_timer cancel", "[steady_timer][io_context][io_context::run]")
+{
+	my_asio::io_context io;
+	my_asio::steady_timer timer(io);
+	std::vector<std::error_code> results;
+
+	SECTION("cancel")
+	{
+		timer.expires_after(std::chrono::hours(1));
+		timer.async_wait([&results](const std::error_code& ec) { results.push_back(ec); });
+		timer.async_wait([&results](const std::error_code& ec) { results.push_back(ec); });
+
+		REQUIRE(timer.cancel() == 2);
+		REQUIRE(timer.cancel() == 0);
+	}
+
+	SECTION("expires_after cancels the pending waits")
+	{
+		timer.expires_after(std::chrono::hours(1));
+		timer.async_wait([&results](const std::error_code& ec) { results.push_back(ec); });
+
+		REQUIRE(timer.expires_after(std::chrono::milliseconds(1)) == 1);
+		timer.async_wait([&results](const std::error_code& ec) { results.push_back(ec); });
+	}
+
+	SECTION("cancel from a handler")
+	{
+		timer.expires_after(std::chrono::hours(1));
+		timer.async_wait([&results](const std::error_code& ec) { results.push_back(ec); });
+		timer.async_wait([&results](const std::error_code& ec) { results.push_back(ec); });
+
+		my_asio::post(io, [&timer]() { timer.cancel(); });
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	io.run();
+
+	REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::minutes(1));
+	REQUIRE(results.size() >= 1);
+	REQUIRE(results[0] == std::errc::operation_canceled);
+	if (results.size() == 2 && timer.expiry() < std::chrono::steady_clock::now())
+		REQUIRE(!results[1]);
+}
+
+TEST_CASE("steady_timers fire in expiry order", "[steady_timer][io_context][io_context::run]")
+{
+	my_asio::io_context io;
+	std::vector<std::unique_ptr<my_asio::steady_timer>> timers;
+	std::vector<int> order;
+
+	for (int ms : { 50, 10, 30, 1, 20, 40 })
+	{
+		timers.emplace_back(new my_asio::steady_timer(io, std::chrono::milliseconds(ms)));
+		timers.back()->async_wait([&order, ms](const std::error_code&) { order.push_back(ms); });
+	}
+
+	io.run();
+
+	REQUIRE(order == std::vector<int>{ 1, 10, 20, 30, 40, 50 });
+}
+
+TEST_CASE("steady_timers with several threads running", "[steady_timer][io_context][io_context::run]")
+{
+	/*
+	the idle threads sleep until the next expiry, a timer armed with an earlier expiry
+	while they sleep must still fire on time
+	*/
+	constexpr int NUMBER_OF_TIMERS = 200;
+	constexpr int NUMBER_OF_WORKERS = 4;
+
+	my_asio::io_context io;
+	std::vector<std::unique_ptr<my_asio::steady_timer>> timers;
+	std::atomic<int> fired(0);
+	std::atomic<int> early(0);
+
+	my_asio::steady_timer late(io, std::chrono::milliseconds(100));
+	late.async_wait([&fired](const std::error_code&) { fired++; });
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != NUMBER_OF_WORKERS; ++i)
+		workers.emplace_back([&io]() { io.run(); });
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	for (int i = 0; i != NUMBER_OF_TIMERS; ++i)
+	{
+		timers.emplace_back(new my_asio::steady_timer(io, std::chrono::microseconds(100 * (i % 50))));
+		const auto expiry = timers.back()->expiry();
+		timers.back()->async_wait([&fired, &early, expiry](const std::error_code& ec) {
+			if (ec || std::chrono::steady_clock::now() < expiry)
+				early++;
+			fired++;
+			});
+	}
+
+	for (auto& t : workers)
+		t.join();
+
+	REQUIRE(fired == NUMBER_OF_TIMERS + 1);
+	REQUIRE(early == 0);
+}
+
+#if defined(MY_ASIO_HAS_EPOLL)
+
+/*
+echoes everything it reads on the socket until the peer closes the connection
+*/
+struct echo_session : std::enable_shared_from_this<echo_session>
+{
+	explicit echo_session(my_asio::io_context& io)
+		: socket(io)
+	{	}
+
+	void read()
+	{
+		auto self = shared_from_this();
+		socket.async_read_some(my_asio::buffer(data), [self](const std::error_code& ec, size_t bytes) {
+			if (!ec)
+				self->write(bytes);
+			});
+	}
+
+	void write(size_t bytes)
+	{
+		auto self = shared_from_this();
+		socket.async_write_some(my_asio::buffer(data, bytes), [self](const std::error_code& ec, size_t) {
+			if (!ec)
+				self->read();
+			});
+	}
+
+	my_asio::ip::tcp::socket socket;
+	char data[1024];
+};
+
+TEST_CASE("tcp echo over loopback", "[tcp][io_context][io_context::run]")
+{
+	for (my_asio::io_backend backend : { my_asio::io_backend::epoll, my_asio::io_backend::io_uring })
+	{
+		my_asio::io_context io(backend);
+		my_asio::ip::tcp::acceptor acceptor(io, my_asio::ip::tcp::endpoint("127.0.0.1", 0));
+		auto session = std::make_shared<echo_session>(io);
+		std::error_code accept_result = std::make_error_code(std::errc::interrupted);
+
+		acceptor.async_accept(session->socket, [&accept_result, session](const std::error_code& ec) {
+			accept_result = ec;
+			if (!ec)
+				session->read();
+			});
+		session.reset();
+
+		my_asio::ip::tcp::socket client(io);
+		client.connect(acceptor.local_endpoint());
+
+		const std::string message = "hello, echo";
+		std::string reply(message.size(), '\0');
+		std::error_code eof_result;
+
+		client.async_write_some(my_asio::buffer(message), [&](const std::error_code& ec, size_t bytes) {
+			REQUIRE(!ec);
+			REQUIRE(bytes == message.size());
+			client.async_read_some(my_asio::buffer(reply), [&](const std::error_code& ec, size_t bytes) {
+				REQUIRE(!ec);
+				REQUIRE(bytes == message.size());
+				client.close();
+				});
+			});
+
+		// run() returns once the client has closed and the session has seen the end of the stream
+		io.run();
+
+		REQUIRE(!accept_result);
+		REQUIRE(reply == message);
+	}
+}
+
+TEST_CASE("tcp read of a closed connection fails with eof", "[tcp][io_context][io_context::run]")
+{
+	for (my_asio::io_backend backend : { my_asio::io_backend::epoll, my_asio::io_backend::io_uring })
+	{
+		my_asio::io_context io(backend);
+		my_asio::ip::tcp::acceptor acceptor(io, my_asio::ip::tcp::endpoint("127.0.0.1", 0));
+		my_asio::ip::tcp::socket server(io);
+		my_asio::ip::tcp::socket client(io);
+		char data[16];
+		std::error_code result;
+
+		acceptor.async_accept(server, [&](const std::error_code& ec) {
+			REQUIRE(!ec);
+			server.async_read_some(my_asio::buffer(data), [&result](const std::error_code& ec, size_t) {
+				result = ec;
+				});
+			});
+
+		client.connect(acceptor.local_endpoint());
+		client.close();
+
+		io.run();
+
+		REQUIRE(result == my_asio::error::eof);
+	}
+}
+
+TEST_CASE("tcp close cancels pending operations", "[tcp][io_context][io_context::run][io_context::poll]")
+{
+	my_asio::io_context io;
+	my_asio::ip::tcp::acceptor acceptor(io, my_asio::ip::tcp::endpoint("127.0.0.1", 0));
+	my_asio::ip::tcp::socket peer(io);
+	std::vector<std::error_code> results;
+
+	acceptor.async_accept(peer, [&results](const std::error_code& ec) { results.push_back(ec); });
+
+	SECTION("close")
+	{
+		REQUIRE(io.poll() == 0);
+		REQUIRE(io.stopped() == false);
+
+		acceptor.close();
+	}
+
+	SECTION("cancel")
+	{
+		REQUIRE(acceptor.cancel() == 1);
+	}
+
+	SECTION("close from a handler")
+	{
+		my_asio::post(io, [&acceptor]() { acceptor.close(); });
+	}
+
+	io.restart();
+	io.run();
+
+	REQUIRE(results.size() == 1);
+	REQUIRE(results[0] == std::errc::operation_canceled);
+	REQUIRE(peer.is_open() == false);
+}
+
+TEST_CASE("tcp close cancels pending operations with io_uring", "[tcp][io_context][io_context::run][io_context::poll]")
+{
+	my_asio::io_context io(my_asio::io_backend::io_uring);
+	my_asio::ip::tcp::acceptor acceptor(io, my_asio::ip::tcp::endpoint("127.0.0.1", 0));
+	my_asio::ip::tcp::socket peer(io);
+	std::vector<std::error_code> results;
+
+	acceptor.async_accept(peer, [&results](const std::error_code& ec) { results.push_back(ec); });
+
+	SECTION("close")
+	{
+		REQUIRE(io.poll() == 0);
+		REQUIRE(io.stopped() == false);
+
+		acceptor.close();
+	}
+
+	SECTION("cancel")
+	{
+		REQUIRE(acceptor.cancel() == 1);
+	}
+
+	SECTION("close from a handler")
+	{
+		my_asio::post(io, [&acceptor]() { acceptor.close(); });
+	}
+
+	io.restart();
+	io.run();
+
+	REQUIRE(results.size() == 1);
+	REQUIRE(results[0] == std::errc::operation_canceled);
+	REQUIRE(peer.is_open() == false);
+}
+
+TEST_CASE("io_context io_backend", "[tcp][io_context]")
+{
+	REQUIRE(my_asio::io_context().io_backend_in_use() == my_asio::io_backend::epoll);
+	REQUIRE(my_asio::io_context(my_asio::scheduler_mode::work_stealing).io_backend_in_use() == my_asio::io_backend::epoll);
+
+	// io_uring where the kernel provides it, epoll otherwise. The choice is made by the constructor
+	my_asio::io_context io(my_asio::io_backend::io_uring);
+	const my_asio::io_backend in_use = io.io_backend_in_use();
+
+	my_asio::ip::tcp::acceptor acceptor(io, my_asio::ip::tcp::endpoint("127.0.0.1", 0));
+	REQUIRE(io.io_backend_in_use() == in_use);
+}
+
+TEST_CASE("tcp completions bound to a strand", "[tcp][strand][io_context][io_context::run]")
+{
+	/*
+	several connections are served by NUMBER_OF_WORKERS threads, the completions of all of
+	them go through one strand and never overlap
+	*/
+	for (my_asio::io_backend backend : { my_asio::io_backend::epoll, my_asio::io_backend::io_uring })
+	{
+		constexpr int NUMBER_OF_CONNECTIONS = 8;
+		constexpr int NUMBER_OF_MESSAGES = 100;
+		constexpr int NUMBER_OF_WORKERS = 4;
+
+		struct connection
+		{
+			explicit connection(my_asio::io_context& io)
+				: client(io)
+				, server(io)
+			{	}
+
+			my_asio::ip::tcp::socket client;
+			my_asio::ip::tcp::socket server;
+			char client_data = 0;
+			char server_data = 0;
+			int messages = 0;
+		};
+
+		my_asio::io_context io(backend);
+		my_asio::strand<my_asio::io_context::executor_type> strand_(io.get_executor());
+		my_asio::ip::tcp::acceptor acceptor(io, my_asio::ip::tcp::endpoint("127.0.0.1", 0));
+		std::vector<std::unique_ptr<connection>> connections;
+		std::atomic<int> in_flight(0);
+		std::atomic<bool> overlapped(false);
+		int completed(0);
+
+		std::function<void(connection&)> ping = [&](connection& c) {
+			c.client.async_write_some(my_asio::buffer(&c.client_data, 1), my_asio::bind_executor(strand_, [&](const std::error_code& ec, size_t) {
+				REQUIRE(!ec);
+				c.client.async_read_some(my_asio::buffer(&c.client_data, 1), my_asio::bind_executor(strand_, [&](const std::error_code& ec, size_t) {
+					if (in_flight++ != 0)
+						overlapped = true;
+					REQUIRE(!ec);
+					if (++c.messages == NUMBER_OF_MESSAGES)
+					{
+						c.client.close();
+						++completed;
+					}
+					else
+					{
+						ping(c);
+					}
+					in_flight--;
+					}));
+				}));
+			};
+
+		std::function<void(connection&)> pong = [&](connection& c) {
+			c.server.async_read_some(my_asio::buffer(&c.server_data, 1), [&](const std::error_code& ec, size_t) {
+				if (ec)
+					return;
+				c.server.async_write_some(my_asio::buffer(&c.server_data, 1), [&](const std::error_code& ec, size_t) {
+					if (!ec)
+						pong(c);
+					});
+				});
+			};
+
+		for (int i = 0; i != NUMBER_OF_CONNECTIONS; ++i)
+		{
+			connections.emplace_back(new connection(io));
+			connection& c = *connections.back();
+			acceptor.async_accept(c.server, [&](const std::error_code& ec) {
+				REQUIRE(!ec);
+				pong(c);
+				});
+			c.client.connect(acceptor.local_endpoint());
+			ping(c);
+		}
+
+		std::vector<std::thread> workers;
+		for (int i = 0; i != NUMBER_OF_WORKERS; ++i)
+			workers.emplace_back([&io]() { io.run(); });
+		for (auto& t : workers)
+			t.join();
+
+		REQUIRE(overlapped == false);
+		REQUIRE(completed == NUMBER_OF_CONNECTIONS);
+	}
+}
+
+#endif // defined(MY_ASIO_HAS_EPOLL)
+
+#if defined(MY_ASIO_HAS_CO_AWAIT)
+
+my_asio::awaitable<int> add_one(int value)
+{
+	co_return value + 1;
+}
+
+my_asio::awaitable<int> add_chain(int depth)
+{
+	int value = 0;
+	for (int i = 0; i != depth; ++i)
+		value = co_await add_one(value);
+	co_return value;
+}
+
+my_asio::awaitable<void> throw_after(my_asio::steady_timer& timer)
+{
+	co_await timer.async_wait(my_asio::use_awaitable);
+	throw std::runtime_error("after the wait");
+}
+
+TEST_CASE("co_spawn awaitable chain", "[awaitable][io_context][io_context::run]")
+{
+	my_asio::io_context io;
+	int result = 0;
+	std::exception_ptr error;
+
+	SECTION("value")
+	{
+		my_asio::co_spawn(io.get_executor(), add_chain(1000), [&](std::exception_ptr e, int value) {
+			error = e;
+			result = value;
+			});
+		io.run();
+
+		REQUIRE(!error);
+		REQUIRE(result == 1000);
+	}
+
+	SECTION("exception")
+	{
+		my_asio::steady_timer timer(io, std::chrono::milliseconds(1));
+		my_asio::co_spawn(io.get_executor(), throw_after(timer), [&](std::exception_ptr e) { error = e; });
+		io.run();
+
+		REQUIRE_THROWS_AS(std::rethrow_exception(error), std::runtime_error);
+	}
+
+	SECTION("detached")
+	{
+		my_asio::co_spawn(io.get_executor(), add_chain(10), my_asio::detached);
+		REQUIRE(io.run() == 2);
+	}
+}
+
+my_asio::awaitable<void> wait_cancelled(my_asio::steady_timer& timer, std::error_code& result)
+{
+	try
+	{
+		co_await timer.async_wait(my_asio::use_awaitable);
+	}
+	catch (const std::system_error& e)
+	{
+		result = e.code();
+	}
+}
+
+TEST_CASE("co_await steady_timer", "[awaitable][steady_timer][io_context::run]")
+{
+	my_asio::io_context io;
+	my_asio::steady_timer timer(io, std::chrono::hours(1));
+	std::error_code result;
+
+	my_asio::co_spawn(io.get_executor(), wait_cancelled(timer, result), my_asio::detached);
+	my_asio::post(io, [&timer]() { timer.cancel(); });
+	io.run();
+
+	REQUIRE(result == std::errc::operation_canceled);
+}
+
+template<typename Strand>
+my_asio::awaitable<void> count_in_strand(my_asio::io_context& io, Strand& strand_, int& counter, std::atomic<bool>& outside)
+{
+	for (int i = 0; i != 1000; ++i)
+	{
+		// resumes inside the strand, then leaves it again
+		co_await my_asio::post(strand_, my_asio::use_awaitable);
+		if (!strand_.running_in_this_thread())
+			outside = true;
+		++counter;
+		co_await my_asio::post(io.get_executor(), my_asio::use_awaitable);
+	}
+}
+
+TEST_CASE("co_await post to a strand", "[awaitable][strand][io_context::run]")
+{
+	constexpr int NUMBER_OF_COROUTINES = 8;
+	constexpr int NUMBER_OF_WORKERS = 4;
+
+	my_asio::io_context io;
+	my_asio::strand<my_asio::io_context::executor_type> strand_(io.get_executor());
+	int counter = 0;
+	std::atomic<bool> outside(false);
+
+	for (int i = 0; i != NUMBER_OF_COROUTINES; ++i)
+		my_asio::co_spawn(io.get_executor(), count_in_strand(io, strand_, counter, outside), my_asio::detached);
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i != NUMBER_OF_WORKERS; ++i)
+		workers.emplace_back([&io]() { io.run(); });
+	for (auto& t : workers)
+		t.join();
+
+	REQUIRE(outside == false);
+	REQUIRE(counter == NUMBER_OF_COROUTINES * 1000);
+}
+
+#if defined(MY_ASIO_HAS_EPOLL)
+
+my_asio::awaitable<void> echo_once(my_asio::ip::tcp::acceptor& acceptor, my_asio::ip::tcp::socket& server)
+{
+	co_await acceptor.async_accept(server, my_asio::use_awaitable);
+
+	char data[64];
+	for (;;)
+	{
+		const size_t bytes = co_await server.async_read_some(my_asio::buffer(data), my_asio::use_awaitable);
+		co_await server.async_write_some(my_asio::buffer(data, bytes), my_asio::use_awaitable);
+	}
+}
+
+my_asio::awaitable<std::string> ask(my_asio::ip::tcp::socket& client, std::string message)
+{
+	std::string reply(message.size(), '\0');
+	co_await client.async_write_some(my_asio::buffer(message), my_asio::use_awaitable);
+
+	size_t received = 0;
+	while (received != reply.size())
+		received += co_await client.async_read_some(my_asio::buffer(&reply[received], reply.size() - received), my_asio::use_awaitable);
+
+	client.close();
+	co_return reply;
+}
+
+TEST_CASE("co_await tcp operations", "[awaitable][tcp][io_context::run]")
+{
+	for (my_asio::io_backend backend : { my_asio::io_backend::epoll, my_asio::io_backend::io_uring })
+	{
+		my_asio::io_context io(backend);
+		my_asio::strand<my_asio::io_context::executor_type> strand_(io.get_executor());
+		my_asio::ip::tcp::acceptor acceptor(io, my_asio::ip::tcp::endpoint("127.0.0.1", 0));
+		my_asio::ip::tcp::socket server(io);
+		my_asio::ip::tcp::socket client(io);
+		std::exception_ptr server_error;
+		std::string reply;
+
+		// the server ends with eof once the client has closed
+		my_asio::co_spawn(strand_, echo_once(acceptor, server), [&](std::exception_ptr e) { server_error = e; });
+
+		client.connect(acceptor.local_endpoint());
+		my_asio::co_spawn(io.get_executor(), ask(client, "hello, coroutine"), [&](std::exception_ptr e, std::string value) {
+			REQUIRE(!e);
+			reply = value;
+			});
+
+		io.run();
+
+		REQUIRE(reply == "hello, coroutine");
+		try
+		{
+			std::rethrow_exception(server_error);
+		}
+		catch (const std::system_error& e)
+		{
+			REQUIRE(e.code() == my_asio::error::eof);
+		}
+	}
+}
+
+#endif // defined(MY_ASIO_HAS_EPOLL)
+
+my_asio::awaitable<void> produce_when_ready(my_asio::io_context& io, int& counter, int count)
+{
+	for (int i = 0; i != count; ++i)
+		co_await my_asio::post_when_ready(io, [&counter]() { ++counter; }, my_asio::use_awaitable);
+}
+
+TEST_CASE("co_await post_when_ready", "[awaitable][post_when_ready][io_context::run]")
+{
+	my_asio::io_context io;
+	my_asio::queue_limits limits;
+	limits.capacity = 4;
+	io.set_queue_limits(limits);
+
+	int counter = 0;
+	my_asio::co_spawn(io.get_executor(), produce_when_ready(io, counter, 1000), my_asio::detached);
+	io.run();
+
+	REQUIRE(counter == 1000);
+	REQUIRE(io.queued_handlers() == 0);
+}
+
+my_asio::awaitable<void> wait_until_canceled(my_asio::io_context& io, std::error_code& result)
+{
+	try
+	{
+		co_await my_asio::post_when_ready(io, []() {}, my_asio::use_awaitable);
+	}
+	catch (const std::system_error& e)
+	{
+		result = e.code();
+	}
+}
+
+TEST_CASE("co_await post_when_ready resumes when the io_context is destroyed", "[awaitable][post_when_ready][io_context::run]")
+{
+	/*
+	the coroutine waiting for room on a destroyed io_context resumes on its own executor and
+	sees operation_canceled, rather than staying suspended forever
+	*/
+	my_asio::io_context io;
+	auto full = std::make_unique<my_asio::io_context>();
+	my_asio::queue_limits limits;
+	limits.capacity = 1;
+	full->set_queue_limits(limits);
+	my_asio::post(*full, []() {});
+
+	std::error_code result;
+	bool finished(false);
+	my_asio::co_spawn(io.get_executor(), wait_until_canceled(*full, result), [&finished](std::exception_ptr) { finished = true; });
+	io.poll();
+	io.restart();
+	REQUIRE(finished == false);
+
+	full.reset();
+	io.poll();
+
+	REQUIRE(finished == true);
+	REQUIRE(result == std::errc::operation_canceled);
+}
+
+#endif // defined(MY_ASIO_HAS_CO_AWAIT)
\ No newline at end of file